@@ -0,0 +1,265 @@
+// Micro-benchmarks for the audio conversion stages used before upload.
+// Single-threaded; results are per core. Build with -DBUILD_BENCHMARKS=ON.
+
+#include "Resampler.h"
+#include "SampleConversion.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+const double SECONDS_OF_AUDIO = 60.0;
+const int REPETITIONS = 5;
+
+// The decimation AudioConverter::Downsample used before the polyphase resampler
+std::vector<int16_t> LegacyDecimate(const std::vector<int16_t>& input, int inputRate, int outputRate) {
+    float ratio = static_cast<float>(inputRate) / outputRate;
+    size_t outputSamples = static_cast<size_t>(input.size() / ratio);
+    std::vector<int16_t> output(outputSamples);
+    for (size_t i = 0; i < outputSamples; ++i) {
+        size_t inputIndex = static_cast<size_t>(i * ratio);
+        if (inputIndex < input.size()) {
+            output[i] = input[inputIndex];
+        }
+    }
+    return output;
+}
+
+std::vector<int16_t> MakeSpeechLikeSignal(uint32_t sampleRate, size_t samples) {
+    std::vector<int16_t> signal(samples);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < samples; ++i) {
+        double t = static_cast<double>(i) / sampleRate;
+        noise = noise * 1664525u + 1013904223u;
+        double value = 0.4 * std::sin(2.0 * 3.14159265358979 * 220.0 * t) +
+                       0.2 * std::sin(2.0 * 3.14159265358979 * 3100.0 * t) +
+                       0.05 * (static_cast<int32_t>(noise >> 16) - 32768) / 32768.0;
+        signal[i] = static_cast<int16_t>(value * 32767.0);
+    }
+    return signal;
+}
+
+template <typename Function>
+double BestSeconds(Function function) {
+    double best = 1e9;
+    for (int i = 0; i < REPETITIONS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+void Report(const std::string& name, double seconds, size_t inputSamples) {
+    std::printf("  %-34s %9.1f Msamples/s %10.0fx realtime\n",
+                name.c_str(), inputSamples / seconds / 1e6, SECONDS_OF_AUDIO / seconds);
+}
+
+void BenchmarkResampling(uint32_t inputRate) {
+    const uint32_t outputRate = 16000;
+    const size_t total = static_cast<size_t>(inputRate * SECONDS_OF_AUDIO);
+    const size_t chunk = inputRate;  // Provider converts one second at a time
+    std::vector<int16_t> signal = MakeSpeechLikeSignal(inputRate, total);
+
+    std::printf("%u Hz -> %u Hz mono int16, %.0f s of audio in 1 s chunks\n", inputRate, outputRate, SECONDS_OF_AUDIO);
+
+    size_t sink = 0;
+    double legacy = BestSeconds([&] {
+        for (size_t offset = 0; offset < total; offset += chunk) {
+            std::vector<int16_t> block(signal.begin() + offset, signal.begin() + offset + chunk);
+            sink += LegacyDecimate(block, inputRate, outputRate).size();
+        }
+    });
+    Report("legacy decimation", legacy, total);
+
+    PolyphaseResampler resampler(inputRate, outputRate);
+    std::vector<int16_t> output(resampler.MaxOutputSamples(chunk));
+    double polyphase = BestSeconds([&] {
+        for (size_t offset = 0; offset < total; offset += chunk) {
+            sink += resampler.Process(signal.data() + offset, chunk, output.data());
+        }
+    });
+    Report("polyphase FIR (streaming)", polyphase, total);
+
+    if (sink == 0) {
+        std::printf("unexpected: no output\n");
+    }
+}
+
+std::vector<float> MakeFloatStereo(size_t samples) {
+    std::vector<float> signal(samples);
+    uint32_t noise = 777;
+    for (size_t i = 0; i < samples; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        // Slightly over full scale so the clamp is exercised
+        signal[i] = (static_cast<int32_t>(noise >> 8) - 8388608) / 7000000.0f;
+    }
+
+    // Edge cases the kernels must agree on
+    const float specials[] = {
+        1.0f, -1.0f, 0.0f, -0.0f, 1.5f, -1.5f, 0.99999994f, -0.99999994f,
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::denorm_min(),
+        0.5f / 32767.0f, -0.5f / 32767.0f, 1.0f / 32767.0f, -1.0f / 32767.0f
+    };
+    for (size_t i = 0; i < sizeof(specials) / sizeof(specials[0]) && i < samples; ++i) {
+        signal[i * 7 % samples] = specials[i];
+    }
+    return signal;
+}
+
+void BenchmarkSampleConversion() {
+    using SampleConversion::InstructionSet;
+    const size_t frames = static_cast<size_t>(48000 * SECONDS_OF_AUDIO);
+    const size_t chunk = 48000 * 2;  // One second of interleaved stereo
+    std::vector<float> input = MakeFloatStereo(frames * 2);
+
+    std::printf("48000 Hz stereo float -> int16, %.0f s of audio in 1 s chunks\n", SECONDS_OF_AUDIO);
+
+    std::vector<InstructionSet> supported = {InstructionSet::Scalar};
+    InstructionSet best = SampleConversion::DetectInstructionSet();
+    if (best == InstructionSet::SSE2 || best == InstructionSet::AVX2) {
+        supported.push_back(InstructionSet::SSE2);
+    }
+    if (best == InstructionSet::AVX2) {
+        supported.push_back(InstructionSet::AVX2);
+    }
+
+    std::vector<int16_t> referencePcm(frames * 2), referenceMono(frames);
+    SampleConversion::FloatToPCM16(InstructionSet::Scalar, input.data(), referencePcm.data(), referencePcm.size());
+    SampleConversion::StereoToMono(InstructionSet::Scalar, referencePcm.data(), referenceMono.data(), frames);
+    std::vector<int16_t> referenceFused(frames);
+    SampleConversion::StereoFloatToMono(InstructionSet::Scalar, input.data(), referenceFused.data(), frames);
+
+    double scalarConvert = 0.0, scalarDownmix = 0.0, scalarFused = 0.0;
+    for (InstructionSet instructionSet : supported) {
+        std::string name = SampleConversion::InstructionSetName(instructionSet);
+        std::vector<int16_t> pcm(frames * 2), mono(frames), fusedMono(frames);
+
+        double convert = BestSeconds([&] {
+            for (size_t offset = 0; offset < input.size(); offset += chunk) {
+                SampleConversion::FloatToPCM16(instructionSet, input.data() + offset, pcm.data() + offset, chunk);
+            }
+        });
+        double downmix = BestSeconds([&] {
+            for (size_t offset = 0; offset < pcm.size(); offset += chunk) {
+                SampleConversion::StereoToMono(instructionSet, pcm.data() + offset, mono.data() + offset / 2, chunk / 2);
+            }
+        });
+        double fused = BestSeconds([&] {
+            for (size_t offset = 0; offset < input.size(); offset += chunk) {
+                SampleConversion::StereoFloatToMono(instructionSet, input.data() + offset, fusedMono.data() + offset / 2, chunk / 2);
+            }
+        });
+        if (instructionSet == InstructionSet::Scalar) {
+            scalarConvert = convert;
+            scalarDownmix = downmix;
+            scalarFused = fused;
+        }
+
+        // Odd lengths exercise the scalar tails of the vector loops
+        std::vector<int16_t> tailPcm(37), tailMono(18), tailFused(23);
+        SampleConversion::FloatToPCM16(instructionSet, input.data() + 3, tailPcm.data(), tailPcm.size());
+        SampleConversion::StereoToMono(instructionSet, referencePcm.data() + 6, tailMono.data(), tailMono.size());
+        SampleConversion::StereoFloatToMono(instructionSet, input.data() + 6, tailFused.data(), tailFused.size());
+        bool exact = pcm == referencePcm && mono == referenceMono && fusedMono == referenceFused &&
+                     std::equal(tailPcm.begin(), tailPcm.end(), referencePcm.begin() + 3) &&
+                     std::equal(tailMono.begin(), tailMono.end(), referenceMono.begin() + 3) &&
+                     std::equal(tailFused.begin(), tailFused.end(), referenceFused.begin() + 3);
+
+        Report("float->pcm16 " + name, convert, input.size());
+        Report("stereo->mono " + name, downmix, frames * 2);
+        Report("stereo float->mono " + name, fused, input.size());
+        std::printf("  %-34s %9.2fx / %.2fx / %.2fx vs scalar, bit-exact: %s\n", "",
+                    scalarConvert / convert, scalarDownmix / downmix, scalarFused / fused, exact ? "yes" : "NO");
+    }
+}
+
+// The 48 kHz stereo float -> 16 kHz mono int16 path, as the provider runs it
+void BenchmarkFusedConversion() {
+    const size_t frames = static_cast<size_t>(48000 * SECONDS_OF_AUDIO);
+    const size_t packetFrames = 480;  // 10 ms WASAPI packets
+    std::vector<int16_t> speech = MakeSpeechLikeSignal(48000, frames * 2);
+    std::vector<float> input(speech.size());
+    for (size_t i = 0; i < speech.size(); ++i) {
+        input[i] = speech[i] / 32768.0f;
+    }
+
+    std::printf("48000 Hz stereo float -> 16000 Hz mono int16, %.0f s of audio\n", SECONDS_OF_AUDIO);
+
+    // Separate passes with a vector per stage, one second at a time
+    PolyphaseResampler multiPassResampler(48000, 16000);
+    size_t sink = 0;
+    double multiPass = BestSeconds([&] {
+        const size_t chunkFrames = 48000;
+        for (size_t offset = 0; offset < frames; offset += chunkFrames) {
+            std::vector<int16_t> pcm(chunkFrames * 2);
+            SampleConversion::FloatToPCM16(input.data() + offset * 2, pcm.data(), pcm.size());
+            std::vector<int16_t> mono(chunkFrames);
+            SampleConversion::StereoToMono(pcm.data(), mono.data(), chunkFrames);
+            std::vector<int16_t> resampled(multiPassResampler.MaxOutputSamples(chunkFrames));
+            resampled.resize(multiPassResampler.Process(mono.data(), chunkFrames, resampled.data()));
+            std::vector<uint8_t> bytes(resampled.size() * sizeof(int16_t));
+            std::memcpy(bytes.data(), resampled.data(), bytes.size());
+            sink += bytes.size();
+        }
+    });
+    Report("multi-pass, 1 s chunks", multiPass, frames * 2);
+
+    // Fused downmix + resample + int16 per packet into one preallocated span
+    PolyphaseResampler fusedResampler(48000, 16000);
+    std::vector<int16_t> output(fusedResampler.MaxOutputSamples(frames));
+    double fused = BestSeconds([&] {
+        size_t written = 0;
+        for (size_t offset = 0; offset < frames; offset += packetFrames) {
+            const float* packet = input.data() + offset * 2;
+            int16_t* destination = output.data() + written;
+            written += fusedResampler.Process(packetFrames,
+                [packet](float* samples, size_t first, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        samples[i] = (packet[(first + i) * 2] + packet[(first + i) * 2 + 1]) * (32767.0f / 2);
+                    }
+                },
+                [destination](size_t index, float value) {
+                    value = value < 32767.0f ? value : 32767.0f;
+                    value = value > -32768.0f ? value : -32768.0f;
+                    destination[index] = static_cast<int16_t>(value + std::copysign(0.5f, value));
+                });
+        }
+        sink += written;
+    });
+    Report("fused, 10 ms packets", fused, frames * 2);
+    std::printf("  %-34s %9.2fx vs multi-pass\n", "", multiPass / fused);
+
+    if (sink == 0) {
+        std::printf("unexpected: no output\n");
+    }
+}
+
+} // namespace
+
+int main() {
+    std::printf("AudioConverter benchmarks (single core)\n\n");
+
+    std::printf("Dispatched kernels: %s\n", SampleConversion::InstructionSetName(SampleConversion::GetActiveInstructionSet()));
+    BenchmarkSampleConversion();
+    std::printf("\n");
+
+    BenchmarkFusedConversion();
+    std::printf("\n");
+
+    for (uint32_t rate : {48000u, 44100u, 32000u}) {
+        BenchmarkResampling(rate);
+        std::printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Micro-benchmark for the FLAC upload encoding: encode cost per second of
+// audio against the bytes it keeps off the wire, for 16 kHz mono chunks the
+// size the segmenter cuts. Single-threaded. Build with -DBUILD_BENCHMARKS=ON.
+//
+//   flac-encoder-bench [recording.wav]
+//
+// A 16-bit PCM WAV argument is benchmarked too (its first channel).
+
+#include "FlacEncoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t SAMPLE_RATE = 16000;
+const double SECONDS_OF_AUDIO = 60.0;
+const size_t CHUNK_SECONDS = 6;    // The segmenter's default maxUtteranceMs
+const int REPETITIONS = 5;
+
+// Voiced speech stand-in: a pitch-wandering harmonic series under a syllable
+// envelope, with pauses and a little background noise
+std::vector<int16_t> MakeSpeechLikeSignal(size_t samples) {
+    std::vector<int16_t> signal(samples);
+    uint32_t noise = 12345;
+    double phase = 0.0;
+    for (size_t i = 0; i < samples; ++i) {
+        double t = static_cast<double>(i) / SAMPLE_RATE;
+        double pitch = 140.0 + 30.0 * std::sin(2.0 * 3.14159265358979 * 0.7 * t);
+        phase += 2.0 * 3.14159265358979 * pitch / SAMPLE_RATE;
+        double voiced = 0.0;
+        for (int harmonic = 1; harmonic <= 12; ++harmonic) {
+            voiced += std::sin(phase * harmonic) / harmonic;
+        }
+        double syllable = std::max(0.0, std::sin(2.0 * 3.14159265358979 * 2.5 * t));
+        double pause = std::fmod(t, 4.0) < 3.0 ? 1.0 : 0.0;
+        noise = noise * 1664525u + 1013904223u;
+        double value = 0.25 * voiced * syllable * pause + 0.003 * (static_cast<int32_t>(noise >> 16) - 32768) / 32768.0;
+        signal[i] = static_cast<int16_t>(value * 32767.0);
+    }
+    return signal;
+}
+
+std::vector<int16_t> MakeNoise(size_t samples) {
+    std::vector<int16_t> signal(samples);
+    uint32_t noise = 777;
+    for (size_t i = 0; i < samples; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        signal[i] = static_cast<int16_t>((static_cast<int32_t>(noise >> 16) - 32768) / 4);
+    }
+    return signal;
+}
+
+// First channel of a 16-bit PCM WAV file; empty if it is not one
+std::vector<int16_t> ReadWav(const std::string& path, uint32_t& sampleRate) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    auto u16 = [&](size_t at) { return static_cast<uint32_t>(bytes[at] | (bytes[at + 1] << 8)); };
+    auto u32 = [&](size_t at) { return u16(at) | (u16(at + 2) << 16); };
+
+    std::vector<int16_t> samples;
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0 || std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        return samples;
+    }
+    uint32_t channels = 0, bits = 0;
+    size_t position = 12;
+    while (position + 8 <= bytes.size()) {
+        uint32_t size = u32(position + 4);
+        if (std::memcmp(bytes.data() + position, "fmt ", 4) == 0 && position + 24 <= bytes.size()) {
+            channels = u16(position + 10);
+            sampleRate = u32(position + 12);
+            bits = u16(position + 22);
+        } else if (std::memcmp(bytes.data() + position, "data", 4) == 0 && channels > 0 && bits == 16) {
+            size_t frames = std::min<size_t>(size, bytes.size() - position - 8) / (2 * channels);
+            samples.resize(frames);
+            for (size_t i = 0; i < frames; ++i) {
+                samples[i] = static_cast<int16_t>(u16(position + 8 + i * 2 * channels));
+            }
+            break;
+        }
+        position += 8 + size + (size & 1);
+    }
+    return samples;
+}
+
+template <typename Function>
+double BestSeconds(Function function) {
+    double best = 1e9;
+    for (int i = 0; i < REPETITIONS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+void Benchmark(const std::string& name, const std::vector<int16_t>& signal, uint32_t sampleRate,
+               const FlacEncoder::Settings& settings) {
+    const size_t chunk = CHUNK_SECONDS * sampleRate;
+    FlacEncoder encoder(sampleRate, 1, settings);
+    std::vector<uint8_t> output(encoder.MaxEncodedSize(chunk));
+
+    size_t encodedBytes = 0;
+    double seconds = BestSeconds([&] {
+        encodedBytes = 0;
+        for (size_t offset = 0; offset < signal.size(); offset += chunk) {
+            size_t frames = std::min(chunk, signal.size() - offset);
+            encodedBytes += encoder.Encode(signal.data() + offset, frames, output.data(), output.size());
+        }
+    });
+
+    // What the WAV upload would have been: a 44-byte header per chunk plus the PCM
+    double audioSeconds = static_cast<double>(signal.size()) / sampleRate;
+    size_t chunks = (signal.size() + chunk - 1) / chunk;
+    size_t wavBytes = chunks * 44 + signal.size() * sizeof(int16_t);
+    std::printf("  %-32s %8.1f us/audio s %8.0fx realtime %6.1f%% of WAV, saves %6.1f KB/audio s\n",
+                name.c_str(), seconds * 1e6 / audioSeconds, audioSeconds / seconds,
+                100.0 * encodedBytes / wavBytes, (wavBytes - encodedBytes) / audioSeconds / 1000.0);
+}
+
+void BenchmarkSettings(const std::string& title, const std::vector<int16_t>& signal, uint32_t sampleRate) {
+    std::printf("%s, %.0f s at %u Hz in %zu s chunks\n", title.c_str(),
+                static_cast<double>(signal.size()) / sampleRate, sampleRate, CHUNK_SECONDS);
+
+    FlacEncoder::Settings fixedOnly;
+    fixedOnly.maxLpcOrder = 0;
+    Benchmark("fixed predictors only", signal, sampleRate, fixedOnly);
+
+    FlacEncoder::Settings defaults;
+    Benchmark("LPC order 8 (default)", signal, sampleRate, defaults);
+
+    FlacEncoder::Settings highOrder;
+    highOrder.maxLpcOrder = 12;
+    Benchmark("LPC order 12", signal, sampleRate, highOrder);
+
+    FlacEncoder::Settings smallBlocks;
+    smallBlocks.blockSize = 1152;
+    Benchmark("LPC order 8, 1152-sample blocks", signal, sampleRate, smallBlocks);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::printf("FlacEncoder benchmarks (single core)\n\n");
+
+    const size_t samples = static_cast<size_t>(SAMPLE_RATE * SECONDS_OF_AUDIO);
+    BenchmarkSettings("Speech-like signal", MakeSpeechLikeSignal(samples), SAMPLE_RATE);
+    std::printf("\n");
+    BenchmarkSettings("White noise at a quarter of full scale", MakeNoise(samples), SAMPLE_RATE);
+
+    if (argc > 1) {
+        uint32_t sampleRate = 0;
+        std::vector<int16_t> recording = ReadWav(argv[1], sampleRate);
+        std::printf("\n");
+        if (recording.empty()) {
+            std::printf("%s is not a 16-bit PCM WAV file\n", argv[1]);
+            return 1;
+        }
+        BenchmarkSettings(argv[1], recording, sampleRate);
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Producer-side cost of SimpleLogger calls, compared with the synchronous
+// logger it replaced. Build with -DBUILD_BENCHMARKS=ON.
+
+#include "SimpleLogger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const size_t CALLS_PER_THREAD = 100000;
+const size_t BURST_CALLS = 256;          // Calls between short sleeps, roughly a busy capture thread
+const char* LOG_PATH = "logger-bench.log";
+
+// A typical AUDIO_LOG line, built before timing so only the call is measured
+std::vector<std::string> MakeMessages(size_t count, int thread) {
+    std::vector<std::string> messages;
+    messages.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        messages.push_back("[AudioCapture T" + std::to_string(thread) + "] Size: " + std::to_string(3840 + i % 7) +
+                           " bytes, Frames: 480, Rate: 48000Hz, Channels: 2");
+    }
+    return messages;
+}
+
+// SimpleLogger::LogMessage before it went asynchronous, without the console
+void LegacyLogMessage(std::ofstream& logFile, const std::string& level, const std::string& message) {
+    time_t now = time(0);
+    tm* timeinfo = localtime(&now);
+    char timestamp[100];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
+
+    std::string logEntry = std::string(timestamp) + " [" + level + "] " + message;
+    logFile << logEntry << std::endl;
+    logFile.flush();
+}
+
+struct CallTimes {
+    std::vector<double> nanoseconds;
+
+    void Report(const char* name) {
+        std::sort(nanoseconds.begin(), nanoseconds.end());
+        double total = 0.0;
+        for (double value : nanoseconds) {
+            total += value;
+        }
+        size_t count = nanoseconds.size();
+        std::printf("  %-30s mean %7.0f ns  p50 %7.0f ns  p99 %7.0f ns  p99.9 %8.0f ns  max %9.0f ns\n", name,
+                    total / count, nanoseconds[count / 2], nanoseconds[count * 99 / 100],
+                    nanoseconds[count * 999 / 1000], nanoseconds[count - 1]);
+    }
+};
+
+template <typename Function>
+void TimeCalls(std::vector<double>& times, size_t count, Function function) {
+    times.reserve(times.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function(i);
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        if ((i + 1) % BURST_CALLS == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void BenchmarkLegacy() {
+    std::remove(LOG_PATH);
+    std::ofstream logFile(LOG_PATH, std::ios::app);
+    std::vector<std::string> messages = MakeMessages(CALLS_PER_THREAD, 0);
+
+    CallTimes times;
+    TimeCalls(times.nanoseconds, messages.size(), [&](size_t i) { LegacyLogMessage(logFile, "AUDIO", messages[i]); });
+    times.Report("synchronous, 1 thread");
+}
+
+void BenchmarkAsync(int threadCount) {
+    std::vector<CallTimes> times(threadCount);
+    std::vector<std::vector<std::string>> messages;
+    for (int t = 0; t < threadCount; ++t) {
+        messages.push_back(MakeMessages(CALLS_PER_THREAD, t));
+    }
+
+    SimpleLogger::Stats before = SimpleLogger::GetStats();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            TimeCalls(times[t].nanoseconds, CALLS_PER_THREAD, [&](size_t i) {
+                SimpleLogger::LogMessage(SimpleLogger::Level::Audio, std::move(messages[t][i]));
+            });
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    SimpleLogger::Flush();
+    SimpleLogger::Stats after = SimpleLogger::GetStats();
+
+    CallTimes all;
+    for (auto& perThread : times) {
+        all.nanoseconds.insert(all.nanoseconds.end(), perThread.nanoseconds.begin(), perThread.nanoseconds.end());
+    }
+    std::string name = "asynchronous, " + std::to_string(threadCount) + (threadCount == 1 ? " thread" : " threads");
+    all.Report(name.c_str());
+    std::printf("  %-30s %llu dropped, %llu batches\n", "",
+                static_cast<unsigned long long>(after.dropped - before.dropped),
+                static_cast<unsigned long long>(after.batches - before.batches));
+}
+
+} // namespace
+
+int main() {
+    std::printf("SimpleLogger producer cost, %zu calls per thread in bursts of %zu (includes ~20 ns timer overhead)\n\n",
+                CALLS_PER_THREAD, BURST_CALLS);
+
+    BenchmarkLegacy();
+
+    std::remove(LOG_PATH);
+    SimpleLogger::Settings settings;
+    settings.filePath = LOG_PATH;
+    settings.console = false;
+    // Measure the steady state: no rotation stalls, and room for the whole run
+    // so failed pushes (which are cheaper) do not flatter the numbers
+    settings.maxFileBytes = 1ull << 32;
+    settings.queueCapacity = 1 << 19;
+    SimpleLogger::Initialize(settings);
+
+    for (int threads : {1, 2, 4}) {
+        BenchmarkAsync(threads);
+    }
+
+    SimpleLogger::Close();
+    std::remove(LOG_PATH);
+    return 0;
+}
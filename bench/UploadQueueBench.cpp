@@ -0,0 +1,97 @@
+// Head-of-line release under a backlog: one chunk's upload hangs while the
+// other workers keep a full queue busy. The later results must arrive about
+// headOfLineMaxWait after they finish, not once the queue drains.
+// Build with -DBUILD_BENCHMARKS=ON; exits non-zero if the release is late.
+
+#include "UploadQueue.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const size_t WORKERS = 2;
+const size_t QUEUED_CHUNKS = 12;                                // Behind the stuck head
+const std::chrono::milliseconds HEAD_OF_LINE_WAIT(200);
+const std::chrono::milliseconds STUCK_UPLOAD(3000);             // The head chunk, until cancelled
+const std::chrono::milliseconds UPLOAD(100);                    // Every other chunk
+
+// A worker notices the deadline when it next finishes an upload, so the
+// release may come up to one upload after the wait
+const std::chrono::milliseconds ALLOWED_RELEASE = HEAD_OF_LINE_WAIT + UPLOAD + std::chrono::milliseconds(100);
+
+struct Deliveries {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::map<uint64_t, Clock::time_point> at;
+    std::map<uint64_t, bool> transcribed;
+};
+
+double Milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+int main() {
+    std::printf("UploadQueue head-of-line release, %zu workers, %lld ms wait, %zu chunks queued behind a stuck head\n\n",
+                WORKERS, static_cast<long long>(HEAD_OF_LINE_WAIT.count()), QUEUED_CHUNKS);
+
+    UploadQueue queue(QUEUED_CHUNKS + 1, WORKERS, HEAD_OF_LINE_WAIT);
+    Deliveries deliveries;
+
+    queue.Start(
+        [](UploadQueue::Chunk& chunk) {
+            bool stuck = chunk.sequence == 0;
+            if (!chunk.cancel->WaitFor(stuck ? STUCK_UPLOAD : UPLOAD)) {
+                return std::string();
+            }
+            return "chunk " + std::to_string(chunk.sequence);
+        },
+        [&deliveries](uint64_t sequence, const std::string& text, const ChunkTrace&) {
+            std::lock_guard<std::mutex> lock(deliveries.mutex);
+            deliveries.at[sequence] = Clock::now();
+            deliveries.transcribed[sequence] = !text.empty();
+            deliveries.condition.notify_all();
+        });
+
+    // The stuck head goes first, so a worker is on it before the rest queue up
+    Clock::time_point started = Clock::now();
+    for (size_t i = 0; i <= QUEUED_CHUNKS; ++i) {
+        queue.Enqueue(std::vector<uint8_t>(16, 0), 16000, 1, 16);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(deliveries.mutex);
+        deliveries.condition.wait_for(lock, STUCK_UPLOAD * 2,
+                                      [&deliveries] { return deliveries.at.size() > QUEUED_CHUNKS; });
+    }
+    queue.Stop();
+
+    std::lock_guard<std::mutex> lock(deliveries.mutex);
+    if (deliveries.at.count(0) == 0 || deliveries.at.count(1) == 0) {
+        std::printf("  head was never released\n");
+        return 1;
+    }
+
+    // Chunk 1 finished after one upload; from then on it waited only on the head
+    double released = Milliseconds(deliveries.at[1] - started);
+    double allowed = Milliseconds(UPLOAD + ALLOWED_RELEASE);
+    UploadQueue::Stats stats = queue.GetStats();
+    std::printf("  head released as a failure at %8.0f ms (transcribed: %s)\n", Milliseconds(deliveries.at[0] - started),
+                deliveries.transcribed[0] ? "yes" : "no");
+    std::printf("  chunk #1 delivered at          %8.0f ms, allowed %.0f ms\n", released, allowed);
+    std::printf("  last chunk delivered at        %8.0f ms\n", Milliseconds(deliveries.at.rbegin()->second - started));
+    std::printf("  skipped %llu, completed %llu\n", static_cast<unsigned long long>(stats.skipped),
+                static_cast<unsigned long long>(stats.completed));
+
+    bool onTime = released <= allowed && !deliveries.transcribed[0];
+    std::printf("  released on time: %s\n", onTime ? "yes" : "NO");
+    return onTime ? 0 : 1;
+}
@@ -0,0 +1,682 @@
+// Local stand-in for the Azure OpenAI / Whisper audio/transcriptions endpoint,
+// for load testing the upload path offline. Accepts the same multipart
+// uploads, answers with canned or audio-derived transcripts, and can add
+// latency, inject 429/5xx responses and cap concurrency like the service does.
+//
+//   mock-whisper-server --port 8089 --latency lognormal:400:0.6 --error-429 0.05
+//
+// Point the app or transcribe-cli at
+//   http://127.0.0.1:8089/openai/deployments/whisper/audio/transcriptions
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+const int SEND_FLAGS = 0;
+#else
+using SocketHandle = int;
+const SocketHandle NO_SOCKET = -1;
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+#endif
+
+const size_t MAX_HEADER_BYTES = 64 * 1024;
+const size_t MAX_BODY_BYTES = 64 * 1024 * 1024;
+const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+std::atomic<bool> stopRequested(false);
+
+void CloseSocket(SocketHandle socket) {
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+// Delay before answering, drawn per request
+struct LatencyModel {
+    enum class Kind {
+        Fixed,
+        Uniform,
+        LogNormal
+    };
+
+    Kind kind = Kind::Fixed;
+    double first = 0.0;     // Fixed value, uniform minimum or log-normal median (ms)
+    double second = 0.0;    // Uniform maximum (ms) or log-normal sigma
+    double perAudioSecondMs = 0.0;
+
+    // "fixed:MS", "uniform:MIN:MAX" or "lognormal:MEDIAN:SIGMA"
+    static bool Parse(const std::string& text, LatencyModel& model) {
+        size_t colon = text.find(':');
+        std::string name = text.substr(0, colon);
+        std::vector<double> values;
+        while (colon != std::string::npos) {
+            size_t next = text.find(':', colon + 1);
+            values.push_back(std::atof(text.substr(colon + 1, next - colon - 1).c_str()));
+            colon = next;
+        }
+
+        if (name == "fixed" && values.size() == 1) {
+            model.kind = Kind::Fixed;
+        } else if (name == "uniform" && values.size() == 2 && values[1] >= values[0]) {
+            model.kind = Kind::Uniform;
+        } else if (name == "lognormal" && values.size() == 2 && values[0] > 0.0) {
+            model.kind = Kind::LogNormal;
+        } else {
+            return false;
+        }
+        model.first = values[0];
+        model.second = values.size() > 1 ? values[1] : 0.0;
+        return true;
+    }
+
+    double SampleMs(std::mt19937_64& random, double audioSeconds) const {
+        double base = first;
+        if (kind == Kind::Uniform) {
+            base = std::uniform_real_distribution<double>(first, second)(random);
+        } else if (kind == Kind::LogNormal) {
+            base = std::lognormal_distribution<double>(std::log(first), second)(random);
+        }
+        return std::max(0.0, base + perAudioSecondMs * audioSeconds);
+    }
+};
+
+struct Options {
+    std::string bindAddress = "127.0.0.1";
+    uint16_t port = 8089;
+    LatencyModel latency;
+    double error429 = 0.0;
+    double error500 = 0.0;
+    double error503 = 0.0;
+    uint32_t retryAfterSeconds = 1;
+    uint32_t maxConcurrent = 0;         // 0 is unlimited
+    double uploadKBps = 0.0;            // Request body read rate, 0 is unlimited
+    std::string apiKey;                 // Empty accepts any key
+    std::string transcriptsPath;
+    uint64_t seed = 1;
+    uint32_t statsIntervalSeconds = 10;
+};
+
+struct ServerStats {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> ok{0};
+    std::atomic<uint64_t> rejected429{0};       // Injected and over the concurrency limit
+    std::atomic<uint64_t> errors5xx{0};
+    std::atomic<uint64_t> badRequests{0};
+    std::atomic<uint64_t> audioMilliseconds{0};
+    std::atomic<uint32_t> inFlight{0};
+    std::atomic<uint32_t> peakInFlight{0};
+};
+
+struct Server {
+    Options options;
+    std::vector<std::string> transcripts;
+    ServerStats stats;
+    std::mutex randomMutex;
+    std::mt19937_64 random;
+    std::atomic<uint64_t> nextTranscript{0};
+};
+
+struct Request {
+    std::string method;
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    std::string Header(const std::string& name) const {
+        for (const auto& header : headers) {
+            if (header.first.size() == name.size() &&
+                std::equal(name.begin(), name.end(), header.first.begin(),
+                           [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) ==
+                                                       std::tolower(static_cast<unsigned char>(b)); })) {
+                return header.second;
+            }
+        }
+        return "";
+    }
+};
+
+struct Response {
+    int status = 200;
+    std::string contentType = "application/json";
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+};
+
+std::string Trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+// Reads one request from a keep-alive connection; pending holds bytes past the
+// last one. A nonzero uploadKBps reads the body no faster, like a slow uplink.
+bool ReadRequest(SocketHandle socket, std::string& pending, Request& request, double uploadKBps) {
+    char chunk[READ_CHUNK_SIZE];
+    size_t readSize = sizeof(chunk);
+    if (uploadKBps > 0.0) {
+        readSize = std::max<size_t>(1024, std::min<size_t>(sizeof(chunk), static_cast<size_t>(uploadKBps * 1000.0 / 20)));
+    }
+    auto fill = [&]() {
+        int received = static_cast<int>(recv(socket, chunk, static_cast<int>(readSize), 0));
+        if (received <= 0) {
+            return false;
+        }
+        pending.append(chunk, static_cast<size_t>(received));
+        return true;
+    };
+
+    size_t headerEnd;
+    while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos) {
+        if (pending.size() > MAX_HEADER_BYTES || !fill()) {
+            return false;
+        }
+    }
+
+    std::string head = pending.substr(0, headerEnd);
+    pending.erase(0, headerEnd + 4);
+
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t firstSpace = requestLine.find(' ');
+    size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+    if (firstSpace == std::string::npos || secondSpace == std::string::npos) {
+        return false;
+    }
+    request.method = requestLine.substr(0, firstSpace);
+    request.path = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+
+    request.headers.clear();
+    while (lineEnd != std::string::npos) {
+        size_t start = lineEnd + 2;
+        lineEnd = head.find("\r\n", start);
+        std::string line = head.substr(start, lineEnd == std::string::npos ? std::string::npos : lineEnd - start);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            request.headers.emplace_back(Trim(line.substr(0, colon)), Trim(line.substr(colon + 1)));
+        }
+    }
+
+    size_t length = static_cast<size_t>(std::strtoull(request.Header("Content-Length").c_str(), nullptr, 10));
+    if (length > MAX_BODY_BYTES) {
+        return false;
+    }
+    auto bodyStart = std::chrono::steady_clock::now();
+    size_t alreadyRead = pending.size();
+    while (pending.size() < length) {
+        if (!fill()) {
+            return false;
+        }
+        if (uploadKBps > 0.0) {
+            double due = (pending.size() - alreadyRead) / (uploadKBps * 1000.0);
+            std::this_thread::sleep_until(bodyStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(due)));
+        }
+    }
+    request.body = pending.substr(0, length);
+    pending.erase(0, length);
+    return true;
+}
+
+bool SendAll(SocketHandle socket, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int result = static_cast<int>(send(socket, data.data() + sent, static_cast<int>(data.size() - sent), SEND_FLAGS));
+        if (result <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+const char* StatusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Error";
+    }
+}
+
+bool SendResponse(SocketHandle socket, const Response& response, bool keepAlive) {
+    std::string head = "HTTP/1.1 " + std::to_string(response.status) + " " + StatusText(response.status) + "\r\n";
+    head += "Content-Type: " + response.contentType + "\r\n";
+    head += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    head += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    for (const auto& header : response.headers) {
+        head += header.first + ": " + header.second + "\r\n";
+    }
+    head += "\r\n";
+    return SendAll(socket, head + response.body);
+}
+
+Response ErrorResponse(int status, const std::string& message) {
+    Response response;
+    response.status = status;
+    response.body = json{{"error", {{"code", std::to_string(status)}, {"message", message}}}}.dump();
+    return response;
+}
+
+// Parts of a multipart/form-data body, by field name
+bool ParseMultipart(const Request& request, std::string& file, std::string& responseFormat) {
+    std::string contentType = request.Header("Content-Type");
+    size_t boundaryPos = contentType.find("boundary=");
+    if (contentType.find("multipart/form-data") == std::string::npos || boundaryPos == std::string::npos) {
+        return false;
+    }
+    std::string boundary = contentType.substr(boundaryPos + 9);
+    if (boundary.size() >= 2 && boundary.front() == '"') {
+        boundary = boundary.substr(1, boundary.size() - 2);
+    }
+    const std::string delimiter = "--" + boundary;
+
+    bool haveFile = false;
+    size_t position = request.body.find(delimiter);
+    while (position != std::string::npos) {
+        size_t partStart = position + delimiter.size();
+        if (request.body.compare(partStart, 2, "--") == 0) {
+            break;
+        }
+        size_t headersEnd = request.body.find("\r\n\r\n", partStart);
+        size_t next = request.body.find("\r\n" + delimiter, headersEnd);
+        if (headersEnd == std::string::npos || next == std::string::npos) {
+            return false;
+        }
+        std::string partHeaders = request.body.substr(partStart, headersEnd - partStart);
+        size_t dataStart = headersEnd + 4;
+        std::string data = request.body.substr(dataStart, next - dataStart);
+
+        size_t namePos = partHeaders.find("name=\"");
+        if (namePos != std::string::npos) {
+            size_t nameEnd = partHeaders.find('"', namePos + 6);
+            std::string name = partHeaders.substr(namePos + 6, nameEnd - namePos - 6);
+            if (name == "file") {
+                file = std::move(data);
+                haveFile = true;
+            } else if (name == "response_format") {
+                responseFormat = Trim(data);
+            }
+        }
+        position = next + 2;
+    }
+    return haveFile;
+}
+
+// Duration and loudness of a PCM WAV file, for derived transcripts
+bool AnalyzeWav(const std::string& wav, double& seconds, double& rmsDb) {
+    auto u16 = [&](size_t at) { return static_cast<uint16_t>(static_cast<uint8_t>(wav[at]) | (static_cast<uint8_t>(wav[at + 1]) << 8)); };
+    auto u32 = [&](size_t at) { return static_cast<uint32_t>(u16(at)) | (static_cast<uint32_t>(u16(at + 2)) << 16); };
+
+    if (wav.size() < 12 || wav.compare(0, 4, "RIFF") != 0 || wav.compare(8, 4, "WAVE") != 0) {
+        return false;
+    }
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    uint32_t rate = 0;
+    size_t position = 12;
+    while (position + 8 <= wav.size()) {
+        uint32_t size = u32(position + 4);
+        if (wav.compare(position, 4, "fmt ") == 0 && position + 24 <= wav.size()) {
+            channels = u16(position + 10);
+            rate = u32(position + 12);
+            bits = u16(position + 22);
+        } else if (wav.compare(position, 4, "data") == 0) {
+            if (channels == 0 || rate == 0 || bits != 16) {
+                return false;
+            }
+            size_t bytes = std::min<size_t>(size, wav.size() - position - 8);
+            size_t samples = bytes / 2;
+            double sum = 0.0;
+            for (size_t i = 0; i < samples; ++i) {
+                double value = static_cast<int16_t>(u16(position + 8 + i * 2)) / 32768.0;
+                sum += value * value;
+            }
+            seconds = static_cast<double>(samples) / channels / rate;
+            rmsDb = samples > 0 && sum > 0.0 ? 10.0 * std::log10(sum / samples) : -120.0;
+            return true;
+        }
+        position += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+// Duration of a FLAC stream from its STREAMINFO; loudness would take a
+// decoder, so it is reported as unknown (NaN)
+bool AnalyzeFlac(const std::string& flac, double& seconds, double& rmsDb) {
+    if (flac.size() < 42 || flac.compare(0, 4, "fLaC") != 0 || (static_cast<uint8_t>(flac[4]) & 0x7F) != 0) {
+        return false;
+    }
+    auto byte = [&](size_t at) { return static_cast<uint64_t>(static_cast<uint8_t>(flac[8 + at])); };
+    uint64_t rate = (byte(10) << 12) | (byte(11) << 4) | (byte(12) >> 4);
+    uint64_t samples = ((byte(13) & 0x0F) << 32) | (byte(14) << 24) | (byte(15) << 16) | (byte(16) << 8) | byte(17);
+    if (rate == 0) {
+        return false;
+    }
+    seconds = static_cast<double>(samples) / rate;
+    rmsDb = std::nan("");
+    return true;
+}
+
+Response HandleTranscription(Server& server, const Request& request, uint64_t requestNumber) {
+    if (request.method != "POST") {
+        return ErrorResponse(404, "Only POST is supported");
+    }
+    if (request.path.find("/audio/transcriptions") == std::string::npos) {
+        return ErrorResponse(404, "Unknown path " + request.path);
+    }
+    if (!server.options.apiKey.empty() && request.Header("api-key") != server.options.apiKey &&
+        request.Header("Authorization") != "Bearer " + server.options.apiKey) {
+        return ErrorResponse(401, "Access denied due to invalid subscription key");
+    }
+
+    std::string file;
+    std::string responseFormat = "json";
+    double seconds = 0.0;
+    double rmsDb = -120.0;
+    if (!ParseMultipart(request, file, responseFormat) || (!AnalyzeWav(file, seconds, rmsDb) && !AnalyzeFlac(file, seconds, rmsDb))) {
+        server.stats.badRequests++;
+        return ErrorResponse(400, "Expected a multipart upload with a 16-bit PCM WAV or FLAC 'file' part");
+    }
+    server.stats.audioMilliseconds += static_cast<uint64_t>(seconds * 1000.0);
+
+    // Draw the latency and any injected failure, then hold the request open
+    double delayMs;
+    double roll;
+    {
+        std::lock_guard<std::mutex> lock(server.randomMutex);
+        delayMs = server.options.latency.SampleMs(server.random, seconds);
+        roll = std::uniform_real_distribution<double>(0.0, 1.0)(server.random);
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(delayMs));
+
+    const Options& options = server.options;
+    if (roll < options.error429) {
+        Response response = ErrorResponse(429, "Requests to the deployment have exceeded the rate limit");
+        response.headers.emplace_back("Retry-After", std::to_string(options.retryAfterSeconds));
+        return response;
+    }
+    if (roll < options.error429 + options.error500) {
+        return ErrorResponse(500, "Injected internal error");
+    }
+    if (roll < options.error429 + options.error500 + options.error503) {
+        return ErrorResponse(503, "Injected service unavailable");
+    }
+
+    std::string text;
+    if (!server.transcripts.empty()) {
+        text = server.transcripts[server.nextTranscript++ % server.transcripts.size()];
+    } else {
+        char derived[128];
+        if (std::isnan(rmsDb)) {
+            std::snprintf(derived, sizeof(derived), "Segment %llu: %.2f seconds of FLAC audio.",
+                          static_cast<unsigned long long>(requestNumber), seconds);
+        } else {
+            std::snprintf(derived, sizeof(derived), "Segment %llu: %.2f seconds of audio at %.1f dBFS.",
+                          static_cast<unsigned long long>(requestNumber), seconds, rmsDb);
+        }
+        text = derived;
+    }
+
+    Response response;
+    if (responseFormat == "text") {
+        response.contentType = "text/plain";
+        response.body = text;
+    } else if (responseFormat == "verbose_json") {
+        response.body = json{{"task", "transcribe"}, {"language", "english"}, {"duration", seconds}, {"text", text},
+                             {"segments", json::array({{{"id", 0}, {"start", 0.0}, {"end", seconds}, {"text", text}}})}}
+                            .dump();
+    } else {
+        response.body = json{{"text", text}}.dump();
+    }
+    return response;
+}
+
+void ServeConnection(Server& server, SocketHandle socket) {
+    std::string pending;
+    Request request;
+    while (!stopRequested.load() && ReadRequest(socket, pending, request, server.options.uploadKBps)) {
+        uint64_t requestNumber = ++server.stats.requests;
+
+        uint32_t inFlight = ++server.stats.inFlight;
+        uint32_t peak = server.stats.peakInFlight.load();
+        while (inFlight > peak && !server.stats.peakInFlight.compare_exchange_weak(peak, inFlight)) {
+        }
+
+        Response response;
+        if (server.options.maxConcurrent > 0 && inFlight > server.options.maxConcurrent) {
+            // Over the limit: refuse at once, as the service does
+            response = ErrorResponse(429, "Too many concurrent requests");
+            response.headers.emplace_back("Retry-After", std::to_string(server.options.retryAfterSeconds));
+        } else {
+            response = HandleTranscription(server, request, requestNumber);
+        }
+        server.stats.inFlight--;
+
+        if (response.status == 200) {
+            server.stats.ok++;
+        } else if (response.status == 429) {
+            server.stats.rejected429++;
+        } else if (response.status >= 500) {
+            server.stats.errors5xx++;
+        }
+
+        bool keepAlive = request.Header("Connection") != "close";
+        if (!SendResponse(socket, response, keepAlive) || !keepAlive) {
+            break;
+        }
+    }
+    CloseSocket(socket);
+}
+
+void PrintStats(const ServerStats& stats) {
+    std::cerr << "mock-whisper-server: " << stats.requests.load() << " requests, " << stats.ok.load() << " ok, "
+              << stats.rejected429.load() << " 429, " << stats.errors5xx.load() << " 5xx, "
+              << stats.badRequests.load() << " bad, peak " << stats.peakInFlight.load() << " in flight, "
+              << stats.audioMilliseconds.load() / 1000.0 << " s of audio" << std::endl;
+}
+
+void PrintUsage() {
+    std::cerr <<
+        "Usage: mock-whisper-server [options]\n"
+        "\n"
+        "  --bind ADDRESS           Listen address (default 127.0.0.1)\n"
+        "  --port N                 Listen port (default 8089)\n"
+        "  --latency SPEC           fixed:MS, uniform:MIN:MAX or lognormal:MEDIAN:SIGMA (default fixed:0)\n"
+        "  --latency-per-second MS  Extra delay per second of uploaded audio\n"
+        "  --error-429 P            Fraction of requests answered 429 with Retry-After\n"
+        "  --error-500 P            Fraction answered 500\n"
+        "  --error-503 P            Fraction answered 503\n"
+        "  --retry-after S          Retry-After seconds on 429 (default 1)\n"
+        "  --max-concurrent N       Answer 429 beyond N requests in flight (default unlimited)\n"
+        "  --upload-rate KBPS       Read request bodies at most this many KB/s, per connection\n"
+        "  --api-key KEY            Require this api-key header\n"
+        "  --transcripts FILE       Canned transcripts, one per line, used in turn\n"
+        "  --seed N                 Random seed for latency and errors (default 1)\n"
+        "  --stats-interval S       Print counters every S seconds, 0 to disable (default 10)\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--bind") {
+            options.bindAddress = value;
+        } else if (arg == "--port") {
+            options.port = static_cast<uint16_t>(std::atoi(value.c_str()));
+        } else if (arg == "--latency") {
+            if (!LatencyModel::Parse(value, options.latency)) {
+                std::cerr << "mock-whisper-server: bad latency spec: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--latency-per-second") {
+            options.latency.perAudioSecondMs = std::atof(value.c_str());
+        } else if (arg == "--error-429") {
+            options.error429 = std::atof(value.c_str());
+        } else if (arg == "--error-500") {
+            options.error500 = std::atof(value.c_str());
+        } else if (arg == "--error-503") {
+            options.error503 = std::atof(value.c_str());
+        } else if (arg == "--retry-after") {
+            options.retryAfterSeconds = static_cast<uint32_t>(std::atoi(value.c_str()));
+        } else if (arg == "--max-concurrent") {
+            options.maxConcurrent = static_cast<uint32_t>(std::atoi(value.c_str()));
+        } else if (arg == "--upload-rate") {
+            options.uploadKBps = std::atof(value.c_str());
+        } else if (arg == "--api-key") {
+            options.apiKey = value;
+        } else if (arg == "--transcripts") {
+            options.transcriptsPath = value;
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--stats-interval") {
+            options.statsIntervalSeconds = static_cast<uint32_t>(std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return options.port != 0;
+}
+
+void OnSignal(int) {
+    stopRequested = true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Server server;
+    if (!ParseOptions(argc, argv, server.options)) {
+        PrintUsage();
+        return 2;
+    }
+    server.random.seed(server.options.seed);
+
+    if (!server.options.transcriptsPath.empty()) {
+        std::ifstream file(server.options.transcriptsPath);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!Trim(line).empty()) {
+                server.transcripts.push_back(Trim(line));
+            }
+        }
+        if (server.transcripts.empty()) {
+            std::cerr << "mock-whisper-server: no transcripts in " << server.options.transcriptsPath << std::endl;
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#else
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == NO_SOCKET) {
+        std::cerr << "mock-whisper-server: cannot create socket" << std::endl;
+        return 1;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.options.port);
+    if (inet_pton(AF_INET, server.options.bindAddress.c_str(), &address.sin_addr) != 1 ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        std::cerr << "mock-whisper-server: cannot listen on " << server.options.bindAddress << ":"
+                  << server.options.port << std::endl;
+        CloseSocket(listener);
+        return 1;
+    }
+    std::cerr << "mock-whisper-server: listening on http://" << server.options.bindAddress << ":"
+              << server.options.port << "/openai/deployments/<name>/audio/transcriptions" << std::endl;
+
+    auto nextStats = std::chrono::steady_clock::now() + std::chrono::seconds(server.options.statsIntervalSeconds);
+    while (!stopRequested.load()) {
+        // Wake up regularly to notice Ctrl+C and print counters
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+        timeval timeout = {0, 200000};
+        int ready = select(static_cast<int>(listener + 1), &readable, nullptr, nullptr, &timeout);
+
+        if (ready > 0) {
+            SocketHandle client = accept(listener, nullptr, nullptr);
+            if (client != NO_SOCKET) {
+                int noDelay = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+                if (server.options.uploadKBps > 0.0) {
+                    // A small window makes the client wait on the pacing instead of filling buffers
+                    int receiveBuffer = 16 * 1024;
+                    setsockopt(client, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBuffer), sizeof(receiveBuffer));
+                }
+                std::thread(ServeConnection, std::ref(server), client).detach();
+            }
+        }
+
+        if (server.options.statsIntervalSeconds > 0 && std::chrono::steady_clock::now() >= nextStats) {
+            PrintStats(server.stats);
+            nextStats = std::chrono::steady_clock::now() + std::chrono::seconds(server.options.statsIntervalSeconds);
+        }
+    }
+
+    CloseSocket(listener);
+    PrintStats(server.stats);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
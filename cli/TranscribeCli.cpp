@@ -0,0 +1,427 @@
+// Headless transcription: reads a WAV file (or raw PCM, or a capture trace),
+// runs it through the same voice gate, segmenter and upload pipeline as the
+// GUI, and writes one JSON line per transcribed segment. Audio is fed as fast
+// as the uploads allow rather than in real time.
+
+#include "CaptureTrace.h"
+#include "ConfigManager.h"
+#include "PipelineLatency.h"
+#include "SimpleLogger.h"
+#include "SpeechRecognition.h"
+#include "TimelineTrace.h"
+#include "TranscriptSink.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+const uint16_t WAVE_FORMAT_PCM = 1;
+const uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+struct Options {
+    std::string configPath = "config/settings.json";
+    std::string inputPath = "-";
+    std::string outputPath = "-";
+    std::string logPath = "transcribe-cli.log";
+    std::string endpoint;
+    std::string apiKey;
+    std::string recordTracePath;
+    std::string metricsPath;
+    std::string timelinePath;
+    bool raw = false;
+    bool trace = false;
+    bool realTime = false;
+    AudioFormat rawFormat{48000, 2, 32, 0};    // WASAPI loopback default: 48 kHz stereo float
+    uint32_t packetMs = 10;                     // Same packet size as the capture thread delivers
+    size_t maxPending = 4;                      // Segments in flight before feeding pauses
+};
+
+void PrintUsage() {
+    std::cerr <<
+        "Usage: transcribe-cli [options] [input.wav | -]\n"
+        "\n"
+        "Reads 16-bit PCM or 32-bit float audio (WAV, raw with --raw, or a capture\n"
+        "trace with --trace) and writes transcript segments as JSON lines.\n"
+        "\n"
+        "  --config PATH        Settings file (default config/settings.json)\n"
+        "  --output PATH        JSON lines output (default stdout)\n"
+        "  --log PATH           Log file (default transcribe-cli.log)\n"
+        "  --endpoint URL       Override the transcription endpoint\n"
+        "  --api-key KEY        Override the API key\n"
+        "  --trace              Input is a capture trace recorded by the app\n"
+        "  --realtime           Replay the trace at its recorded pace\n"
+        "  --record-trace PATH  Save the packets fed to the pipeline as a capture trace\n"
+        "  --metrics PATH       Write per-stage latency percentiles as JSON at the end\n"
+        "  --timeline PATH      Write a Chrome trace_event timeline of the pipeline threads\n"
+        "  --raw                Input is headerless PCM\n"
+        "  --rate HZ            Raw sample rate (default 48000)\n"
+        "  --channels N         Raw channel count (default 2)\n"
+        "  --bits 16|32         Raw sample size; 32 is float (default 32)\n"
+        "  --packet-ms MS       Audio per pipeline call (default 10)\n"
+        "  --max-pending N      Segments awaiting results before input pauses (default 4)\n";
+}
+
+bool ParseUnsigned(const char* text, uint32_t& value) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        uint32_t number = 0;
+
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (arg == "--raw") {
+            options.raw = true;
+        } else if (arg == "--trace") {
+            options.trace = true;
+        } else if (arg == "--realtime") {
+            options.realTime = true;
+        } else if (arg == "--record-trace" && hasValue) {
+            options.recordTracePath = argv[++i];
+        } else if (arg == "--metrics" && hasValue) {
+            options.metricsPath = argv[++i];
+        } else if (arg == "--timeline" && hasValue) {
+            options.timelinePath = argv[++i];
+        } else if (arg == "--config" && hasValue) {
+            options.configPath = argv[++i];
+        } else if (arg == "--output" && hasValue) {
+            options.outputPath = argv[++i];
+        } else if (arg == "--log" && hasValue) {
+            options.logPath = argv[++i];
+        } else if (arg == "--endpoint" && hasValue) {
+            options.endpoint = argv[++i];
+        } else if (arg == "--api-key" && hasValue) {
+            options.apiKey = argv[++i];
+        } else if (arg == "--rate" && hasValue && ParseUnsigned(argv[++i], number) && number > 0) {
+            options.rawFormat.sampleRate = number;
+        } else if (arg == "--channels" && hasValue && ParseUnsigned(argv[++i], number) && number > 0 && number <= 32) {
+            options.rawFormat.channels = static_cast<uint16_t>(number);
+        } else if (arg == "--bits" && hasValue && ParseUnsigned(argv[++i], number) && (number == 16 || number == 32)) {
+            options.rawFormat.bitsPerSample = static_cast<uint16_t>(number);
+        } else if (arg == "--packet-ms" && hasValue && ParseUnsigned(argv[++i], number) && number > 0) {
+            options.packetMs = number;
+        } else if (arg == "--max-pending" && hasValue && ParseUnsigned(argv[++i], number)) {
+            options.maxPending = number;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg != "-") {
+            std::cerr << "transcribe-cli: bad option or missing value: " << arg << std::endl;
+            return false;
+        } else {
+            options.inputPath = arg;
+        }
+    }
+    return true;
+}
+
+uint16_t ReadUInt16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t ReadUInt32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+bool ReadExactly(std::istream& input, uint8_t* data, size_t size) {
+    input.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<size_t>(input.gcount()) == size;
+}
+
+// Reads the RIFF header up to the start of the samples. Works on pipes, so
+// unknown chunks are read and discarded instead of seeked over. Streamed
+// files often leave the data size at 0 or 0xFFFFFFFF; both mean "until EOF".
+bool ReadWavHeader(std::istream& input, AudioFormat& format, uint64_t& dataBytes, std::string& error) {
+    uint8_t riff[12];
+    if (!ReadExactly(input, riff, sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file (use --raw for headerless PCM)";
+        return false;
+    }
+
+    bool haveFormat = false;
+    uint16_t formatTag = 0;
+    while (true) {
+        uint8_t chunkHeader[8];
+        if (!ReadExactly(input, chunkHeader, sizeof(chunkHeader))) {
+            error = "no data chunk";
+            return false;
+        }
+        uint32_t chunkSize = ReadUInt32(chunkHeader + 4);
+
+        if (std::memcmp(chunkHeader, "data", 4) == 0) {
+            dataBytes = (chunkSize == 0 || chunkSize == 0xFFFFFFFFu) ? UINT64_MAX : chunkSize;
+            break;
+        }
+
+        std::vector<uint8_t> chunk(chunkSize + (chunkSize & 1));
+        if (!ReadExactly(input, chunk.data(), chunk.size())) {
+            error = "truncated header";
+            return false;
+        }
+        if (std::memcmp(chunkHeader, "fmt ", 4) == 0 && chunkSize >= 16) {
+            formatTag = ReadUInt16(chunk.data());
+            format.channels = ReadUInt16(chunk.data() + 2);
+            format.sampleRate = ReadUInt32(chunk.data() + 4);
+            format.bitsPerSample = ReadUInt16(chunk.data() + 14);
+            if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 26) {
+                formatTag = ReadUInt16(chunk.data() + 24);   // First two bytes of the subformat GUID
+            }
+            haveFormat = true;
+        }
+    }
+
+    if (!haveFormat) {
+        error = "no fmt chunk before the data";
+        return false;
+    }
+    bool pcm16 = formatTag == WAVE_FORMAT_PCM && format.bitsPerSample == 16;
+    bool float32 = formatTag == WAVE_FORMAT_IEEE_FLOAT && format.bitsPerSample == 32;
+    if (!(pcm16 || float32) || format.channels == 0 || format.sampleRate == 0) {
+        error = "unsupported sample format (need 16-bit PCM or 32-bit float)";
+        return false;
+    }
+    return true;
+}
+
+using AudioDataCallback = std::function<void(const std::vector<uint8_t>&, const AudioFormat&)>;
+
+// Streams WAV or raw PCM in capture-sized packets; returns the seconds of audio read
+bool FeedAudioStream(const Options& options, const AudioDataCallback& deliver, double& audioSeconds) {
+    std::ifstream inputFile;
+    std::istream* input = &std::cin;
+    if (options.inputPath != "-") {
+        inputFile.open(options.inputPath, std::ios::binary);
+        if (!inputFile) {
+            std::cerr << "transcribe-cli: cannot open " << options.inputPath << std::endl;
+            return false;
+        }
+        input = &inputFile;
+    } else {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    }
+
+    AudioFormat format = options.rawFormat;
+    uint64_t dataBytes = UINT64_MAX;
+    if (!options.raw) {
+        std::string error;
+        if (!ReadWavHeader(*input, format, dataBytes, error)) {
+            std::cerr << "transcribe-cli: " << options.inputPath << ": " << error << std::endl;
+            return false;
+        }
+    }
+    size_t frameBytes = static_cast<size_t>(format.channels) * (format.bitsPerSample / 8);
+    format.bytesPerSecond = static_cast<uint32_t>(format.sampleRate * frameBytes);
+
+    size_t packetFrames = std::max<size_t>(1, static_cast<size_t>(format.sampleRate) * options.packetMs / 1000);
+    std::vector<uint8_t> packet(packetFrames * frameBytes);
+    uint64_t bytesIn = 0;
+
+    while (*input && bytesIn < dataBytes) {
+        size_t request = static_cast<size_t>(std::min<uint64_t>(packet.size(), dataBytes - bytesIn));
+        input->read(reinterpret_cast<char*>(packet.data()), static_cast<std::streamsize>(request));
+        size_t bytes = static_cast<size_t>(input->gcount()) / frameBytes * frameBytes;
+        if (bytes == 0) {
+            break;
+        }
+        if (bytes < packet.size()) {
+            packet.resize(bytes);
+        }
+        deliver(packet, format);
+        bytesIn += bytes;
+    }
+
+    audioSeconds = static_cast<double>(bytesIn) / format.bytesPerSecond;
+    return true;
+}
+
+// Replays a capture trace, at the recorded pace with --realtime
+bool FeedCaptureTrace(const Options& options, const AudioDataCallback& deliver, double& audioSeconds) {
+    CaptureTraceReplay replay;
+    if (!replay.Open(options.inputPath)) {
+        std::cerr << "transcribe-cli: " << replay.GetError() << std::endl;
+        return false;
+    }
+    replay.SetAudioDataCallback(deliver);
+
+    CaptureTraceReplay::Stats stats = replay.Run(options.realTime ? CaptureTraceReplay::Pacing::Original
+                                                                  : CaptureTraceReplay::Pacing::AsFastAsPossible);
+    if (!replay.GetError().empty()) {
+        std::cerr << "transcribe-cli: trace ended early: " << replay.GetError() << std::endl;
+    }
+    audioSeconds = stats.audioSeconds;
+    return true;
+}
+
+int Run(const Options& options, std::ostream& standardOutput) {
+    ConfigManager configManager;
+    if (std::filesystem::exists(options.configPath)) {
+        if (!configManager.LoadConfig(options.configPath)) {
+            std::cerr << "transcribe-cli: could not load " << options.configPath << std::endl;
+            return 1;
+        }
+    } else {
+        std::cerr << "transcribe-cli: " << options.configPath << " not found, using defaults" << std::endl;
+    }
+    ConfigManager::AppConfig& config = configManager.GetConfig();
+    SimpleLogger::SetLevel(SimpleLogger::ParseLevel(config.logLevel, SimpleLogger::Level::Info));
+
+    SpeechRecognition::SpeechConfig speechConfig = config.speechConfig;
+    if (!options.endpoint.empty()) {
+        speechConfig.endpoint = options.endpoint;
+        speechConfig.deployments.clear();
+    }
+    if (!options.apiKey.empty()) {
+        speechConfig.apiKey = options.apiKey;
+    }
+    if (speechConfig.provider != SpeechRecognition::Provider::AzureOpenAI) {
+        std::cerr << "transcribe-cli: only the azure-openai provider reports timed segments" << std::endl;
+    }
+
+    // Output
+    std::ofstream outputFile;
+    std::ostream* output = &standardOutput;
+    if (options.outputPath != "-") {
+        outputFile.open(options.outputPath, std::ios::binary | std::ios::trunc);
+        if (!outputFile) {
+            std::cerr << "transcribe-cli: cannot create " << options.outputPath << std::endl;
+            return 1;
+        }
+        output = &outputFile;
+    }
+    TranscriptSink sink(*output);
+
+    // Packets fed to the pipeline can be recorded as a trace with synthetic
+    // arrival times (microseconds of audio), to replay later with --trace
+    CaptureTraceWriter traceWriter;
+    if (!options.recordTracePath.empty() && !traceWriter.Open(options.recordTracePath, 1000000)) {
+        std::cerr << "transcribe-cli: cannot create " << options.recordTracePath << std::endl;
+        return 1;
+    }
+
+    auto latency = std::make_shared<PipelineLatency>();
+
+    SpeechRecognition speechRecognition;
+    speechRecognition.SetLatencyTracker(latency);
+    speechRecognition.SetSegmentCallback([&sink](const SpeechRecognition::TranscriptSegment& segment) { sink.Write(segment); });
+    speechRecognition.SetRecoveredCallback([&sink](const SpeechRecognition::RecoveredTranscript& transcript) {
+        sink.WriteRecovered(transcript);
+    });
+    if (!speechRecognition.Initialize(speechConfig)) {
+        std::cerr << "transcribe-cli: speech provider failed to initialize (check the endpoint and API key)" << std::endl;
+        return 1;
+    }
+
+    uint64_t framesFed = 0;
+    AudioDataCallback deliver = [&](const std::vector<uint8_t>& audio, const AudioFormat& format) {
+        size_t frameBytes = static_cast<size_t>(format.channels) * (format.bitsPerSample / 8);
+        uint32_t frames = frameBytes > 0 ? static_cast<uint32_t>(audio.size() / frameBytes) : 0;
+        if (traceWriter.IsOpen() && format.sampleRate > 0) {
+            traceWriter.WritePacket(format, audio.data(), static_cast<uint32_t>(audio.size()), frames, 0,
+                                    framesFed * 1000000 / format.sampleRate);
+        }
+        framesFed += frames;
+
+        speechRecognition.ProcessAudioData(audio, format);
+        speechRecognition.WaitForUploads(options.maxPending);
+    };
+
+    auto started = std::chrono::steady_clock::now();
+    double audioSeconds = 0.0;
+    bool fed = options.trace ? FeedCaptureTrace(options, deliver, audioSeconds)
+                             : FeedAudioStream(options, deliver, audioSeconds);
+    if (!fed) {
+        return 1;
+    }
+    traceWriter.Close();
+
+    speechRecognition.Flush();
+    speechRecognition.WaitForUploads(0);
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    SpeechRecognition::VadStats vad = speechRecognition.GetVadStats();
+    std::cerr << "transcribe-cli: " << audioSeconds << " s of audio in " << wallSeconds << " s ("
+              << (wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0) << "x real time), "
+              << sink.GetSegmentCount() << " segments";
+    if (sink.GetRecoveredCount() > 0) {
+        std::cerr << ", " << sink.GetRecoveredCount() << " recovered from an earlier run";
+    }
+    if (vad.enabled) {
+        std::cerr << ", " << vad.packetsSkipped << " of " << (vad.packetsSkipped + vad.packetsForwarded)
+                  << " packets skipped as silence";
+    }
+    std::cerr << std::endl;
+
+    std::string latencyText = latency->FormatStatus();
+    if (!latencyText.empty()) {
+        std::cerr << "transcribe-cli: " << latencyText << std::endl;
+    }
+    for (const auto& deployment : speechRecognition.GetDeploymentStats()) {
+        std::cerr << "transcribe-cli: deployment " << deployment.name << " (weight " << deployment.weight << "): "
+                  << deployment.requests << " requests, " << deployment.succeeded << " ok, " << deployment.throttled
+                  << " throttled, " << deployment.failed << " failed (" << deployment.errorRate * 100.0 << "% errors), "
+                  << deployment.succeededPerMinute << " per minute, " << deployment.bytesPerSecond / 1000.0 << " KB/s, "
+                  << deployment.latencyMs << " ms latency" << std::endl;
+    }
+    if (!options.metricsPath.empty() && !latency->WriteMetricsFile(options.metricsPath)) {
+        std::cerr << "transcribe-cli: cannot write " << options.metricsPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    // JSON goes to the real stdout; anything the pipeline prints goes to stderr
+    std::ostream standardOutput(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    SimpleLogger::Settings logSettings;
+    logSettings.filePath = options.logPath;
+    logSettings.console = false;
+    SimpleLogger::Initialize(logSettings);
+
+    TimelineTrace::SetThreadName("Input");
+    if (!options.timelinePath.empty() && !TimelineTrace::Start(options.timelinePath)) {
+        std::cerr << "transcribe-cli: cannot create " << options.timelinePath << std::endl;
+        SimpleLogger::Close();
+        return 1;
+    }
+
+    int result = Run(options, standardOutput);
+
+    TimelineTrace::Stop();
+    SimpleLogger::Close();
+    return result;
+}
@@ -1,5 +1,6 @@
 #include "AudioCapture.h"
 #include "SimpleLogger.h"
+#include "TimelineTrace.h"
 #include <iostream>
 #include <chrono>
 
@@ -11,6 +12,9 @@ const IID IID_IMMDeviceEnumerator = __uuidof(IMMDeviceEnumerator);
 const IID IID_IAudioClient = __uuidof(IAudioClient);
 const IID IID_IAudioCaptureClient = __uuidof(IAudioCaptureClient);
 
+// About 2.7 seconds of 48 kHz stereo float audio between capture and processing
+const size_t PACKET_RING_BYTES = 1 << 20;
+
 AudioCapture::AudioCapture()
     : deviceEnumerator(nullptr)
     , audioDevice(nullptr)
@@ -18,13 +22,27 @@ AudioCapture::AudioCapture()
     , captureClient(nullptr)
     , waveFormat(nullptr)
     , isCapturing(false)
+    , packetRing(PACKET_RING_BYTES)
+    , packetEvent(CreateEvent(nullptr, FALSE, FALSE, nullptr))
+    , ringOverruns(0)
+    , ringHighWater(0)
 {
     memset(&stats, 0, sizeof(stats));
+    stats.ringCapacityBytes = static_cast<UINT32>(packetRing.Capacity());
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    counterFrequency = static_cast<UINT64>(frequency.QuadPart);
 }
 
 AudioCapture::~AudioCapture() {
     StopCapture();
     Cleanup();
+
+    if (packetEvent) {
+        CloseHandle(packetEvent);
+        packetEvent = nullptr;
+    }
 }
 
 HRESULT AudioCapture::Initialize(AudioQuality quality) {
@@ -142,7 +160,16 @@ HRESULT AudioCapture::StartCapture() {
         return hr;
     }
 
+    // Preallocate the dispatch buffer so the processing thread never reallocates
+    audioBuffer.reserve(packetRing.Capacity());
+
+    // Timestamps are QueryPerformanceCounter ticks, so the trace carries their frequency
+    if (!tracePath.empty()) {
+        traceWriter.Open(tracePath, counterFrequency);
+    }
+
     isCapturing.store(true);
+    processingThread = std::thread(&AudioCapture::ProcessingThreadProc, this);
     captureThread = std::thread(&AudioCapture::CaptureThreadProc, this);
 
     INFO_LOG("Audio capture started successfully");
@@ -161,6 +188,13 @@ void AudioCapture::StopCapture() {
         captureThread.join();
     }
 
+    // Processing thread drains what is left in the ring before exiting
+    SetEvent(packetEvent);
+    if (processingThread.joinable()) {
+        processingThread.join();
+    }
+    traceWriter.Close();
+
     if (audioClient) {
         audioClient->Stop();
     }
@@ -172,19 +206,32 @@ void AudioCapture::SetAudioDataCallback(AudioDataCallback callback) {
     audioCallback = callback;
 }
 
+void AudioCapture::SetTraceFile(const std::string& path) {
+    tracePath = path;
+}
+
+void AudioCapture::SetLatencyTracker(std::shared_ptr<PipelineLatency> tracker) {
+    latency = tracker;
+}
+
 AudioCapture::AudioFormat AudioCapture::GetAudioFormat() const {
     return currentFormat;
 }
 
 AudioCapture::CaptureStats AudioCapture::GetCaptureStats() const {
     std::lock_guard<std::mutex> lock(statsMutex);
+    stats.ringOccupancyBytes = static_cast<UINT32>(packetRing.Size());
+    stats.ringHighWaterBytes = ringHighWater.load();
+    stats.ringOverruns = ringOverruns.load();
     return stats;
 }
 
 void AudioCapture::CaptureThreadProc() {
+    TimelineTrace::SetThreadName("Capture");
     auto startTime = std::chrono::high_resolution_clock::now();
 
     while (isCapturing.load()) {
+        TimelineTrace::Scope iteration("CaptureIteration");
         UINT32 packetLength = 0;
         HRESULT hr = captureClient->GetNextPacketSize(&packetLength);
         
@@ -227,16 +274,15 @@ void AudioCapture::CaptureThreadProc() {
         }
 
         // Small sleep to avoid consuming too much CPU
+        iteration.End();
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
 
+// Runs on the capture thread: only copies the packet into the ring
 void AudioCapture::ProcessAudioData(BYTE* audioData, UINT32 numFrames, DWORD flags) {
     if (!audioData || numFrames == 0) {
-        static int emptyCount = 0;
-        if (++emptyCount <= 10) { // Only log first 10 empty calls
-            WARN_LOG("AudioCapture::ProcessAudioData - Empty data: audioData=" + std::string(audioData ? "valid" : "null") + ", numFrames=" + std::to_string(numFrames));
-        }
+        LOG_RATE_LIMITED(Warn, 10, 10000, "AudioCapture::ProcessAudioData - Empty data: audioData=" + std::string(audioData ? "valid" : "null") + ", numFrames=" + std::to_string(numFrames));
         return;
     }
 
@@ -244,32 +290,98 @@ void AudioCapture::ProcessAudioData(BYTE* audioData, UINT32 numFrames, DWORD fla
     UINT32 bytesPerFrame = currentFormat.channels * (currentFormat.bitsPerSample / 8);
     UINT32 totalBytes = numFrames * bytesPerFrame;
 
-    AUDIO_LOG("AudioCapture", totalBytes, "Frames: " + std::to_string(numFrames) + ", Flags: " + std::to_string(flags));
+    LARGE_INTEGER arrival;
+    QueryPerformanceCounter(&arrival);
+
+    PacketHeader header;
+    header.payloadBytes = totalBytes;
+    header.numFrames = numFrames;
+    header.flags = flags;
+    header.timestamp = static_cast<UINT64>(arrival.QuadPart);
+
+    // Silent packets are stored without payload
+    bool silent = (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0;
+    bool written = packetRing.TryWrite(reinterpret_cast<const BYTE*>(&header), sizeof(header),
+                                       silent ? nullptr : audioData, silent ? 0 : totalBytes);
+    if (!written) {
+        // Processing thread is behind; drop the packet rather than stall WASAPI
+        ringOverruns.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    UINT32 occupancy = static_cast<UINT32>(packetRing.Size());
+    if (occupancy > ringHighWater.load(std::memory_order_relaxed)) {
+        ringHighWater.store(occupancy, std::memory_order_relaxed);
+    }
+
+    SetEvent(packetEvent);
+}
+
+void AudioCapture::ProcessingThreadProc() {
+    TimelineTrace::SetThreadName("Audio processing");
+    while (true) {
+        WaitForSingleObject(packetEvent, 100);
+
+        while (DispatchNextPacket()) {
+        }
+
+        // Exit only after the capture thread is gone and the ring is drained
+        if (!isCapturing.load() && packetRing.IsEmpty()) {
+            break;
+        }
+    }
+}
+
+// Runs on the processing thread: pops one packet and forwards it downstream
+bool AudioCapture::DispatchNextPacket() {
+    PacketHeader header;
+    if (!packetRing.Peek(reinterpret_cast<BYTE*>(&header), sizeof(header))) {
+        return false;
+    }
+    packetRing.Skip(sizeof(header));
+    TRACE_SCOPE("DispatchPacket");
+
+    bool silent = (header.flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0;
+
+    AUDIO_LOG("AudioCapture", header.payloadBytes, "Frames: " + std::to_string(header.numFrames) + ", Flags: " + std::to_string(header.flags));
 
     // Handle silence flag
-    if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+    if (silent) {
         // Buffer contains silence, we can either skip it or fill with zeros
-        audioBuffer.assign(totalBytes, 0);
+        audioBuffer.assign(header.payloadBytes, 0);
         DEBUG_LOG("AudioCapture - Silent buffer detected, filling with zeros");
     } else {
-        // Copy audio data to our buffer
-        audioBuffer.assign(audioData, audioData + totalBytes);
-        DEBUG_LOG("AudioCapture - Copied " + std::to_string(totalBytes) + " bytes of audio data");
+        // Header and payload are published together, so the payload is there
+        audioBuffer.resize(header.payloadBytes);
+        packetRing.TryRead(audioBuffer.data(), header.payloadBytes);
+        DEBUG_LOG("AudioCapture - Copied " + std::to_string(header.payloadBytes) + " bytes of audio data");
+    }
+
+    if (latency) {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        UINT64 waited = static_cast<UINT64>(now.QuadPart) - header.timestamp;
+        latency->Record(PipelineLatency::Stage::Capture,
+                        std::chrono::microseconds(waited * 1000000 / counterFrequency));
+    }
+
+    if (traceWriter.IsOpen()) {
+        traceWriter.WritePacket(currentFormat, audioBuffer.data(), header.payloadBytes, header.numFrames,
+                                header.flags, header.timestamp);
     }
 
     // Update statistics
-    UpdateStats(numFrames, totalBytes);
+    UpdateStats(header.numFrames, header.payloadBytes);
 
     // Call the callback if set
     if (audioCallback) {
         DEBUG_LOG("AudioCapture calling audio callback with " + std::to_string(audioBuffer.size()) + " bytes");
         audioCallback(audioBuffer, currentFormat);
     } else {
-        static int noCallbackCount = 0;
-        if (++noCallbackCount <= 5) { // Only warn first 5 times
-            WARN_LOG("AudioCapture - No audio callback set, data not forwarded");
-        }
+        LOG_RATE_LIMITED(Warn, 5, 10000, "AudioCapture - No audio callback set, data not forwarded");
     }
+
+    return true;
 }
 
 void AudioCapture::UpdateStats(UINT32 framesProcessed, UINT32 bytesProcessed) {
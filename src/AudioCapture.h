@@ -10,6 +10,10 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include "AudioFormat.h"
+#include "CaptureTrace.h"
+#include "PipelineLatency.h"
+#include "SpscRingBuffer.h"
 
 class AudioCapture {
 public:
@@ -19,12 +23,7 @@ public:
         High = 44100
     };
 
-    struct AudioFormat {
-        UINT32 sampleRate;
-        UINT16 channels;
-        UINT16 bitsPerSample;
-        UINT32 bytesPerSecond;
-    };
+    using AudioFormat = ::AudioFormat;
 
     using AudioDataCallback = std::function<void(const std::vector<BYTE>&, const AudioFormat&)>;
 
@@ -38,11 +37,25 @@ public:
     void SetAudioDataCallback(AudioDataCallback callback);
     AudioFormat GetAudioFormat() const;
 
+    // Record every dispatched packet to a capture trace from the next
+    // StartCapture on; an empty path turns recording off
+    void SetTraceFile(const std::string& path);
+
+    // Record how long packets wait between the capture and processing
+    // threads; set before StartCapture
+    void SetLatencyTracker(std::shared_ptr<PipelineLatency> tracker);
+
     struct CaptureStats {
         UINT64 totalFramesCaptured;
         UINT64 totalBytesProcessed;
         double captureTimeSeconds;
         UINT32 bufferUnderruns;
+
+        // Packet ring between the capture thread and the processing thread
+        UINT32 ringCapacityBytes;
+        UINT32 ringOccupancyBytes;
+        UINT32 ringHighWaterBytes;
+        UINT64 ringOverruns;        // Packets dropped because the ring was full
     };
     CaptureStats GetCaptureStats() const;
 
@@ -55,17 +68,40 @@ private:
 
     std::atomic<bool> isCapturing;
     std::thread captureThread;
+    std::thread processingThread;
     mutable std::mutex statsMutex;
 
+    // Header written in front of every packet in the ring. Silent packets carry
+    // no payload; the processing thread expands them to zeros.
+    struct PacketHeader {
+        UINT32 payloadBytes;
+        UINT32 numFrames;
+        DWORD flags;
+        UINT64 timestamp;       // QueryPerformanceCounter ticks at arrival
+    };
+
+    // The capture thread only writes packets here; everything downstream runs
+    // on the processing thread
+    SpscRingBuffer<BYTE> packetRing;
+    HANDLE packetEvent;
+    std::atomic<UINT64> ringOverruns;
+    std::atomic<UINT32> ringHighWater;
+
     AudioDataCallback audioCallback;
+    std::string tracePath;
+    CaptureTraceWriter traceWriter;     // Processing thread while capturing
+    std::shared_ptr<PipelineLatency> latency;
+    UINT64 counterFrequency;            // QueryPerformanceCounter ticks per second
     std::vector<BYTE> audioBuffer;
     AudioFormat currentFormat;
     mutable CaptureStats stats;
 
     void CaptureThreadProc();
+    void ProcessingThreadProc();
     void ProcessAudioData(BYTE* audioData, UINT32 numFrames, DWORD flags);
+    bool DispatchNextPacket();
     void UpdateStats(UINT32 framesProcessed, UINT32 bytesProcessed);
     void Cleanup();
     HRESULT InitializeAudioClient(AudioQuality quality);
     void ConvertWaveFormatToAudioFormat(const WAVEFORMATEX* wfx, AudioFormat& format);
-};
+};
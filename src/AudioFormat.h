@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of interleaved PCM audio as it moves through the pipeline. 32-bit
+// samples are float, 16-bit samples are signed integers.
+struct AudioFormat {
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint16_t bitsPerSample;
+    uint32_t bytesPerSecond;
+};
@@ -0,0 +1,72 @@
+#include "AudioHistoryBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+AudioHistoryBuffer::AudioHistoryBuffer()
+    : retainedBytes(0)
+    , reservedPosition(0)
+    , writtenPosition(0)
+{
+}
+
+void AudioHistoryBuffer::Reset(size_t retainedBytes, size_t guardBytes) {
+    this->retainedBytes = retainedBytes;
+    ring.assign(retainedBytes + guardBytes, 0);
+    reservedPosition.store(0);
+    writtenPosition.store(0);
+}
+
+void AudioHistoryBuffer::Write(const uint8_t* data, size_t size) {
+    size_t capacity = ring.size();
+    if (capacity == 0 || size == 0) {
+        return;
+    }
+
+    uint64_t start = writtenPosition.load(std::memory_order_relaxed);
+    if (size > capacity) {
+        data += size - capacity;
+        start += size - capacity;
+        size = capacity;
+    }
+    uint64_t end = start + size;
+
+    // Readers validating a snapshot see the reservation before any byte changes
+    reservedPosition.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t offset = static_cast<size_t>(start % capacity);
+    size_t firstPart = std::min(size, capacity - offset);
+    memcpy(ring.data() + offset, data, firstPart);
+    memcpy(ring.data(), data + firstPart, size - firstPart);
+
+    writtenPosition.store(end, std::memory_order_release);
+}
+
+AudioHistoryBuffer::Snapshot AudioHistoryBuffer::Acquire() const {
+    Snapshot snapshot = {};
+    size_t capacity = ring.size();
+    if (capacity == 0) {
+        return snapshot;
+    }
+
+    uint64_t end = writtenPosition.load(std::memory_order_acquire);
+    size_t size = static_cast<size_t>(std::min<uint64_t>(end, retainedBytes));
+    snapshot.startPosition = end - size;
+
+    size_t offset = static_cast<size_t>(snapshot.startPosition % capacity);
+    snapshot.first = ring.data() + offset;
+    snapshot.firstSize = std::min(size, capacity - offset);
+    snapshot.second = ring.data();
+    snapshot.secondSize = size - snapshot.firstSize;
+    return snapshot;
+}
+
+bool AudioHistoryBuffer::IsIntact(const Snapshot& snapshot) const {
+    // Order the reads of the spans before the check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return reservedPosition.load(std::memory_order_relaxed) <= snapshot.startPosition + ring.size();
+}
+
+size_t AudioHistoryBuffer::Size() const {
+    return static_cast<size_t>(std::min<uint64_t>(writtenPosition.load(std::memory_order_acquire), retainedBytes));
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity history of the most recent audio bytes for export. One thread
+// writes; any thread can take a snapshot without locking. A snapshot points
+// straight into the ring as two spans, so the writer never waits on a reader.
+// The reader checks afterwards that the writer has not lapped the snapshot;
+// guard space beyond the retained length gives it time to finish.
+class AudioHistoryBuffer {
+public:
+    struct Snapshot {
+        const uint8_t* first;
+        size_t firstSize;
+        const uint8_t* second;        // Wrapped part, empty if the data is contiguous
+        size_t secondSize;
+        uint64_t startPosition;       // Stream offset of the first byte
+
+        size_t Size() const { return firstSize + secondSize; }
+    };
+
+    AudioHistoryBuffer();
+
+    // Allocate for retainedBytes plus guardBytes and forget the old contents.
+    // Only call while nothing is writing or reading.
+    void Reset(size_t retainedBytes, size_t guardBytes);
+
+    // Writer thread only. O(size); the oldest bytes are overwritten.
+    void Write(const uint8_t* data, size_t size);
+
+    // Up to the last retainedBytes written
+    Snapshot Acquire() const;
+
+    // True if no byte of the snapshot has been overwritten since Acquire.
+    // Call after the spans have been consumed.
+    bool IsIntact(const Snapshot& snapshot) const;
+
+    size_t Size() const;
+    size_t RetainedBytes() const { return retainedBytes; }
+
+private:
+    std::vector<uint8_t> ring;
+    size_t retainedBytes;
+
+    // Stream positions: reserved moves before a write touches the ring, written after
+    std::atomic<uint64_t> reservedPosition;
+    std::atomic<uint64_t> writtenPosition;
+};
@@ -0,0 +1,95 @@
+#include "BandwidthEstimator.h"
+#include <algorithm>
+
+namespace {
+
+const size_t MIN_SAMPLE_BYTES = 4096;
+const double MIN_SAMPLE_SECONDS = 0.001;   // Faster than this is the socket buffer, not the link
+const double ENCODED_RATE_SMOOTHING = 0.2;
+
+} // namespace
+
+// BandwidthEstimator
+
+BandwidthEstimator::BandwidthEstimator(double smoothing)
+    : smoothing(std::min(1.0, std::max(0.01, smoothing)))
+    , bytes(0.0)
+    , seconds(0.0)
+    , samples(0)
+{
+}
+
+void BandwidthEstimator::RecordSend(size_t sentBytes, std::chrono::steady_clock::duration elapsed) {
+    if (sentBytes < MIN_SAMPLE_BYTES) {
+        return;
+    }
+    double sampleSeconds = std::max(MIN_SAMPLE_SECONDS, std::chrono::duration<double>(elapsed).count());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    double keep = samples == 0 ? 0.0 : 1.0 - smoothing;
+    bytes = keep * bytes + static_cast<double>(sentBytes);
+    seconds = keep * seconds + sampleSeconds;
+    samples++;
+}
+
+double BandwidthEstimator::GetBytesPerSecond() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return seconds > 0.0 ? bytes / seconds : 0.0;
+}
+
+uint64_t BandwidthEstimator::GetSampleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return samples;
+}
+
+// UploadFormatLadder
+
+UploadFormatLadder::UploadFormatLadder(Level top)
+    : UploadFormatLadder(top, Settings())
+{
+}
+
+UploadFormatLadder::UploadFormatLadder(Level top, const Settings& settings)
+    : settings(settings)
+    , top(top)
+    , level(top)
+{
+    // Until chunks are encoded: 16-bit mono PCM, and FLAC at a typical speech ratio
+    encodedRates[static_cast<int>(Level::Wav16k)] = 32000.0;
+    encodedRates[static_cast<int>(Level::Flac16k)] = 32000.0 * 0.6;
+    encodedRates[static_cast<int>(Level::Flac8k)] = 16000.0 * 0.6;
+}
+
+void UploadFormatLadder::RecordEncoded(Level at, size_t bytes, double audioSeconds) {
+    if (audioSeconds <= 0.0) {
+        return;
+    }
+    double& rate = encodedRates[static_cast<int>(at)];
+    rate += ENCODED_RATE_SMOOTHING * (bytes / audioSeconds - rate);
+}
+
+UploadFormatLadder::Level UploadFormatLadder::Select(double bytesPerSecond, std::chrono::steady_clock::time_point now) {
+    if (bytesPerSecond <= 0.0) {
+        return level;
+    }
+
+    int current = static_cast<int>(level);
+    if (current < LEVEL_COUNT - 1 && bytesPerSecond < settings.stepDownHeadroom * encodedRates[current]) {
+        level = static_cast<Level>(current + 1);
+        lastChange = now;
+    } else if (current > static_cast<int>(top) && now - lastChange >= settings.holdTime &&
+               bytesPerSecond >= settings.stepUpHeadroom * encodedRates[current - 1]) {
+        level = static_cast<Level>(current - 1);
+        lastChange = now;
+    }
+    return level;
+}
+
+const char* UploadFormatLadder::LevelName(Level level) {
+    switch (level) {
+        case Level::Wav16k: return "16 kHz WAV";
+        case Level::Flac16k: return "16 kHz FLAC";
+        case Level::Flac8k: return "8 kHz FLAC";
+    }
+    return "unknown";
+}
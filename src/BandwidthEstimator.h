@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Upload throughput over the request bodies the provider sends: bytes and
+// seconds are smoothed separately, so a body that took long to send counts
+// for more than one the socket took at once. Fed by the upload workers and
+// read by the audio thread.
+class BandwidthEstimator {
+public:
+    // smoothing is the weight of each new sample (0-1]
+    explicit BandwidthEstimator(double smoothing = 0.3);
+
+    // A request body of sentBytes took elapsed to deliver. Bodies of a few
+    // KB leave too little to time and are ignored.
+    void RecordSend(size_t sentBytes, std::chrono::steady_clock::duration elapsed);
+
+    // Smoothed bytes per second; 0 until the first sample
+    double GetBytesPerSecond() const;
+    uint64_t GetSampleCount() const;
+
+private:
+    mutable std::mutex mutex;
+    double smoothing;
+    double bytes;
+    double seconds;
+    uint64_t samples;
+};
+
+// Picks the encoding for the next upload from the measured send rate. Steps
+// one level down (16 kHz WAV -> 16 kHz FLAC -> 8 kHz FLAC) as soon as the
+// rate gives less than stepDownHeadroom times what the current level needs
+// per second of audio, and back up, never past the configured level, once the
+// level above would still have stepUpHeadroom and holdTime has passed since
+// the last change. Audio thread only.
+class UploadFormatLadder {
+public:
+    enum class Level { Wav16k, Flac16k, Flac8k };
+
+    struct Settings {
+        double stepDownHeadroom = 1.5;
+        double stepUpHeadroom = 3.0;
+        std::chrono::milliseconds holdTime = std::chrono::milliseconds(15000);
+    };
+
+    explicit UploadFormatLadder(Level top);
+    UploadFormatLadder(Level top, const Settings& settings);
+
+    // Bytes a chunk of audioSeconds took at level, so FLAC's variable ratio
+    // is what the headroom is measured against
+    void RecordEncoded(Level level, size_t bytes, double audioSeconds);
+
+    // Level for the next chunk; bytesPerSecond 0 (not measured yet) keeps the current one
+    Level Select(double bytesPerSecond, std::chrono::steady_clock::time_point now);
+
+    Level GetLevel() const { return level; }
+    double GetBytesPerAudioSecond(Level at) const { return encodedRates[static_cast<int>(at)]; }
+
+    static const char* LevelName(Level level);
+    static uint32_t SampleRate(Level level) { return level == Level::Flac8k ? 8000 : 16000; }
+    static bool IsFlac(Level level) { return level != Level::Wav16k; }
+
+private:
+    static const int LEVEL_COUNT = 3;
+
+    Settings settings;
+    Level top;
+    Level level;
+    double encodedRates[LEVEL_COUNT];
+    std::chrono::steady_clock::time_point lastChange;
+};
@@ -0,0 +1,35 @@
+#include "CancellationToken.h"
+
+void CancellationToken::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cancelled.exchange(true)) {
+        return;
+    }
+    // Under the lock so Unregister cannot return while a callback still runs
+    for (auto& callback : callbacks) {
+        callback.second();
+    }
+    callbacks.clear();
+    condition.notify_all();
+}
+
+bool CancellationToken::WaitFor(std::chrono::milliseconds delay) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return !condition.wait_for(lock, delay, [this] { return cancelled.load(); });
+}
+
+uint64_t CancellationToken::Register(Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cancelled.load()) {
+        callback();
+        return 0;
+    }
+    uint64_t id = nextId++;
+    callbacks[id] = std::move(callback);
+    return id;
+}
+
+void CancellationToken::Unregister(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    callbacks.erase(id);
+}
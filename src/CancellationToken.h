@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+// One-shot signal that abandons a piece of work, e.g. the uploads in flight
+// when recording stops. Workers poll IsCancelled, sleep with WaitFor, or
+// register a callback that interrupts a blocking call.
+class CancellationToken {
+public:
+    using Callback = std::function<void()>;
+
+    CancellationToken() : cancelled(false), nextId(1) {}
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    // Wakes waiters and runs registered callbacks; later calls do nothing
+    void Cancel();
+
+    bool IsCancelled() const { return cancelled.load(std::memory_order_acquire); }
+
+    // Sleep for delay; false if cancelled first
+    bool WaitFor(std::chrono::milliseconds delay);
+
+    // Callbacks run on the thread that cancels, and at once if already
+    // cancelled. They must not register or unregister.
+    uint64_t Register(Callback callback);
+
+    // Once this returns the callback is not running and will not run
+    void Unregister(uint64_t id);
+
+    // Registers for the lifetime of a scope; token may be null
+    class Registration {
+    public:
+        Registration(CancellationToken* token, Callback callback)
+            : token(token), id(token ? token->Register(std::move(callback)) : 0) {}
+        ~Registration() {
+            if (token) {
+                token->Unregister(id);
+            }
+        }
+
+        Registration(const Registration&) = delete;
+        Registration& operator=(const Registration&) = delete;
+
+    private:
+        CancellationToken* token;
+        uint64_t id;
+    };
+
+private:
+    std::atomic<bool> cancelled;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::map<uint64_t, Callback> callbacks;
+    uint64_t nextId;
+};
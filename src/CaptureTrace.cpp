@@ -0,0 +1,288 @@
+#include "CaptureTrace.h"
+#include "SimpleLogger.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+const char TRACE_MAGIC[4] = {'A', 'C', 'T', 'R'};
+const uint16_t TRACE_VERSION = 1;
+const size_t FILE_HEADER_BYTES = 16;
+const size_t RECORD_HEADER_BYTES = 24;
+const size_t FORMAT_BYTES = 12;
+const size_t WRITE_BUFFER_BYTES = 256 * 1024;
+const uint32_t MAX_RECORD_BYTES = 64 * 1024 * 1024;    // Anything larger is corruption
+
+void PutUInt16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void PutUInt32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void PutUInt64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint16_t GetUInt16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t GetUInt32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+uint64_t GetUInt64(const uint8_t* data) {
+    return static_cast<uint64_t>(GetUInt32(data)) | (static_cast<uint64_t>(GetUInt32(data + 4)) << 32);
+}
+
+bool SameFormat(const AudioFormat& a, const AudioFormat& b) {
+    return a.sampleRate == b.sampleRate && a.channels == b.channels && a.bitsPerSample == b.bitsPerSample &&
+           a.bytesPerSecond == b.bytesPerSecond;
+}
+
+} // namespace
+
+// CaptureTraceWriter
+
+CaptureTraceWriter::CaptureTraceWriter() : lastFormat(), haveFormat(false), packetCount(0) {
+}
+
+CaptureTraceWriter::~CaptureTraceWriter() {
+    Close();
+}
+
+bool CaptureTraceWriter::Open(const std::string& path, uint64_t ticksPerSecond) {
+    Close();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        ERROR_LOG("CaptureTraceWriter: cannot create " + path);
+        return false;
+    }
+
+    buffer.clear();
+    buffer.reserve(WRITE_BUFFER_BYTES + RECORD_HEADER_BYTES);
+    buffer.insert(buffer.end(), TRACE_MAGIC, TRACE_MAGIC + 4);
+    PutUInt16(buffer, TRACE_VERSION);
+    PutUInt16(buffer, 0);
+    PutUInt64(buffer, ticksPerSecond);
+
+    haveFormat = false;
+    packetCount = 0;
+    INFO_LOG("CaptureTraceWriter: recording capture trace to " + path);
+    return true;
+}
+
+bool CaptureTraceWriter::WritePacket(const AudioFormat& format, const uint8_t* data, uint32_t bytes,
+                                     uint32_t numFrames, uint32_t flags, uint64_t timestamp) {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    if (!haveFormat || !SameFormat(format, lastFormat)) {
+        std::vector<uint8_t> formatBytes;
+        PutUInt32(formatBytes, format.sampleRate);
+        PutUInt16(formatBytes, format.channels);
+        PutUInt16(formatBytes, format.bitsPerSample);
+        PutUInt32(formatBytes, format.bytesPerSecond);
+        AppendRecord(CaptureTrace::RECORD_FORMAT, formatBytes.data(), FORMAT_BYTES, 0, 0, timestamp);
+        lastFormat = format;
+        haveFormat = true;
+    }
+
+    bool silent = (flags & CaptureTrace::FLAG_SILENT) != 0;
+    AppendRecord(CaptureTrace::RECORD_PACKET, silent ? nullptr : data, silent ? 0 : bytes, numFrames, flags, timestamp);
+    packetCount++;
+
+    return buffer.size() < WRITE_BUFFER_BYTES || FlushBuffer();
+}
+
+void CaptureTraceWriter::Close() {
+    if (!file.is_open()) {
+        return;
+    }
+    FlushBuffer();
+    file.close();
+    INFO_LOG("CaptureTraceWriter: closed after " + std::to_string(packetCount) + " packets");
+}
+
+void CaptureTraceWriter::AppendRecord(uint32_t type, const uint8_t* data, uint32_t bytes, uint32_t numFrames,
+                                      uint32_t flags, uint64_t timestamp) {
+    PutUInt32(buffer, type);
+    PutUInt32(buffer, bytes);
+    PutUInt32(buffer, numFrames);
+    PutUInt32(buffer, flags);
+    PutUInt64(buffer, timestamp);
+    if (bytes > 0) {
+        buffer.insert(buffer.end(), data, data + bytes);
+    }
+}
+
+bool CaptureTraceWriter::FlushBuffer() {
+    if (!buffer.empty()) {
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+    if (!file) {
+        LOG_RATE_LIMITED(Error, 1, 10000, "CaptureTraceWriter: write failed, trace is incomplete");
+        return false;
+    }
+    return true;
+}
+
+// CaptureTraceReader
+
+CaptureTraceReader::CaptureTraceReader() : ticksPerSecond(0), format(), haveFormat(false) {
+}
+
+bool CaptureTraceReader::Open(const std::string& path) {
+    file.close();
+    file.clear();
+    haveFormat = false;
+    error.clear();
+
+    file.open(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    uint8_t header[FILE_HEADER_BYTES];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (file.gcount() != static_cast<std::streamsize>(sizeof(header)) || std::memcmp(header, TRACE_MAGIC, 4) != 0) {
+        error = path + " is not a capture trace";
+        return false;
+    }
+    if (GetUInt16(header + 4) != TRACE_VERSION) {
+        error = path + " has unsupported trace version " + std::to_string(GetUInt16(header + 4));
+        return false;
+    }
+    ticksPerSecond = GetUInt64(header + 8);
+    if (ticksPerSecond == 0) {
+        error = path + " has no timestamp frequency";
+        return false;
+    }
+    return true;
+}
+
+bool CaptureTraceReader::Next(CaptureTrace::Packet& packet) {
+    while (file) {
+        uint8_t header[RECORD_HEADER_BYTES];
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (file.gcount() != static_cast<std::streamsize>(sizeof(header))) {
+            return false;
+        }
+
+        uint32_t type = GetUInt32(header);
+        uint32_t bytes = GetUInt32(header + 4);
+        if (bytes > MAX_RECORD_BYTES) {
+            error = "corrupt record (" + std::to_string(bytes) + " bytes)";
+            return false;
+        }
+
+        packet.payload.resize(bytes);
+        file.read(reinterpret_cast<char*>(packet.payload.data()), bytes);
+        if (file.gcount() != static_cast<std::streamsize>(bytes)) {
+            return false;
+        }
+
+        if (type == CaptureTrace::RECORD_FORMAT) {
+            if (bytes < FORMAT_BYTES) {
+                error = "corrupt format record";
+                return false;
+            }
+            format.sampleRate = GetUInt32(packet.payload.data());
+            format.channels = GetUInt16(packet.payload.data() + 4);
+            format.bitsPerSample = GetUInt16(packet.payload.data() + 6);
+            format.bytesPerSecond = GetUInt32(packet.payload.data() + 8);
+            haveFormat = true;
+            continue;
+        }
+        if (type != CaptureTrace::RECORD_PACKET) {
+            continue;   // Unknown record types are skipped
+        }
+        if (!haveFormat) {
+            error = "packet before the first format record";
+            return false;
+        }
+
+        packet.format = format;
+        packet.numFrames = GetUInt32(header + 8);
+        packet.flags = GetUInt32(header + 12);
+        packet.timestamp = GetUInt64(header + 16);
+        return true;
+    }
+    return false;
+}
+
+// CaptureTraceReplay
+
+CaptureTraceReplay::CaptureTraceReplay() : stopRequested(false) {
+}
+
+bool CaptureTraceReplay::Open(const std::string& path) {
+    return reader.Open(path);
+}
+
+void CaptureTraceReplay::SetAudioDataCallback(AudioDataCallback callback) {
+    audioCallback = callback;
+}
+
+CaptureTraceReplay::Stats CaptureTraceReplay::Run(Pacing pacing) {
+    Stats stats{};
+    stopRequested = false;
+
+    const double ticksPerSecond = static_cast<double>(reader.GetTicksPerSecond());
+    auto started = std::chrono::steady_clock::now();
+    uint64_t firstTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+
+    CaptureTrace::Packet packet;
+    while (!stopRequested.load() && reader.Next(packet)) {
+        if (stats.packets == 0) {
+            firstTimestamp = packet.timestamp;
+        }
+        lastTimestamp = packet.timestamp;
+
+        if (pacing == Pacing::Original) {
+            double offset = static_cast<double>(packet.timestamp - firstTimestamp) / ticksPerSecond;
+            std::this_thread::sleep_until(started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                        std::chrono::duration<double>(offset)));
+        }
+
+        // Expand silent packets to zeros, as AudioCapture does when it dispatches them
+        size_t frameBytes = static_cast<size_t>(packet.format.channels) * (packet.format.bitsPerSample / 8);
+        if ((packet.flags & CaptureTrace::FLAG_SILENT) != 0) {
+            audioBuffer.assign(static_cast<size_t>(packet.numFrames) * frameBytes, 0);
+        } else {
+            audioBuffer.swap(packet.payload);
+        }
+
+        if (audioCallback) {
+            audioCallback(audioBuffer, packet.format);
+        }
+
+        stats.packets++;
+        stats.bytes += audioBuffer.size();
+        if (packet.format.sampleRate > 0) {
+            stats.audioSeconds += static_cast<double>(packet.numFrames) / packet.format.sampleRate;
+        }
+    }
+
+    if (!reader.GetError().empty()) {
+        ERROR_LOG("CaptureTraceReplay: " + reader.GetError());
+    }
+
+    stats.traceSeconds = static_cast<double>(lastTimestamp - firstTimestamp) / ticksPerSecond;
+    stats.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
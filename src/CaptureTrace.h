@@ -0,0 +1,120 @@
+#pragma once
+
+#include "AudioFormat.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Binary record of the packets capture delivered, for replaying a session
+// through the pipeline without an audio device. Little-endian throughout:
+//
+//   file header  "ACTR", u16 version, u16 reserved, u64 timestamp ticks per second
+//   record       u32 type, u32 stored bytes, u32 frames, u32 flags, u64 timestamp, then the bytes
+//
+// A FORMAT record (u32 rate, u16 channels, u16 bits, u32 bytes/s) comes
+// before the first packet and whenever the format changes. Silent packets
+// store no bytes and replay as zeros, as the capture ring does.
+namespace CaptureTrace {
+
+const uint32_t RECORD_FORMAT = 0x544D5246;   // "FRMT"
+const uint32_t RECORD_PACKET = 0x544B4350;   // "PCKT"
+
+// Same value as AUDCLNT_BUFFERFLAGS_SILENT; other flags are stored as captured
+const uint32_t FLAG_SILENT = 0x2;
+
+struct Packet {
+    AudioFormat format;
+    uint32_t numFrames;
+    uint32_t flags;
+    uint64_t timestamp;                 // Arrival time in the trace's ticks
+    std::vector<uint8_t> payload;       // Empty for silent packets
+};
+
+} // namespace CaptureTrace
+
+// Appends packets to a trace file. Buffered; call from a single thread.
+class CaptureTraceWriter {
+public:
+    CaptureTraceWriter();
+    ~CaptureTraceWriter();
+
+    bool Open(const std::string& path, uint64_t ticksPerSecond);
+    bool WritePacket(const AudioFormat& format, const uint8_t* data, uint32_t bytes, uint32_t numFrames,
+                     uint32_t flags, uint64_t timestamp);
+    void Close();
+
+    bool IsOpen() const { return file.is_open(); }
+    uint64_t GetPacketCount() const { return packetCount; }
+
+private:
+    std::ofstream file;
+    std::vector<uint8_t> buffer;
+    AudioFormat lastFormat;
+    bool haveFormat;
+    uint64_t packetCount;
+
+    void AppendRecord(uint32_t type, const uint8_t* data, uint32_t bytes, uint32_t numFrames, uint32_t flags,
+                      uint64_t timestamp);
+    bool FlushBuffer();
+};
+
+// Reads packets back in order. A record cut short at the end of the file
+// (the recorder did not close cleanly) ends the trace without an error.
+class CaptureTraceReader {
+public:
+    CaptureTraceReader();
+
+    bool Open(const std::string& path);
+    bool Next(CaptureTrace::Packet& packet);
+
+    uint64_t GetTicksPerSecond() const { return ticksPerSecond; }
+    const std::string& GetError() const { return error; }
+
+private:
+    std::ifstream file;
+    uint64_t ticksPerSecond;
+    AudioFormat format;
+    bool haveFormat;
+    std::string error;
+};
+
+// Feeds a trace through the same callback AudioCapture uses, either at the
+// recorded pace or as fast as the callback returns. Run blocks until the
+// trace ends or Stop is called from another thread.
+class CaptureTraceReplay {
+public:
+    using AudioDataCallback = std::function<void(const std::vector<uint8_t>&, const AudioFormat&)>;
+
+    enum class Pacing {
+        Original,
+        AsFastAsPossible
+    };
+
+    struct Stats {
+        uint64_t packets;
+        uint64_t bytes;
+        double audioSeconds;            // Audio delivered, from the frame counts
+        double traceSeconds;            // First to last arrival timestamp
+        double wallSeconds;
+    };
+
+    CaptureTraceReplay();
+
+    bool Open(const std::string& path);
+    void SetAudioDataCallback(AudioDataCallback callback);
+
+    Stats Run(Pacing pacing);
+    void Stop() { stopRequested = true; }
+
+    const std::string& GetError() const { return reader.GetError(); }
+
+private:
+    CaptureTraceReader reader;
+    AudioDataCallback audioCallback;
+    std::atomic<bool> stopRequested;
+    std::vector<uint8_t> audioBuffer;
+};
@@ -84,6 +84,7 @@ bool ConfigManager::SaveConfig(const std::string& configPath) {
 
 void ConfigManager::SetSpeechConfig(const SpeechRecognition::SpeechConfig& speechConfig) {
     config.speechConfig = speechConfig;
+    config.outputFormat = speechConfig.outputFormat;
 }
 
 void ConfigManager::SetDefaultConfig() {
@@ -92,6 +93,9 @@ void ConfigManager::SetDefaultConfig() {
     config.outputFormat = "wav";
     config.outputDirectory = "./data/recordings";
     config.audioQuality = 16000;
+    config.audioHistorySeconds = 30;
+    config.recordSession = false;
+    config.maxSegmentMB = 2048;
 
     // Speech recognition
     config.speechConfig.provider = SpeechRecognition::Provider::Azure;
@@ -100,12 +104,39 @@ void ConfigManager::SetDefaultConfig() {
     config.speechConfig.language = "en-US";
     config.speechConfig.enablePunctuation = true;
     config.speechConfig.enableSpeakerDiarization = true;
+    config.speechConfig.enableVoiceActivityDetection = true;
+    config.speechConfig.minUtteranceMs = 1000;
+    config.speechConfig.maxUtteranceMs = 6000;
+    config.speechConfig.maxLatencyMs = 10000;
+    config.speechConfig.maxUploadAttempts = 3;
+    config.speechConfig.uploadDeadlineMs = 20000;
+    config.speechConfig.connectTimeoutMs = 5000;
+    config.speechConfig.sendTimeoutMs = 10000;
+    config.speechConfig.receiveTimeoutMs = 15000;
+    config.speechConfig.maxInFlightRequests = 2;
+    config.speechConfig.headOfLineMaxWaitMs = 5000;
+    config.speechConfig.outputFormat = config.outputFormat;
+#ifdef _WIN32
+    config.speechConfig.adaptiveUploadFormat = false;     // WinHTTP cannot time uploads
+#else
+    config.speechConfig.adaptiveUploadFormat = true;
+#endif
+    config.speechConfig.spoolPath = "./data/spool/uploads.spool";
+    config.speechConfig.spoolMaxMB = 64;
+    config.speechConfig.deployments.clear();
+    config.speechConfig.deploymentRouting = "latency";
 
     // UI settings
     config.minimizeToTray = true;
     config.showNotifications = true;
     config.theme = "system";
 
+    // Logging
+    config.logLevel = "debug";
+    config.captureTracePath = "";
+    config.latencyMetricsPath = "latency-metrics.json";
+    config.timelineTracePath = "";
+
     // Privacy settings
     config.requireConsent = true;
     config.dataRetentionDays = 30;
@@ -128,7 +159,9 @@ bool ConfigManager::ParseJsonConfig(const std::string& jsonContent) {
                 config.autoStartRecording = recording["autoStart"].get<bool>();
             }
             if (recording.contains("outputFormat")) {
+                // Also the format of the uploaded chunks
                 config.outputFormat = recording["outputFormat"].get<std::string>();
+                config.speechConfig.outputFormat = config.outputFormat;
             }
             if (recording.contains("outputDirectory")) {
                 config.outputDirectory = recording["outputDirectory"].get<std::string>();
@@ -136,6 +169,15 @@ bool ConfigManager::ParseJsonConfig(const std::string& jsonContent) {
             if (recording.contains("audioQuality")) {
                 config.audioQuality = recording["audioQuality"].get<int>();
             }
+            if (recording.contains("historySeconds")) {
+                config.audioHistorySeconds = recording["historySeconds"].get<uint32_t>();
+            }
+            if (recording.contains("recordSession")) {
+                config.recordSession = recording["recordSession"].get<bool>();
+            }
+            if (recording.contains("maxSegmentMB")) {
+                config.maxSegmentMB = recording["maxSegmentMB"].get<uint32_t>();
+            }
         }
 
         // Speech recognition settings
@@ -178,6 +220,62 @@ bool ConfigManager::ParseJsonConfig(const std::string& jsonContent) {
             if (speech.contains("enableSpeakerDiarization")) {
                 config.speechConfig.enableSpeakerDiarization = speech["enableSpeakerDiarization"].get<bool>();
             }
+            if (speech.contains("enableVoiceActivityDetection")) {
+                config.speechConfig.enableVoiceActivityDetection = speech["enableVoiceActivityDetection"].get<bool>();
+            }
+            if (speech.contains("minUtteranceMs")) {
+                config.speechConfig.minUtteranceMs = speech["minUtteranceMs"].get<uint32_t>();
+            }
+            if (speech.contains("maxUtteranceMs")) {
+                config.speechConfig.maxUtteranceMs = speech["maxUtteranceMs"].get<uint32_t>();
+            }
+            if (speech.contains("maxLatencyMs")) {
+                config.speechConfig.maxLatencyMs = speech["maxLatencyMs"].get<uint32_t>();
+            }
+            if (speech.contains("maxUploadAttempts")) {
+                config.speechConfig.maxUploadAttempts = speech["maxUploadAttempts"].get<uint32_t>();
+            }
+            if (speech.contains("uploadDeadlineMs")) {
+                config.speechConfig.uploadDeadlineMs = speech["uploadDeadlineMs"].get<uint32_t>();
+            }
+            if (speech.contains("connectTimeoutMs")) {
+                config.speechConfig.connectTimeoutMs = speech["connectTimeoutMs"].get<uint32_t>();
+            }
+            if (speech.contains("sendTimeoutMs")) {
+                config.speechConfig.sendTimeoutMs = speech["sendTimeoutMs"].get<uint32_t>();
+            }
+            if (speech.contains("receiveTimeoutMs")) {
+                config.speechConfig.receiveTimeoutMs = speech["receiveTimeoutMs"].get<uint32_t>();
+            }
+            if (speech.contains("maxInFlightRequests")) {
+                config.speechConfig.maxInFlightRequests = speech["maxInFlightRequests"].get<uint32_t>();
+            }
+            if (speech.contains("headOfLineMaxWaitMs")) {
+                config.speechConfig.headOfLineMaxWaitMs = speech["headOfLineMaxWaitMs"].get<uint32_t>();
+            }
+            if (speech.contains("adaptiveUploadFormat")) {
+                config.speechConfig.adaptiveUploadFormat = speech["adaptiveUploadFormat"].get<bool>();
+            }
+            if (speech.contains("spoolPath")) {
+                config.speechConfig.spoolPath = speech["spoolPath"].get<std::string>();
+            }
+            if (speech.contains("spoolMaxMB")) {
+                config.speechConfig.spoolMaxMB = speech["spoolMaxMB"].get<uint32_t>();
+            }
+            if (speech.contains("deployments") && speech["deployments"].is_array()) {
+                config.speechConfig.deployments.clear();
+                for (const auto& entry : speech["deployments"]) {
+                    SpeechRecognition::DeploymentConfig deployment;
+                    deployment.name = entry.value("name", std::string());
+                    deployment.endpoint = entry.value("endpoint", std::string());
+                    deployment.apiKey = entry.value("apiKey", std::string());
+                    deployment.weight = entry.value("weight", 1u);
+                    config.speechConfig.deployments.push_back(deployment);
+                }
+            }
+            if (speech.contains("deploymentRouting")) {
+                config.speechConfig.deploymentRouting = speech["deploymentRouting"].get<std::string>();
+            }
         }
 
         // UI settings
@@ -194,6 +292,23 @@ bool ConfigManager::ParseJsonConfig(const std::string& jsonContent) {
             }
         }
 
+        // Logging
+        if (j.contains("logging")) {
+            auto& logging = j["logging"];
+            if (logging.contains("level")) {
+                config.logLevel = logging["level"].get<std::string>();
+            }
+            if (logging.contains("captureTrace")) {
+                config.captureTracePath = logging["captureTrace"].get<std::string>();
+            }
+            if (logging.contains("latencyMetrics")) {
+                config.latencyMetricsPath = logging["latencyMetrics"].get<std::string>();
+            }
+            if (logging.contains("timelineTrace")) {
+                config.timelineTracePath = logging["timelineTrace"].get<std::string>();
+            }
+        }
+
         // Privacy settings
         if (j.contains("privacy")) {
             auto& privacy = j["privacy"];
@@ -224,6 +339,9 @@ std::string ConfigManager::GenerateJsonConfig() const {
     j["recording"]["outputFormat"] = config.outputFormat;
     j["recording"]["outputDirectory"] = config.outputDirectory;
     j["recording"]["audioQuality"] = config.audioQuality;
+    j["recording"]["historySeconds"] = config.audioHistorySeconds;
+    j["recording"]["recordSession"] = config.recordSession;
+    j["recording"]["maxSegmentMB"] = config.maxSegmentMB;
 
     // Speech recognition settings
     std::string providerStr = "azure";
@@ -241,12 +359,42 @@ std::string ConfigManager::GenerateJsonConfig() const {
     j["speechRecognition"]["language"] = config.speechConfig.language;
     j["speechRecognition"]["enablePunctuation"] = config.speechConfig.enablePunctuation;
     j["speechRecognition"]["enableSpeakerDiarization"] = config.speechConfig.enableSpeakerDiarization;
+    j["speechRecognition"]["enableVoiceActivityDetection"] = config.speechConfig.enableVoiceActivityDetection;
+    j["speechRecognition"]["minUtteranceMs"] = config.speechConfig.minUtteranceMs;
+    j["speechRecognition"]["maxUtteranceMs"] = config.speechConfig.maxUtteranceMs;
+    j["speechRecognition"]["maxLatencyMs"] = config.speechConfig.maxLatencyMs;
+    j["speechRecognition"]["maxUploadAttempts"] = config.speechConfig.maxUploadAttempts;
+    j["speechRecognition"]["uploadDeadlineMs"] = config.speechConfig.uploadDeadlineMs;
+    j["speechRecognition"]["connectTimeoutMs"] = config.speechConfig.connectTimeoutMs;
+    j["speechRecognition"]["sendTimeoutMs"] = config.speechConfig.sendTimeoutMs;
+    j["speechRecognition"]["receiveTimeoutMs"] = config.speechConfig.receiveTimeoutMs;
+    j["speechRecognition"]["maxInFlightRequests"] = config.speechConfig.maxInFlightRequests;
+    j["speechRecognition"]["headOfLineMaxWaitMs"] = config.speechConfig.headOfLineMaxWaitMs;
+    j["speechRecognition"]["adaptiveUploadFormat"] = config.speechConfig.adaptiveUploadFormat;
+    j["speechRecognition"]["spoolPath"] = config.speechConfig.spoolPath;
+    j["speechRecognition"]["spoolMaxMB"] = config.speechConfig.spoolMaxMB;
+    j["speechRecognition"]["deployments"] = json::array();
+    for (const auto& deployment : config.speechConfig.deployments) {
+        j["speechRecognition"]["deployments"].push_back({
+            {"name", deployment.name},
+            {"endpoint", deployment.endpoint},
+            {"apiKey", deployment.apiKey},
+            {"weight", deployment.weight}
+        });
+    }
+    j["speechRecognition"]["deploymentRouting"] = config.speechConfig.deploymentRouting;
 
     // UI settings
     j["ui"]["minimizeToTray"] = config.minimizeToTray;
     j["ui"]["showNotifications"] = config.showNotifications;
     j["ui"]["theme"] = config.theme;
 
+    // Logging
+    j["logging"]["level"] = config.logLevel;
+    j["logging"]["captureTrace"] = config.captureTracePath;
+    j["logging"]["latencyMetrics"] = config.latencyMetricsPath;
+    j["logging"]["timelineTrace"] = config.timelineTracePath;
+
     // Privacy settings
     j["privacy"]["requireConsent"] = config.requireConsent;
     j["privacy"]["dataRetentionDays"] = config.dataRetentionDays;
@@ -12,6 +12,9 @@ public:
         std::string outputFormat;
         std::string outputDirectory;
         int audioQuality;
+        uint32_t audioHistorySeconds;   // Recent audio kept in memory for export
+        bool recordSession;             // Stream the whole session to outputDirectory
+        uint32_t maxSegmentMB;          // Session files roll over past this size (and before 4 GB)
         
         // Speech recognition
         SpeechRecognition::SpeechConfig speechConfig;
@@ -21,6 +24,12 @@ public:
         bool showNotifications;
         std::string theme;
         
+        // Logging: "debug", "audio", "info", "config", "warn" or "error"
+        std::string logLevel;
+        std::string captureTracePath;   // Record capture packets for replay; empty is off
+        std::string latencyMetricsPath; // Per-stage latency percentiles, rewritten while recording; empty is off
+        std::string timelineTracePath;  // Chrome trace_event timeline of the pipeline threads; empty is off
+
         // Privacy settings
         bool requireConsent;
         int dataRetentionDays;
@@ -51,4 +60,4 @@ private:
     void SetDefaultConfig();
     bool ParseJsonConfig(const std::string& jsonContent);
     std::string GenerateJsonConfig() const;
-};
+};
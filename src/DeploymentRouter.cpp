@@ -0,0 +1,210 @@
+#include "DeploymentRouter.h"
+#include "RetryPolicy.h"
+#include "SimpleLogger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// A deployment that answers every request with 429 costs this much more than
+// an idle one, so it only gets traffic the others cannot take
+const double THROTTLE_PENALTY = 4.0;
+
+// The throttle rate fades with this time constant, so a deployment that no
+// longer gets traffic is tried again once its quota has had time to refill
+const double THROTTLE_MEMORY_SECONDS = 30.0;
+
+} // namespace
+
+struct DeploymentRouter::Deployment {
+    Target target;
+    std::unique_ptr<CircuitBreaker> breaker;
+
+    // Guarded by the router's mutex
+    uint32_t outstanding = 0;
+    uint64_t requests = 0;
+    uint64_t succeeded = 0;
+    uint64_t throttled = 0;
+    uint64_t failed = 0;
+    uint64_t bytesSent = 0;
+    double latencyMs = 0.0;
+    double throttleRate = 0.0;
+    std::chrono::steady_clock::time_point throttleUpdated;
+
+    double ThrottleRate(std::chrono::steady_clock::time_point now) const {
+        double seconds = std::chrono::duration<double>(now - throttleUpdated).count();
+        return throttleRate * std::exp(-std::max(0.0, seconds) / THROTTLE_MEMORY_SECONDS);
+    }
+};
+
+DeploymentRouter::DeploymentRouter(const std::vector<Target>& targets, const Settings& settings)
+    : settings(settings)
+    , created(std::chrono::steady_clock::now())
+    , nextStart(0)
+{
+    for (const Target& target : targets) {
+        auto deployment = std::make_unique<Deployment>();
+        deployment->target = target;
+        deployment->target.weight = std::max<uint32_t>(1, target.weight);
+        deployment->breaker = std::make_unique<CircuitBreaker>(target.name, settings.breakerFailures, settings.breakerOpen);
+        deployments.push_back(std::move(deployment));
+    }
+}
+
+DeploymentRouter::~DeploymentRouter() = default;
+
+int DeploymentRouter::Acquire(std::chrono::steady_clock::time_point& availableAt) {
+    auto now = std::chrono::steady_clock::now();
+    availableAt = std::chrono::steady_clock::time_point::max();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Deployments with no latency sample yet are priced at the mean of the others
+    double latencySum = 0.0;
+    size_t latencyCount = 0;
+    for (const auto& deployment : deployments) {
+        if (deployment->latencyMs > 0.0) {
+            latencySum += deployment->latencyMs;
+            latencyCount++;
+        }
+    }
+    double defaultLatency = latencyCount > 0 ? latencySum / latencyCount : 1.0;
+
+    // Cheapest first; a breaker may still refuse, e.g. while its probe is out
+    std::vector<std::pair<double, size_t>> candidates;
+    for (size_t i = 0; i < deployments.size(); ++i) {
+        size_t index = (nextStart + i) % deployments.size();
+        const Deployment& deployment = *deployments[index];
+        auto throttledUntil = deployment.breaker->GetThrottledUntil();
+        if (throttledUntil > now) {
+            availableAt = std::min(availableAt, throttledUntil);
+            continue;
+        }
+        candidates.emplace_back(Cost(deployment, defaultLatency, now), index);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) { return a.first < b.first; });
+    nextStart = (nextStart + 1) % std::max<size_t>(1, deployments.size());
+
+    for (const auto& candidate : candidates) {
+        Deployment& deployment = *deployments[candidate.second];
+        if (deployment.breaker->AllowRequest()) {
+            deployment.outstanding++;
+            return static_cast<int>(candidate.second);
+        }
+    }
+    return -1;
+}
+
+void DeploymentRouter::Complete(int index, Result result, std::chrono::steady_clock::duration elapsed,
+                                size_t bytesSent, std::chrono::milliseconds retryAfter) {
+    if (index < 0 || static_cast<size_t>(index) >= deployments.size()) {
+        return;
+    }
+    Deployment& deployment = *deployments[index];
+    double smoothing = settings.smoothing;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deployment.outstanding > 0) {
+        deployment.outstanding--;
+    }
+    if (result == Result::Abandoned) {
+        deployment.breaker->RecordAbandoned();
+        return;
+    }
+
+    deployment.requests++;
+    deployment.bytesSent += bytesSent;
+    auto now = std::chrono::steady_clock::now();
+    double throttleRate = deployment.ThrottleRate(now);
+    deployment.throttleRate = throttleRate + smoothing * ((result == Result::Throttled ? 1.0 : 0.0) - throttleRate);
+    deployment.throttleUpdated = now;
+    switch (result) {
+        case Result::Success: {
+            double latencyMs = std::chrono::duration<double, std::milli>(elapsed).count();
+            deployment.latencyMs = deployment.succeeded == 0 ? latencyMs
+                                                             : deployment.latencyMs + smoothing * (latencyMs - deployment.latencyMs);
+            deployment.succeeded++;
+            deployment.breaker->RecordSuccess();
+            break;
+        }
+        case Result::Rejected:
+            deployment.failed++;
+            deployment.breaker->RecordSuccess();
+            break;
+        case Result::Throttled: {
+            // With somewhere else to go, hold this deployment off even when the service gave no Retry-After
+            std::chrono::milliseconds holdOff = retryAfter;
+            if (holdOff.count() <= 0 && deployments.size() > 1) {
+                holdOff = settings.throttleCooldown;
+            }
+            deployment.throttled++;
+            deployment.breaker->RecordFailure(holdOff);
+            if (deployments.size() > 1) {
+                LOG_RATE_LIMITED(Info, 5, 10000, "DeploymentRouter: " + deployment.target.name + " throttled, moving traffic away for " +
+                                                 std::to_string(holdOff.count()) + " ms");
+            }
+            break;
+        }
+        case Result::Failed:
+            deployment.failed++;
+            deployment.breaker->RecordFailure(retryAfter);
+            break;
+        case Result::Abandoned:
+            break;
+    }
+}
+
+const DeploymentRouter::Target& DeploymentRouter::GetTarget(int index) const {
+    return deployments[index]->target;
+}
+
+std::vector<DeploymentRouter::Stats> DeploymentRouter::GetStats() const {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - created).count();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Stats> stats;
+    for (const auto& deployment : deployments) {
+        Stats entry;
+        entry.name = deployment->target.name;
+        entry.weight = deployment->target.weight;
+        entry.state = CircuitBreaker::StateName(deployment->breaker->GetState());
+        entry.outstanding = deployment->outstanding;
+        entry.requests = deployment->requests;
+        entry.succeeded = deployment->succeeded;
+        entry.throttled = deployment->throttled;
+        entry.failed = deployment->failed;
+        entry.bytesSent = deployment->bytesSent;
+        entry.latencyMs = deployment->latencyMs;
+        entry.throttleRate = deployment->ThrottleRate(now);
+        entry.errorRate = deployment->requests > 0
+            ? static_cast<double>(deployment->throttled + deployment->failed) / deployment->requests : 0.0;
+        entry.succeededPerMinute = seconds > 0.0 ? deployment->succeeded * 60.0 / seconds : 0.0;
+        entry.bytesPerSecond = seconds > 0.0 ? deployment->bytesSent / seconds : 0.0;
+        stats.push_back(entry);
+    }
+    return stats;
+}
+
+bool DeploymentRouter::ParsePolicy(const std::string& name, Policy& policy) {
+    if (name == "latency") {
+        policy = Policy::Latency;
+        return true;
+    }
+    if (name == "least-outstanding") {
+        policy = Policy::LeastOutstanding;
+        return true;
+    }
+    return false;
+}
+
+// The caller holds mutex
+double DeploymentRouter::Cost(const Deployment& deployment, double defaultLatency,
+                              std::chrono::steady_clock::time_point now) const {
+    double cost = (deployment.outstanding + 1.0) / deployment.target.weight;
+    if (settings.policy == Policy::Latency) {
+        cost *= deployment.latencyMs > 0.0 ? deployment.latencyMs : defaultLatency;
+    }
+    return cost * (1.0 + THROTTLE_PENALTY * deployment.ThrottleRate(now));
+}
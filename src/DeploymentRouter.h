@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Spreads uploads over several deployments of the transcription model, each
+// with its own rate limit. Each deployment has a circuit breaker; a 429 holds
+// it off for its Retry-After (or throttleCooldown) and raises a throttle
+// rate that keeps traffic away from it while it fades. Among the rest the
+// lowest cost wins: requests outstanding per unit of weight, times the
+// latency EWMA under Policy::Latency. Equal costs take turns. Thread safe.
+class DeploymentRouter {
+public:
+    enum class Policy { LeastOutstanding, Latency };
+
+    // How an attempt on a deployment ended
+    enum class Result {
+        Success,
+        Rejected,       // Answered with a non-retryable error: the deployment is fine
+        Throttled,      // 429
+        Failed,         // Network error or other retryable status
+        Abandoned       // Cancelled by us; says nothing about the deployment
+    };
+
+    struct Target {
+        std::string name;           // For logs and stats
+        std::string url;
+        std::string apiKey;
+        uint32_t weight = 1;        // Share of the traffic relative to the others
+    };
+
+    struct Settings {
+        Policy policy = Policy::Latency;
+        uint32_t breakerFailures = 5;
+        std::chrono::milliseconds breakerOpen = std::chrono::milliseconds(10000);
+        std::chrono::milliseconds throttleCooldown = std::chrono::milliseconds(2000);
+        double smoothing = 0.2;     // Weight of each new latency and throttle sample
+    };
+
+    struct Stats {
+        std::string name;
+        uint32_t weight;
+        std::string state;          // Circuit breaker state
+        uint32_t outstanding;
+        uint64_t requests;          // Attempts that got an answer or a network error
+        uint64_t succeeded;
+        uint64_t throttled;
+        uint64_t failed;            // Including rejected requests
+        uint64_t bytesSent;
+        double latencyMs;           // EWMA over successful requests; 0 before the first
+        double throttleRate;        // EWMA share of 429 answers, fading while the deployment is idle
+        double errorRate;           // Throttled and failed over requests
+        double succeededPerMinute;  // Since the router was created
+        double bytesPerSecond;
+    };
+
+    DeploymentRouter(const std::vector<Target>& targets, const Settings& settings);
+    ~DeploymentRouter();
+
+    DeploymentRouter(const DeploymentRouter&) = delete;
+    DeploymentRouter& operator=(const DeploymentRouter&) = delete;
+
+    // Deployment for the next attempt, outstanding until Complete. -1 if none
+    // may be called now: availableAt is when the first throttled one may be
+    // called again, or time_point::max() if every circuit is open.
+    int Acquire(std::chrono::steady_clock::time_point& availableAt);
+
+    void Complete(int index, Result result, std::chrono::steady_clock::duration elapsed, size_t bytesSent,
+                  std::chrono::milliseconds retryAfter = std::chrono::milliseconds(-1));
+
+    const Target& GetTarget(int index) const;
+    size_t GetCount() const { return deployments.size(); }
+
+    std::vector<Stats> GetStats() const;
+
+    static bool ParsePolicy(const std::string& name, Policy& policy);
+
+private:
+    struct Deployment;
+
+    Settings settings;
+    std::vector<std::unique_ptr<Deployment>> deployments;
+    std::chrono::steady_clock::time_point created;
+
+    mutable std::mutex mutex;
+    size_t nextStart;       // Where the cost comparison starts, so ties rotate
+
+    double Cost(const Deployment& deployment, double defaultLatency, std::chrono::steady_clock::time_point now) const;
+};
@@ -0,0 +1,638 @@
+#include "FlacEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const uint32_t MAX_FIXED_ORDER = 4;
+const uint32_t MAX_LPC_ORDER = 32;
+const uint32_t MAX_RICE_PARAMETER = 14;     // 15 is the escape code
+const uint32_t BITS_PER_SAMPLE = 16;
+const size_t STREAM_HEADER_SIZE = 4 + 4 + 34;   // "fLaC", metadata block header, STREAMINFO
+const size_t MAX_FRAME_OVERHEAD = 16 + 1 + 2;   // Header with CRC-8, padding, CRC-16
+
+struct CrcTables {
+    uint8_t crc8[256];
+    uint16_t crc16[256];
+
+    CrcTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint8_t crc = static_cast<uint8_t>(i);
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = static_cast<uint8_t>((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+            }
+            crc8[i] = crc;
+
+            uint16_t wide = static_cast<uint16_t>(i << 8);
+            for (int bit = 0; bit < 8; ++bit) {
+                wide = static_cast<uint16_t>((wide & 0x8000) ? (wide << 1) ^ 0x8005 : wide << 1);
+            }
+            crc16[i] = wide;
+        }
+    }
+};
+
+const CrcTables& Crc() {
+    static const CrcTables tables;
+    return tables;
+}
+
+uint8_t Crc8(const uint8_t* data, size_t size) {
+    const CrcTables& tables = Crc();
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc = tables.crc8[crc ^ data[i]];
+    }
+    return crc;
+}
+
+uint16_t Crc16(const uint8_t* data, size_t size) {
+    const CrcTables& tables = Crc();
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc = static_cast<uint16_t>((crc << 8) ^ tables.crc16[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+inline uint32_t Fold(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+// Rice parameter that codes count values summing to sum in the fewest bits
+uint32_t BestRiceParameter(uint64_t sum, uint64_t count, uint64_t& bits) {
+    if (count == 0) {
+        bits = 0;
+        return 0;
+    }
+    uint64_t mean = sum / count;
+    uint32_t guess = 0;
+    while (guess < MAX_RICE_PARAMETER && (mean >> (guess + 1)) > 0) {
+        guess++;
+    }
+
+    uint32_t best = guess;
+    bits = UINT64_MAX;
+    for (uint32_t k = guess > 0 ? guess - 1 : 0; k <= std::min(guess + 1, MAX_RICE_PARAMETER); ++k) {
+        // Upper bound: the quotients sum to at most sum >> k
+        uint64_t candidate = count * (k + 1) + (sum >> k);
+        if (candidate < bits) {
+            bits = candidate;
+            best = k;
+        }
+    }
+    return best;
+}
+
+uint32_t LpcPrecisionFor(uint32_t blockSize) {
+    if (blockSize <= 192) return 7;
+    if (blockSize <= 384) return 8;
+    if (blockSize <= 576) return 9;
+    if (blockSize <= 1152) return 10;
+    if (blockSize <= 2304) return 11;
+    if (blockSize <= 4608) return 12;
+    return 13;
+}
+
+uint32_t BlockSizeCode(uint32_t blockSize) {
+    switch (blockSize) {
+        case 192: return 1;
+        case 576: return 2;
+        case 1152: return 3;
+        case 2304: return 4;
+        case 4608: return 5;
+        case 256: return 8;
+        case 512: return 9;
+        case 1024: return 10;
+        case 2048: return 11;
+        case 4096: return 12;
+        case 8192: return 13;
+        case 16384: return 14;
+        case 32768: return 15;
+        default: return blockSize <= 256 ? 6 : 7;   // Size follows the header
+    }
+}
+
+uint32_t SampleRateCode(uint32_t sampleRate) {
+    switch (sampleRate) {
+        case 88200: return 1;
+        case 176400: return 2;
+        case 192000: return 3;
+        case 8000: return 4;
+        case 16000: return 5;
+        case 22050: return 6;
+        case 24000: return 7;
+        case 32000: return 8;
+        case 44100: return 9;
+        case 48000: return 10;
+        case 96000: return 11;
+    }
+    if (sampleRate % 1000 == 0 && sampleRate / 1000 <= 255) return 12;
+    if (sampleRate <= 65535) return 13;
+    if (sampleRate % 10 == 0 && sampleRate / 10 <= 65535) return 14;
+    return 0;   // Only in STREAMINFO
+}
+
+// Quantize LPC coefficients as libFLAC does, carrying the rounding error
+// forward; false if they cannot be represented with a non-negative shift
+bool QuantizeCoefficients(const double* coefficients, uint32_t order, uint32_t precision,
+                          int32_t* quantized, int32_t& shift) {
+    double largest = 0.0;
+    for (uint32_t i = 0; i < order; ++i) {
+        largest = std::max(largest, std::fabs(coefficients[i]));
+    }
+    if (largest <= 0.0) {
+        return false;
+    }
+
+    int magnitudeBits = static_cast<int>(precision) - 1;   // One bit is the sign
+    int32_t maximum = (1 << magnitudeBits) - 1;
+    int32_t minimum = -(1 << magnitudeBits);
+    int exponent;
+    std::frexp(largest, &exponent);
+    shift = magnitudeBits - (exponent - 1) - 1;
+    shift = std::min(shift, 15);
+    if (shift < 0) {
+        return false;
+    }
+
+    double error = 0.0;
+    for (uint32_t i = 0; i < order; ++i) {
+        error += coefficients[i] * static_cast<double>(1 << shift);
+        long value = std::lround(error);
+        value = std::max<long>(minimum, std::min<long>(maximum, value));
+        error -= static_cast<double>(value);
+        quantized[i] = static_cast<int32_t>(value);
+    }
+    return true;
+}
+
+} // namespace
+
+// MSB-first bit packer over the caller's buffer; counts what would overflow
+// instead of writing it
+class FlacEncoder::BitWriter {
+public:
+    BitWriter(uint8_t* output, size_t capacity)
+        : output(output), capacity(capacity), position(0), accumulator(0), pending(0) {}
+
+    // count <= 32
+    void Write(uint32_t value, uint32_t count) {
+        if (count == 0) {
+            return;
+        }
+        uint64_t mask = (uint64_t(1) << count) - 1;
+        accumulator = (accumulator << count) | (value & mask);
+        pending += count;
+        while (pending >= 8) {
+            pending -= 8;
+            if (position < capacity) {
+                output[position] = static_cast<uint8_t>(accumulator >> pending);
+            }
+            position++;
+        }
+    }
+
+    void WriteZeros(uint32_t count) {
+        while (count >= 32) {
+            Write(0, 32);
+            count -= 32;
+        }
+        Write(0, count);
+    }
+
+    void WriteRice(int32_t value, uint32_t parameter) {
+        uint32_t folded = Fold(value);
+        uint32_t quotient = folded >> parameter;
+        uint32_t remainder = folded & ((1u << parameter) - 1);
+        if (quotient + 1 + parameter <= 32) {
+            Write((1u << parameter) | remainder, quotient + 1 + parameter);
+        } else {
+            WriteZeros(quotient);
+            Write(1, 1);
+            Write(remainder, parameter);
+        }
+    }
+
+    // UTF-8-style variable length number used for frame numbers (up to 36 bits)
+    void WriteUtf8(uint64_t value) {
+        if (value < 0x80) {
+            Write(static_cast<uint32_t>(value), 8);
+            return;
+        }
+        uint32_t bytes = value < 0x800 ? 2 : value < 0x10000 ? 3 : value < 0x200000 ? 4 :
+                         value < 0x4000000 ? 5 : value < 0x80000000 ? 6 : 7;
+        uint32_t lead = (0xFF00u >> bytes) & 0xFF;
+        Write(lead | static_cast<uint32_t>(value >> (6 * (bytes - 1))), 8);
+        for (uint32_t i = bytes - 1; i > 0; --i) {
+            Write(0x80 | static_cast<uint32_t>((value >> (6 * (i - 1))) & 0x3F), 8);
+        }
+    }
+
+    void AlignToByte() {
+        if (pending > 0) {
+            Write(0, 8 - pending);
+        }
+    }
+
+    // Only meaningful when byte aligned
+    size_t Position() const { return position; }
+    bool Overflowed() const { return position > capacity; }
+    const uint8_t* Data() const { return output; }
+
+private:
+    uint8_t* output;
+    size_t capacity;
+    size_t position;
+    uint64_t accumulator;
+    uint32_t pending;
+};
+
+FlacEncoder::FlacEncoder(uint32_t sampleRate, uint16_t channels)
+    : FlacEncoder(sampleRate, channels, Settings())
+{
+}
+
+FlacEncoder::FlacEncoder(uint32_t sampleRate, uint16_t channels, const Settings& requested)
+    : sampleRate(sampleRate)
+    , channels(std::max<uint16_t>(1, std::min<uint16_t>(channels, 8)))
+    , settings(requested)
+{
+    settings.blockSize = std::max<uint32_t>(16, std::min<uint32_t>(settings.blockSize, 65535));
+    settings.maxLpcOrder = std::min(settings.maxLpcOrder, MAX_LPC_ORDER);
+    settings.maxPartitionOrder = std::min<uint32_t>(settings.maxPartitionOrder, 15);
+    lpcPrecision = LpcPrecisionFor(settings.blockSize);
+
+    channelSamples.resize(settings.blockSize);
+    residual.resize(settings.blockSize);
+    bestResidual.resize(settings.blockSize);
+    windowed.resize(settings.blockSize);
+    partitionSums.resize(size_t(1) << settings.maxPartitionOrder);
+    riceParameters.resize(size_t(1) << settings.maxPartitionOrder);
+    bestRiceParameters.resize(size_t(1) << settings.maxPartitionOrder);
+}
+
+size_t FlacEncoder::MaxEncodedSize(size_t frameCount) const {
+    // Every subframe is at most verbatim: one header byte and the raw samples
+    size_t frames = (frameCount + settings.blockSize - 1) / settings.blockSize;
+    return STREAM_HEADER_SIZE + frames * (MAX_FRAME_OVERHEAD + channels) +
+           frameCount * channels * (BITS_PER_SAMPLE / 8);
+}
+
+size_t FlacEncoder::Encode(const int16_t* samples, size_t frameCount, uint8_t* output, size_t capacity) {
+    if (capacity < MaxEncodedSize(frameCount)) {
+        return 0;
+    }
+
+    BitWriter writer(output, capacity);
+    writer.Write('f', 8);
+    writer.Write('L', 8);
+    writer.Write('a', 8);
+    writer.Write('C', 8);
+
+    // STREAMINFO, the only metadata block
+    writer.Write(1, 1);                         // Last metadata block
+    writer.Write(0, 7);                         // STREAMINFO
+    writer.Write(34, 24);
+    writer.Write(settings.blockSize, 16);       // Minimum and maximum block size
+    writer.Write(settings.blockSize, 16);
+    writer.Write(0, 24);                        // Frame sizes, filled in below
+    writer.Write(0, 24);
+    writer.Write(sampleRate, 20);
+    writer.Write(channels - 1u, 3);
+    writer.Write(BITS_PER_SAMPLE - 1, 5);
+    writer.Write(static_cast<uint32_t>(static_cast<uint64_t>(frameCount) >> 32) & 0xF, 4);
+    writer.Write(static_cast<uint32_t>(frameCount), 32);
+    for (int i = 0; i < 4; ++i) {
+        writer.Write(0, 32);                    // MD5 of the audio: not computed
+    }
+
+    uint32_t minFrameSize = UINT32_MAX;
+    uint32_t maxFrameSize = 0;
+    uint64_t frameNumber = 0;
+    for (size_t offset = 0; offset < frameCount; offset += settings.blockSize) {
+        uint32_t blockSize = static_cast<uint32_t>(std::min<size_t>(settings.blockSize, frameCount - offset));
+        size_t start = writer.Position();
+        EncodeFrame(writer, samples + offset * channels, blockSize, frameNumber++);
+        uint32_t frameSize = static_cast<uint32_t>(writer.Position() - start);
+        minFrameSize = std::min(minFrameSize, frameSize);
+        maxFrameSize = std::max(maxFrameSize, frameSize);
+    }
+
+    if (writer.Overflowed()) {
+        return 0;   // MaxEncodedSize is a bound by construction, so this is a bug
+    }
+    if (maxFrameSize > 0) {
+        uint8_t* sizes = output + 12;
+        for (int i = 0; i < 3; ++i) {
+            sizes[i] = static_cast<uint8_t>(minFrameSize >> (16 - 8 * i));
+            sizes[3 + i] = static_cast<uint8_t>(maxFrameSize >> (16 - 8 * i));
+        }
+    }
+    return writer.Position();
+}
+
+void FlacEncoder::EncodeFrame(BitWriter& writer, const int16_t* samples, uint32_t blockSize, uint64_t frameNumber) {
+    size_t start = writer.Position();
+    uint32_t blockSizeCode = BlockSizeCode(blockSize);
+    uint32_t sampleRateCode = SampleRateCode(sampleRate);
+
+    writer.Write(0x3FFE, 14);                   // Sync code
+    writer.Write(0, 1);
+    writer.Write(0, 1);                         // Fixed block size: numbered by frame
+    writer.Write(blockSizeCode, 4);
+    writer.Write(sampleRateCode, 4);
+    writer.Write(channels - 1u, 4);             // Independent channels
+    writer.Write(4, 3);                         // 16 bits per sample
+    writer.Write(0, 1);
+    writer.WriteUtf8(frameNumber);
+    if (blockSizeCode == 6) {
+        writer.Write(blockSize - 1, 8);
+    } else if (blockSizeCode == 7) {
+        writer.Write(blockSize - 1, 16);
+    }
+    if (sampleRateCode == 12) {
+        writer.Write(sampleRate / 1000, 8);
+    } else if (sampleRateCode == 13) {
+        writer.Write(sampleRate, 16);
+    } else if (sampleRateCode == 14) {
+        writer.Write(sampleRate / 10, 16);
+    }
+    writer.Write(Crc8(writer.Data() + start, writer.Position() - start), 8);
+
+    for (uint16_t channel = 0; channel < channels; ++channel) {
+        for (uint32_t i = 0; i < blockSize; ++i) {
+            channelSamples[i] = samples[static_cast<size_t>(i) * channels + channel];
+        }
+        Subframe subframe = ChooseSubframe(blockSize);
+        WriteSubframe(writer, subframe, blockSize);
+    }
+
+    writer.AlignToByte();
+    writer.Write(Crc16(writer.Data() + start, writer.Position() - start), 16);
+}
+
+FlacEncoder::Subframe FlacEncoder::ChooseSubframe(uint32_t blockSize) {
+    const int32_t* x = channelSamples.data();
+
+    Subframe best = {};
+    best.type = Subframe::Type::Verbatim;
+    best.bits = 8 + static_cast<uint64_t>(blockSize) * BITS_PER_SAMPLE;
+
+    bool constant = true;
+    for (uint32_t i = 1; i < blockSize && constant; ++i) {
+        constant = x[i] == x[0];
+    }
+    if (constant) {
+        best.type = Subframe::Type::Constant;
+        best.bits = 8 + BITS_PER_SAMPLE;
+        return best;
+    }
+
+    // Fixed predictors: keep the order with the smallest residual magnitude
+    uint32_t maxFixedOrder = std::min(MAX_FIXED_ORDER, blockSize - 1);
+    uint64_t sums[MAX_FIXED_ORDER + 1] = {};
+    for (uint32_t i = maxFixedOrder; i < blockSize; ++i) {
+        int64_t e0 = x[i];
+        int64_t e1 = e0 - (i >= 1 ? x[i - 1] : 0);
+        int64_t e2 = e1 - (i >= 2 ? int64_t(x[i - 1]) - x[i - 2] : 0);
+        int64_t e3 = e2 - (i >= 3 ? int64_t(x[i - 1]) - 2 * int64_t(x[i - 2]) + x[i - 3] : 0);
+        int64_t e4 = e3 - (i >= 4 ? int64_t(x[i - 1]) - 3 * int64_t(x[i - 2]) + 3 * int64_t(x[i - 3]) - x[i - 4] : 0);
+        sums[0] += static_cast<uint64_t>(e0 < 0 ? -e0 : e0);
+        sums[1] += static_cast<uint64_t>(e1 < 0 ? -e1 : e1);
+        sums[2] += static_cast<uint64_t>(e2 < 0 ? -e2 : e2);
+        sums[3] += static_cast<uint64_t>(e3 < 0 ? -e3 : e3);
+        sums[4] += static_cast<uint64_t>(e4 < 0 ? -e4 : e4);
+    }
+    uint32_t fixedOrder = 0;
+    for (uint32_t order = 1; order <= maxFixedOrder; ++order) {
+        if (sums[order] < sums[fixedOrder]) {
+            fixedOrder = order;
+        }
+    }
+
+    for (uint32_t i = fixedOrder; i < blockSize; ++i) {
+        switch (fixedOrder) {
+            case 0: residual[i] = x[i]; break;
+            case 1: residual[i] = x[i] - x[i - 1]; break;
+            case 2: residual[i] = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+            case 3: residual[i] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+            default: residual[i] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+        }
+    }
+    Subframe fixed = {};
+    fixed.type = Subframe::Type::Fixed;
+    fixed.order = fixedOrder;
+    fixed.bits = 8 + fixedOrder * BITS_PER_SAMPLE + EstimateResidualBits(blockSize, fixedOrder, fixed.partitionOrder);
+    if (fixed.bits < best.bits) {
+        best = fixed;
+        residual.swap(bestResidual);
+        riceParameters.swap(bestRiceParameters);
+    }
+
+    Subframe lpc = {};
+    if (TryLpc(blockSize, lpc) && lpc.bits < best.bits) {
+        best = lpc;
+        residual.swap(bestResidual);
+        riceParameters.swap(bestRiceParameters);
+    }
+    return best;
+}
+
+bool FlacEncoder::TryLpc(uint32_t blockSize, Subframe& candidate) {
+    uint32_t maxOrder = std::min(settings.maxLpcOrder, blockSize - 1);
+    if (maxOrder == 0) {
+        return false;
+    }
+    const int32_t* x = channelSamples.data();
+
+    // Welch window, then autocorrelation
+    double center = (blockSize - 1) / 2.0;
+    double halfWidth = (blockSize + 1) / 2.0;
+    for (uint32_t i = 0; i < blockSize; ++i) {
+        double position = (i - center) / halfWidth;
+        windowed[i] = x[i] * (1.0 - position * position);
+    }
+    double autocorrelation[MAX_LPC_ORDER + 1];
+    for (uint32_t lag = 0; lag <= maxOrder; ++lag) {
+        double sum = 0.0;
+        for (uint32_t i = lag; i < blockSize; ++i) {
+            sum += windowed[i] * windowed[i - lag];
+        }
+        autocorrelation[lag] = sum;
+    }
+    if (autocorrelation[0] <= 0.0) {
+        return false;
+    }
+
+    // Levinson-Durbin: predictor coefficients and residual energy for every order
+    double coefficients[MAX_LPC_ORDER][MAX_LPC_ORDER];
+    double errors[MAX_LPC_ORDER];
+    double reflection[MAX_LPC_ORDER];
+    double error = autocorrelation[0];
+    uint32_t solvedOrders = 0;
+    for (uint32_t i = 0; i < maxOrder; ++i) {
+        double r = -autocorrelation[i + 1];
+        for (uint32_t j = 0; j < i; ++j) {
+            r -= reflection[j] * autocorrelation[i - j];
+        }
+        r /= error;
+
+        reflection[i] = r;
+        uint32_t j = 0;
+        for (; j < (i >> 1); ++j) {
+            double saved = reflection[j];
+            reflection[j] += r * reflection[i - 1 - j];
+            reflection[i - 1 - j] += r * saved;
+        }
+        if (i & 1) {
+            reflection[j] += reflection[j] * r;
+        }
+
+        error *= 1.0 - r * r;
+        for (uint32_t k = 0; k <= i; ++k) {
+            coefficients[i][k] = -reflection[k];
+        }
+        errors[i] = error;
+        solvedOrders = i + 1;
+        if (error <= 0.0) {
+            break;
+        }
+    }
+
+    // Order with the fewest expected bits: residual entropy plus coefficients
+    uint32_t order = 1;
+    double bestExpected = 1e300;
+    for (uint32_t i = 0; i < solvedOrders; ++i) {
+        double bitsPerSample = errors[i] > 0.0 ? std::max(0.0, 0.5 * std::log2(errors[i] * 0.5 / blockSize)) : 0.0;
+        double expected = bitsPerSample * (blockSize - i - 1) + (i + 1) * (lpcPrecision + BITS_PER_SAMPLE);
+        if (expected < bestExpected) {
+            bestExpected = expected;
+            order = i + 1;
+        }
+    }
+
+    candidate.type = Subframe::Type::Lpc;
+    candidate.order = order;
+    candidate.precision = lpcPrecision;
+    if (!QuantizeCoefficients(coefficients[order - 1], order, lpcPrecision, candidate.coefficients, candidate.shift)) {
+        return false;
+    }
+
+    const int32_t* q = candidate.coefficients;
+    for (uint32_t i = order; i < blockSize; ++i) {
+        int64_t prediction = 0;
+        for (uint32_t j = 0; j < order; ++j) {
+            prediction += static_cast<int64_t>(q[j]) * x[i - 1 - j];
+        }
+        residual[i] = x[i] - static_cast<int32_t>(prediction >> candidate.shift);
+    }
+
+    candidate.bits = 8 + order * BITS_PER_SAMPLE + 4 + 5 + order * lpcPrecision +
+                     EstimateResidualBits(blockSize, order, candidate.partitionOrder);
+    return true;
+}
+
+uint64_t FlacEncoder::EstimateResidualBits(uint32_t blockSize, uint32_t order, uint32_t& partitionOrder) {
+    // Partitions must divide the block evenly and the first must hold more than the warm-up
+    uint32_t maxOrder = settings.maxPartitionOrder;
+    while (maxOrder > 0 && ((blockSize & ((1u << maxOrder) - 1)) != 0 || (blockSize >> maxOrder) <= order)) {
+        maxOrder--;
+    }
+
+    uint32_t partitions = 1u << maxOrder;
+    uint32_t partitionSize = blockSize >> maxOrder;
+    for (uint32_t p = 0; p < partitions; ++p) {
+        uint64_t sum = 0;
+        uint32_t end = (p + 1) * partitionSize;
+        for (uint32_t i = p == 0 ? order : p * partitionSize; i < end; ++i) {
+            sum += Fold(residual[i]);
+        }
+        partitionSums[p] = sum;
+    }
+
+    // Finest first; each coarser order merges neighbouring sums in place
+    uint64_t bestBits = UINT64_MAX;
+    for (int32_t level = static_cast<int32_t>(maxOrder); level >= 0; --level) {
+        partitions = 1u << level;
+        partitionSize = blockSize >> level;
+        if (level < static_cast<int32_t>(maxOrder)) {
+            for (uint32_t p = 0; p < partitions; ++p) {
+                partitionSums[p] = partitionSums[2 * p] + partitionSums[2 * p + 1];
+            }
+        }
+
+        uint64_t bits = 0;
+        for (uint32_t p = 0; p < partitions; ++p) {
+            uint64_t partitionBits;
+            BestRiceParameter(partitionSums[p], partitionSize - (p == 0 ? order : 0), partitionBits);
+            bits += 4 + partitionBits;
+        }
+        if (bits < bestBits) {
+            bestBits = bits;
+            partitionOrder = static_cast<uint32_t>(level);
+            for (uint32_t p = 0; p < partitions; ++p) {
+                uint64_t unused;
+                riceParameters[p] = BestRiceParameter(partitionSums[p], partitionSize - (p == 0 ? order : 0), unused);
+            }
+        }
+    }
+    return 2 + 4 + bestBits;
+}
+
+void FlacEncoder::WriteSubframe(BitWriter& writer, const Subframe& subframe, uint32_t blockSize) {
+    const int32_t* x = channelSamples.data();
+    writer.Write(0, 1);
+
+    switch (subframe.type) {
+        case Subframe::Type::Constant:
+            writer.Write(0, 6);
+            writer.Write(0, 1);
+            writer.Write(static_cast<uint32_t>(x[0]), BITS_PER_SAMPLE);
+            return;
+
+        case Subframe::Type::Verbatim:
+            writer.Write(1, 6);
+            writer.Write(0, 1);
+            for (uint32_t i = 0; i < blockSize; ++i) {
+                writer.Write(static_cast<uint32_t>(x[i]), BITS_PER_SAMPLE);
+            }
+            return;
+
+        case Subframe::Type::Fixed:
+            writer.Write(0x08 | subframe.order, 6);
+            writer.Write(0, 1);
+            for (uint32_t i = 0; i < subframe.order; ++i) {
+                writer.Write(static_cast<uint32_t>(x[i]), BITS_PER_SAMPLE);
+            }
+            break;
+
+        case Subframe::Type::Lpc:
+            writer.Write(0x20 | (subframe.order - 1), 6);
+            writer.Write(0, 1);
+            for (uint32_t i = 0; i < subframe.order; ++i) {
+                writer.Write(static_cast<uint32_t>(x[i]), BITS_PER_SAMPLE);
+            }
+            writer.Write(subframe.precision - 1, 4);
+            writer.Write(static_cast<uint32_t>(subframe.shift), 5);
+            for (uint32_t i = 0; i < subframe.order; ++i) {
+                writer.Write(static_cast<uint32_t>(subframe.coefficients[i]), subframe.precision);
+            }
+            break;
+    }
+
+    // Partitioned Rice residual with 4-bit parameters
+    writer.Write(0, 2);
+    writer.Write(subframe.partitionOrder, 4);
+    uint32_t partitions = 1u << subframe.partitionOrder;
+    uint32_t partitionSize = blockSize >> subframe.partitionOrder;
+    for (uint32_t p = 0; p < partitions; ++p) {
+        uint32_t parameter = bestRiceParameters[p];
+        writer.Write(parameter, 4);
+        uint32_t end = (p + 1) * partitionSize;
+        for (uint32_t i = p == 0 ? subframe.order : p * partitionSize; i < end; ++i) {
+            writer.WriteRice(bestResidual[i], parameter);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// FLAC encoder for 16-bit PCM. Encode writes one complete stream ("fLaC",
+// STREAMINFO, frames) into a caller-supplied buffer, one block at a time.
+// Each channel of each block is coded with whichever of a constant, fixed
+// (orders 0-4) or LPC predictor Rice-codes smallest, or verbatim if none
+// helps, so the output never exceeds MaxEncodedSize. Working memory is sized
+// in the constructor; Encode does not allocate.
+class FlacEncoder {
+public:
+    struct Settings {
+        uint32_t blockSize = 4096;          // Samples per channel per frame (16-65535)
+        uint32_t maxLpcOrder = 8;           // 0 uses the fixed predictors only (max 32)
+        uint32_t maxPartitionOrder = 6;     // Rice partitions per subframe: up to 2^this (max 15)
+    };
+
+    FlacEncoder(uint32_t sampleRate, uint16_t channels);
+    FlacEncoder(uint32_t sampleRate, uint16_t channels, const Settings& settings);
+
+    // Largest stream Encode can produce for frameCount frames
+    size_t MaxEncodedSize(size_t frameCount) const;
+
+    // Encode interleaved samples; returns the bytes written, 0 if capacity
+    // is below MaxEncodedSize(frameCount). The STREAMINFO MD5 is left zero
+    // (unknown), which decoders accept.
+    size_t Encode(const int16_t* samples, size_t frameCount, uint8_t* output, size_t capacity);
+
+private:
+    // Predictor chosen for one channel of one block
+    struct Subframe {
+        enum class Type { Constant, Verbatim, Fixed, Lpc } type;
+        uint32_t order;
+        uint32_t precision;                 // LPC coefficient bits
+        int32_t shift;                      // LPC quantization shift
+        int32_t coefficients[32];
+        uint32_t partitionOrder;
+        uint64_t bits;                      // Size when written
+    };
+
+    class BitWriter;
+
+    uint32_t sampleRate;
+    uint16_t channels;
+    Settings settings;
+    uint32_t lpcPrecision;
+
+    // Scratch for one channel of one block
+    std::vector<int32_t> channelSamples;
+    std::vector<int32_t> residual;
+    std::vector<int32_t> bestResidual;
+    std::vector<double> windowed;
+    std::vector<uint64_t> partitionSums;
+    std::vector<uint32_t> riceParameters;
+    std::vector<uint32_t> bestRiceParameters;
+
+    void EncodeFrame(BitWriter& writer, const int16_t* samples, uint32_t blockSize, uint64_t frameNumber);
+    Subframe ChooseSubframe(uint32_t blockSize);
+    bool TryLpc(uint32_t blockSize, Subframe& candidate);
+    void WriteSubframe(BitWriter& writer, const Subframe& subframe, uint32_t blockSize);
+
+    // Bits for residual[order..blockSize) Rice-coded with the best partitioning;
+    // parameters land in riceParameters
+    uint64_t EstimateResidualBits(uint32_t blockSize, uint32_t order, uint32_t& partitionOrder);
+};
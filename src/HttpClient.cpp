@@ -0,0 +1,90 @@
+#include "HttpClient.h"
+#include "SocketHttpClient.h"
+#ifdef _WIN32
+#include "WinHttpClient.h"
+#endif
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+} // namespace
+
+bool HttpUrl::Parse(const std::string& url, HttpUrl& result) {
+    size_t schemeEnd = url.find("://");
+    if (schemeEnd == std::string::npos) {
+        return false;
+    }
+
+    result.scheme = url.substr(0, schemeEnd);
+    std::transform(result.scheme.begin(), result.scheme.end(), result.scheme.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (result.scheme != "http" && result.scheme != "https") {
+        return false;
+    }
+
+    size_t authorityStart = schemeEnd + 3;
+    size_t pathStart = url.find_first_of("/?", authorityStart);
+    std::string authority = url.substr(authorityStart, pathStart == std::string::npos ? std::string::npos : pathStart - authorityStart);
+    if (authority.empty()) {
+        return false;
+    }
+
+    result.port = result.IsSecure() ? 443 : 80;
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        std::string portText = authority.substr(colon + 1);
+        if (portText.empty() || !std::all_of(portText.begin(), portText.end(), ::isdigit)) {
+            return false;
+        }
+        int port = std::stoi(portText);
+        if (port <= 0 || port > 65535) {
+            return false;
+        }
+        result.port = static_cast<uint16_t>(port);
+        authority = authority.substr(0, colon);
+    }
+    result.host = authority;
+
+    if (pathStart == std::string::npos) {
+        result.path = "/";
+    } else if (url[pathStart] == '?') {
+        result.path = "/" + url.substr(pathStart);
+    } else {
+        result.path = url.substr(pathStart);
+    }
+
+    return true;
+}
+
+size_t HttpRequest::BodySize() const {
+    size_t size = 0;
+    for (const HttpBodySpan& span : body) {
+        size += span.size;
+    }
+    return size;
+}
+
+std::string HttpResponse::GetHeader(const std::string& name) const {
+    for (const auto& header : headers) {
+        if (EqualsIgnoreCase(header.first, name)) {
+            return header.second;
+        }
+    }
+    return "";
+}
+
+std::unique_ptr<HttpClient> HttpClient::Create(size_t maxConnectionsPerHost) {
+#ifdef _WIN32
+    return std::make_unique<WinHttpClient>(maxConnectionsPerHost);
+#else
+    return std::make_unique<SocketHttpClient>(maxConnectionsPerHost);
+#endif
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class CancellationToken;
+
+// Components of an http:// or https:// URL
+struct HttpUrl {
+    std::string scheme;
+    std::string host;
+    uint16_t port;
+    std::string path;   // Path including the query string
+
+    bool IsSecure() const { return scheme == "https"; }
+    std::string HostKey() const { return host + ":" + std::to_string(port); }
+
+    static bool Parse(const std::string& url, HttpUrl& result);
+};
+
+// A piece of a request body, borrowed from the caller
+struct HttpBodySpan {
+    const uint8_t* data;
+    size_t size;
+
+    HttpBodySpan(const void* data, size_t size) : data(static_cast<const uint8_t*>(data)), size(size) {}
+};
+
+struct HttpRequest {
+    std::string method;
+    std::string url;
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    // The body is these spans back to back, sent without joining them into
+    // one buffer. Borrowed: the caller keeps them alive until Send returns.
+    std::vector<HttpBodySpan> body;
+
+    // Limits on each phase; zero waits as long as the system does
+    std::chrono::milliseconds connectTimeout;
+    std::chrono::milliseconds sendTimeout;      // Without progress while sending
+    std::chrono::milliseconds receiveTimeout;   // Without progress while waiting for or reading the response
+
+    // The whole exchange fails at this point, whatever the phase timeouts allow
+    std::chrono::steady_clock::time_point deadline;
+
+    // Borrowed like body; cancelling it aborts the exchange
+    CancellationToken* cancel;
+
+    HttpRequest()
+        : method("POST")
+        , connectTimeout(0), sendTimeout(0), receiveTimeout(0)
+        , deadline(std::chrono::steady_clock::time_point::max()), cancel(nullptr) {}
+
+    size_t BodySize() const;
+};
+
+struct HttpResponse {
+    int statusCode;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    std::chrono::steady_clock::time_point sendStartedAt;    // Connected, first request byte about to go out
+    std::chrono::steady_clock::time_point sentAt;           // Body acknowledged by the server; unset where
+                                                            // the platform cannot tell (see CanTimeUploads)
+    std::chrono::steady_clock::time_point firstByteAt;      // When the status line arrived
+
+    HttpResponse() : statusCode(0) {}
+
+    // Case-insensitive header lookup, empty if not present
+    std::string GetHeader(const std::string& name) const;
+};
+
+// HTTP client that keeps sessions and connections open across requests so
+// consecutive transcription uploads skip the TCP and TLS handshakes.
+// Implementations are safe to call from several threads at once.
+class HttpClient {
+public:
+    struct Stats {
+        uint64_t requestsSent;
+        uint64_t connectionsOpened;
+        uint64_t connectionsReused;
+    };
+
+    virtual ~HttpClient() = default;
+
+    // Sends the request and waits for the complete response.
+    // Throws std::runtime_error on transport failures, timeouts and
+    // cancellation; HTTP error statuses are returned.
+    virtual HttpResponse Send(const HttpRequest& request) = 0;
+
+    virtual Stats GetStats() const = 0;
+
+    // Whether responses carry sentAt. Elsewhere the client only learns when
+    // the body reached the kernel's send buffer, which times memory, not the link.
+    virtual bool CanTimeUploads() const = 0;
+
+    // WinHTTP on Windows, the socket backend everywhere else. Room for
+    // maxConnectionsPerHost concurrent requests is kept open per host.
+    static std::unique_ptr<HttpClient> Create(size_t maxConnectionsPerHost = 4);
+};
@@ -5,11 +5,13 @@
 #include "ConfigManager.h"
 #include "SettingsDialog.h"
 #include "SimpleLogger.h"
+#include "TimelineTrace.h"
 #include "resource.h"
 #include <windows.h>
 #include <commctrl.h>
 #include <commdlg.h>
 #include <shellapi.h>
+#include <ctime>
 #include <iostream>
 #include <sstream>
 
@@ -19,6 +21,17 @@
 const wchar_t* WINDOW_CLASS_NAME = L"TeamsTranscriptionMainWindow";
 const int TIMER_UPDATE_STATS = 1;
 const int TIMER_AUTO_SAVE = 2;
+const int TIMER_CANCEL_UPLOADS = 3;
+
+// Uploads still running this long after recording stops are abandoned
+const UINT STOP_UPLOAD_GRACE_MS = 5000;
+
+// Extra history space so an export can finish reading before the writer laps it
+const uint32_t AUDIO_HISTORY_GUARD_SECONDS = 2;
+const int AUDIO_EXPORT_ATTEMPTS = 3;
+
+// The latency metrics file is rewritten every this many stats ticks while recording
+const uint32_t LATENCY_METRICS_TICKS = 10;
 
 // Control IDs
 enum ControlIds {
@@ -44,6 +57,7 @@ MainWindow::MainWindow()
     , hInstance(nullptr)
     , isRecording(false)
     , isPaused(false)
+    , statsTicks(0)
 {
     memset(&notifyIconData, 0, sizeof(notifyIconData));
 }
@@ -52,6 +66,7 @@ MainWindow::~MainWindow() {
     if (notifyIconData.hWnd) {
         Shell_NotifyIcon(NIM_DELETE, &notifyIconData);
     }
+    TimelineTrace::Stop();
 }
 
 bool MainWindow::Create(HINSTANCE hInst, int nCmdShow) {
@@ -136,6 +151,14 @@ bool MainWindow::InitializeComponents() {
         bool configLoaded = configManager->LoadConfig();
         INFO_LOG("Config loaded: " + std::string(configLoaded ? "SUCCESS" : "FAILED"));
         
+        // Messages below this level are dropped before they are formatted
+        SimpleLogger::SetLevel(SimpleLogger::ParseLevel(configManager->GetConfig().logLevel, SimpleLogger::Level::Debug));
+
+        TimelineTrace::SetThreadName("UI");
+        if (!configManager->GetConfig().timelineTracePath.empty()) {
+            TimelineTrace::Start(configManager->GetConfig().timelineTracePath);
+        }
+
         if (configLoaded) {
             auto config = configManager->GetConfig();
             CONFIG_LOG("Provider", std::to_string((int)config.speechConfig.provider));
@@ -153,8 +176,13 @@ bool MainWindow::InitializeComponents() {
             MessageBox(hwnd, L"Failed to initialize audio capture", L"Error", MB_OK | MB_ICONERROR);
             return false;
         }
+        audioCapture->SetTraceFile(configManager->GetConfig().captureTracePath);
+
+        latency = std::make_shared<PipelineLatency>();
+        audioCapture->SetLatencyTracker(latency);
 
         speechRecognition = std::make_unique<SpeechRecognition>();
+        speechRecognition->SetLatencyTracker(latency);
         auto speechConfig = configManager->GetSpeechConfig();
         
         // Debug output
@@ -179,6 +207,17 @@ bool MainWindow::InitializeComponents() {
             UpdateTranscription(text, confidence);
         });
 
+        // Audio a previous run could not upload, labelled with when it was recorded
+        speechRecognition->SetRecoveredCallback([this](const SpeechRecognition::RecoveredTranscript& transcript) {
+            std::time_t capturedAt = static_cast<std::time_t>(transcript.capturedAtMs / 1000);
+            std::tm local = {};
+            char when[32] = "";
+            if (localtime_s(&local, &capturedAt) == 0) {
+                std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M", &local);
+            }
+            UpdateTranscription("[Recorded " + std::string(when) + "] " + transcript.text, transcript.confidence);
+        });
+
         return true;
     }
     catch (const std::exception& e) {
@@ -307,6 +346,11 @@ LRESULT MainWindow::HandleMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPa
             return 0;
 
         case WM_DESTROY:
+            // Nothing is left to show results in; do not hold shutdown on the network
+            KillTimer(hwnd, TIMER_CANCEL_UPLOADS);
+            if (speechRecognition) {
+                speechRecognition->CancelUploads();
+            }
             PostQuitMessage(0);
             return 0;
     }
@@ -354,6 +398,13 @@ LRESULT MainWindow::HandleTimer(WPARAM timerId) {
                 AutoSaveTranscription();
             }
             break;
+
+        case TIMER_CANCEL_UPLOADS:
+            KillTimer(hwnd, TIMER_CANCEL_UPLOADS);
+            if (speechRecognition && !isRecording.load()) {
+                speechRecognition->CancelUploads();
+            }
+            break;
     }
     return 0;
 }
@@ -411,11 +462,14 @@ void MainWindow::StartRecording() {
         return;
     }
     
-    // Clear audio buffer when starting new recording
-    {
-        std::lock_guard<std::mutex> lock(audioBufferMutex);
-        recordedAudioBuffer.clear();
-        INFO_LOG("MainWindow: Audio buffer cleared for new recording");
+    // Size the export history for the capture format; capture is stopped, so nothing is writing
+    if (audioCapture) {
+        audioFormat = audioCapture->GetAudioFormat();
+        uint32_t historySeconds = configManager ? configManager->GetConfig().audioHistorySeconds : 30;
+        audioHistory.Reset(static_cast<size_t>(audioFormat.bytesPerSecond) * historySeconds,
+                           static_cast<size_t>(audioFormat.bytesPerSecond) * AUDIO_HISTORY_GUARD_SECONDS);
+        INFO_LOG("MainWindow: Audio history reset for new recording - " + std::to_string(historySeconds) + "s, " +
+                 std::to_string(audioHistory.RetainedBytes()) + " bytes");
     }
 
     // Check for consent if required
@@ -428,7 +482,15 @@ void MainWindow::StartRecording() {
         }
     }
 
+    // Uploads left over from the last recording carry on
+    KillTimer(hwnd, TIMER_CANCEL_UPLOADS);
+
     if (audioCapture) {
+        StartSessionRecorder();
+        if (latency) {
+            latency->Reset();
+        }
+
         HRESULT hr = audioCapture->StartCapture();
         if (SUCCEEDED(hr)) {
             isRecording.store(true);
@@ -449,6 +511,7 @@ void MainWindow::StartRecording() {
                 processMonitor->StartMonitoring();
             }
         } else {
+            StopSessionRecorder();
             MessageBox(hwnd, L"Failed to start audio capture", L"Error", MB_OK | MB_ICONERROR);
         }
     }
@@ -463,10 +526,23 @@ void MainWindow::StopRecording() {
         audioCapture->StopCapture();
     }
 
+    // Nothing writes to the recorder any more; finish the file
+    StopSessionRecorder();
+
+    // Capture has drained, so upload whatever the provider is still holding.
+    // Give those uploads a grace period, then abandon what is left; the UI
+    // thread must not wait here, since results are shown through it.
+    if (speechRecognition) {
+        speechRecognition->Flush();
+        SetTimer(hwnd, TIMER_CANCEL_UPLOADS, STOP_UPLOAD_GRACE_MS, nullptr);
+    }
+
     if (processMonitor) {
         processMonitor->StopMonitoring();
     }
 
+    WriteLatencyMetrics();
+
     isRecording.store(false);
     isPaused.store(false);
 
@@ -478,6 +554,39 @@ void MainWindow::StopRecording() {
     SetWindowText(GetDlgItem(hwnd, ID_STATUS_BAR), L"Stopped");
 }
 
+void MainWindow::StartSessionRecorder() {
+    if (!configManager || !configManager->GetConfig().recordSession) {
+        return;
+    }
+
+    const auto& config = configManager->GetConfig();
+    SessionRecorder::Settings settings;
+    settings.directory = config.outputDirectory;
+    settings.maxSegmentBytes = static_cast<uint64_t>(config.maxSegmentMB) * 1024 * 1024;
+
+    sessionRecorder = std::make_unique<SessionRecorder>();
+    if (!sessionRecorder->Start(settings, audioFormat.sampleRate, audioFormat.channels, audioFormat.bitsPerSample)) {
+        sessionRecorder.reset();
+        UpdateDebugLog("Session recording could not start - check the output directory");
+        return;
+    }
+    UpdateDebugLog("Recording session to " + sessionRecorder->GetStats().currentFile);
+}
+
+void MainWindow::StopSessionRecorder() {
+    if (!sessionRecorder) {
+        return;
+    }
+
+    sessionRecorder->Stop();
+    SessionRecorder::Stats stats = sessionRecorder->GetStats();
+    if (stats.bytesDropped > 0 || stats.writeErrors > 0) {
+        UpdateDebugLog("Session recording lost " + std::to_string(stats.bytesDropped) + " bytes (" +
+                       std::to_string(stats.writeErrors) + " write errors)");
+    }
+    sessionRecorder.reset();
+}
+
 void MainWindow::TogglePause() {
     // For now, this is a simple implementation
     // In a full implementation, this would pause/resume audio processing
@@ -566,7 +675,7 @@ void MainWindow::ExportTranscription() {
     }
     
     // Also offer to export audio if available
-    if (!recordedAudioBuffer.empty()) {
+    if (audioHistory.Size() > 0) {
         int result = MessageBox(hwnd, L"Would you also like to export the recorded audio?", L"Export Audio", MB_YESNO | MB_ICONQUESTION);
         if (result == IDYES) {
             ExportAudioBuffer();
@@ -584,24 +693,12 @@ void MainWindow::AutoSaveTranscription() {
 }
 
 void MainWindow::ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) {
-    static int audioCallCount = 0;
-    audioCallCount++;
-    
-    // Store audio format for export
-    audioFormat = format;
-    
-    // Store audio data for export (limit buffer size to avoid memory issues)
-    {
-        std::lock_guard<std::mutex> lock(audioBufferMutex);
-        recordedAudioBuffer.insert(recordedAudioBuffer.end(), audioData.begin(), audioData.end());
-        
-        // Limit buffer to ~30 seconds of audio to avoid memory issues
-        size_t maxBufferSize = format.sampleRate * format.channels * (format.bitsPerSample / 8) * 30;
-        if (recordedAudioBuffer.size() > maxBufferSize) {
-            // Keep only the last 30 seconds
-            recordedAudioBuffer.erase(recordedAudioBuffer.begin(), 
-                recordedAudioBuffer.begin() + (recordedAudioBuffer.size() - maxBufferSize));
-        }
+    // Keep the most recent audio for export; the oldest is overwritten in place
+    audioHistory.Write(audioData.data(), audioData.size());
+
+    // Paused audio is left out of the session recording
+    if (sessionRecorder && !isPaused.load()) {
+        sessionRecorder->Write(audioData.data(), audioData.size());
     }
     
     // Log detailed audio information
@@ -610,20 +707,11 @@ void MainWindow::ProcessAudioData(const std::vector<BYTE>& audioData, const Audi
               "Channels: " + std::to_string(format.channels) + ", " +
               "Bits: " + std::to_string(format.bitsPerSample));
     
-    if (audioCallCount % 100 == 0) { // Log summary every 100th call
-        INFO_LOG("ProcessAudioData called " + std::to_string(audioCallCount) + " times, latest size: " + std::to_string(audioData.size()) + " bytes");
-    }
-    
-    // Log audio samples for debugging (every 50th call to avoid spam)
-    if (audioCallCount % 50 == 0) {
-        DEBUG_LOG("Audio sample #" + std::to_string(audioCallCount) + " - " + std::to_string(audioData.size()) + " bytes");
-    }
+    LOG_EVERY_N(Info, 100, "ProcessAudioData - 100 more packets, latest size: " + std::to_string(audioData.size()) + " bytes");
     
     if (isPaused.load() || !speechRecognition) {
-        if (audioCallCount % 100 == 0) {
-            WARN_LOG("Audio processing skipped - paused: " + std::string(isPaused.load() ? "true" : "false") + 
-                    ", speechRecognition: " + (speechRecognition ? "valid" : "null"));
-        }
+        LOG_RATE_LIMITED(Warn, 1, 5000, "Audio processing skipped - paused: " + std::string(isPaused.load() ? "true" : "false") + 
+                         ", speechRecognition: " + (speechRecognition ? "valid" : "null"));
         return;
     }
 
@@ -634,6 +722,7 @@ void MainWindow::ProcessAudioData(const std::vector<BYTE>& audioData, const Audi
 }
 
 void MainWindow::UpdateTranscription(const std::string& text, double confidence) {
+    TRACE_SCOPE("UpdateTranscription");
     INFO_LOG("UpdateTranscription called with text: '" + text + "', confidence: " + std::to_string(confidence));
     
     if (text.empty()) {
@@ -681,6 +770,7 @@ void MainWindow::UpdateTranscription(const std::string& text, double confidence)
 }
 
 void MainWindow::UpdateDebugLog(const std::string& debugInfo) {
+    TRACE_SCOPE("UpdateDebugLog");
     if (debugInfo.empty()) {
         return;
     }
@@ -707,6 +797,7 @@ void MainWindow::UpdateDebugLog(const std::string& debugInfo) {
 }
 
 void MainWindow::UpdateTeamsStatus(bool isInMeeting, const std::string& meetingInfo) {
+    TRACE_SCOPE("UpdateTeamsStatus");
     std::string updateMsg = "MainWindow: UpdateTeamsStatus called - isInMeeting: " + 
                           std::string(isInMeeting ? "YES" : "NO") + 
                           ", meetingInfo: " + meetingInfo;
@@ -741,6 +832,7 @@ void MainWindow::UpdateTeamsStatus(bool isInMeeting, const std::string& meetingI
 }
 
 void MainWindow::UpdateCaptureStats() {
+    TRACE_SCOPE("UpdateCaptureStats");
     if (!audioCapture) {
         return;
     }
@@ -751,9 +843,37 @@ void MainWindow::UpdateCaptureStats() {
     statusText << L"Captured: " << stats.totalFramesCaptured << L" frames, "
                << L"Time: " << static_cast<int>(stats.captureTimeSeconds) << L"s";
 
+    if (speechRecognition) {
+        auto vad = speechRecognition->GetVadStats();
+        if (vad.enabled) {
+            uint64_t analyzed = vad.speechFrames + vad.silenceFrames;
+            int speechPercent = analyzed > 0 ? static_cast<int>(vad.speechFrames * 100 / analyzed) : 0;
+            statusText << L", Speech: " << speechPercent << L"%"
+                       << (vad.speechActive ? L" (active)" : L"")
+                       << L", Skipped: " << vad.chunksSkipped << L" chunks";
+        }
+    }
+
+    if (latency) {
+        std::string latencyText = latency->FormatStatus();
+        if (!latencyText.empty()) {
+            statusText << L", " << std::wstring(latencyText.begin(), latencyText.end());
+        }
+        if (isRecording.load() && ++statsTicks % LATENCY_METRICS_TICKS == 0) {
+            WriteLatencyMetrics();
+        }
+    }
+
     SetWindowText(GetDlgItem(hwnd, ID_STATUS_BAR), statusText.str().c_str());
 }
 
+void MainWindow::WriteLatencyMetrics() {
+    if (!latency || !configManager || configManager->GetConfig().latencyMetricsPath.empty()) {
+        return;
+    }
+    latency->WriteMetricsFile(configManager->GetConfig().latencyMetricsPath);
+}
+
 void MainWindow::ExportAudioBuffer() {
     // Create save dialog for audio
     OPENFILENAME ofn = {};
@@ -771,9 +891,7 @@ void MainWindow::ExportAudioBuffer() {
     ofn.Flags = OFN_PATHMUSTEXIST | OFN_OVERWRITEPROMPT;
     
     if (GetSaveFileName(&ofn)) {
-        std::lock_guard<std::mutex> lock(audioBufferMutex);
-        
-        if (!recordedAudioBuffer.empty()) {
+        if (audioHistory.Size() > 0) {
             // Create WAV file
             HANDLE hFile = CreateFile(szFile, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
             if (hFile != INVALID_HANDLE_VALUE) {
@@ -799,19 +917,38 @@ void MainWindow::ExportAudioBuffer() {
                 wavHeader.bitsPerSample = audioFormat.bitsPerSample;
                 wavHeader.blockAlign = wavHeader.channels * (wavHeader.bitsPerSample / 8);
                 wavHeader.byteRate = wavHeader.sampleRate * wavHeader.blockAlign;
-                wavHeader.dataSize = recordedAudioBuffer.size();
-                wavHeader.fileSize = wavHeader.dataSize + sizeof(wavHeader) - 8;
-                
-                DWORD bytesWritten;
-                WriteFile(hFile, &wavHeader, sizeof(wavHeader), &bytesWritten, NULL);
-                WriteFile(hFile, recordedAudioBuffer.data(), recordedAudioBuffer.size(), &bytesWritten, NULL);
+
+                // Write straight from the history; recording keeps going meanwhile, so
+                // start over in the unlikely case the writer laps the snapshot
+                AudioHistoryBuffer::Snapshot snapshot = {};
+                bool intact = false;
+                for (int attempt = 0; attempt < AUDIO_EXPORT_ATTEMPTS && !intact; ++attempt) {
+                    snapshot = audioHistory.Acquire();
+                    wavHeader.dataSize = static_cast<uint32_t>(snapshot.Size());
+                    wavHeader.fileSize = wavHeader.dataSize + sizeof(wavHeader) - 8;
+
+                    DWORD bytesWritten;
+                    SetFilePointer(hFile, 0, NULL, FILE_BEGIN);
+                    SetEndOfFile(hFile);
+                    WriteFile(hFile, &wavHeader, sizeof(wavHeader), &bytesWritten, NULL);
+                    WriteFile(hFile, snapshot.first, static_cast<DWORD>(snapshot.firstSize), &bytesWritten, NULL);
+                    if (snapshot.secondSize > 0) {
+                        WriteFile(hFile, snapshot.second, static_cast<DWORD>(snapshot.secondSize), &bytesWritten, NULL);
+                    }
+                    intact = audioHistory.IsIntact(snapshot);
+                }
                 CloseHandle(hFile);
-                
-                std::wstring message = L"Audio exported successfully to:\n" + std::wstring(szFile) + 
-                                     L"\n\nDuration: " + std::to_wstring(recordedAudioBuffer.size() / (audioFormat.sampleRate * audioFormat.channels * audioFormat.bitsPerSample / 8)) + L" seconds";
-                MessageBox(hwnd, message.c_str(), L"Export Successful", MB_OK | MB_ICONINFORMATION);
-                INFO_LOG("Audio exported to: " + std::string(szFile, szFile + wcslen(szFile)) + 
-                         ", Size: " + std::to_string(recordedAudioBuffer.size()) + " bytes");
+
+                if (intact) {
+                    std::wstring message = L"Audio exported successfully to:\n" + std::wstring(szFile) + 
+                                         L"\n\nDuration: " + std::to_wstring(snapshot.Size() / audioFormat.bytesPerSecond) + L" seconds";
+                    MessageBox(hwnd, message.c_str(), L"Export Successful", MB_OK | MB_ICONINFORMATION);
+                    INFO_LOG("Audio exported to: " + std::string(szFile, szFile + wcslen(szFile)) + 
+                             ", Size: " + std::to_string(snapshot.Size()) + " bytes");
+                } else {
+                    MessageBox(hwnd, L"Audio changed while it was being exported; please try again", L"Export Error", MB_OK | MB_ICONERROR);
+                    ERROR_LOG("Audio export overtaken by the capture writer " + std::to_string(AUDIO_EXPORT_ATTEMPTS) + " times");
+                }
             } else {
                 MessageBox(hwnd, L"Failed to create audio export file", L"Export Error", MB_OK | MB_ICONERROR);
                 ERROR_LOG("Failed to create audio export file");
@@ -8,6 +8,9 @@
 #include <mutex>
 #include <shellapi.h>
 #include "AudioCapture.h"
+#include "AudioHistoryBuffer.h"
+#include "PipelineLatency.h"
+#include "SessionRecorder.h"
 
 class ProcessMonitor;
 class SpeechRecognition;
@@ -37,10 +40,16 @@ private:
     
     NOTIFYICONDATA notifyIconData;
     
-    // Audio buffer for export
-    std::vector<BYTE> recordedAudioBuffer;
+    // Most recent audio for export, written by the processing thread
+    AudioHistoryBuffer audioHistory;
     AudioCapture::AudioFormat audioFormat;
-    std::mutex audioBufferMutex;
+
+    // Whole-session recording to disk, when enabled
+    std::unique_ptr<SessionRecorder> sessionRecorder;
+
+    // Per-stage latency from capture to display, shared with capture and recognition
+    std::shared_ptr<PipelineLatency> latency;
+    uint32_t statsTicks;
     
     // Transcription buffer for export
     std::wstring fullTranscription;
@@ -59,6 +68,8 @@ private:
 
     void StartRecording();
     void StopRecording();
+    void StartSessionRecorder();
+    void StopSessionRecorder();
     void TogglePause();
     void ShowSettingsDialog();
     void ExportTranscription();
@@ -71,4 +82,5 @@ private:
     void UpdateDebugLog(const std::string& debugInfo);
     void UpdateTeamsStatus(bool isInMeeting, const std::string& meetingInfo);
     void UpdateCaptureStats();
+    void WriteLatencyMetrics();
 };
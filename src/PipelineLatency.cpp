@@ -0,0 +1,215 @@
+#include "PipelineLatency.h"
+#include "SimpleLogger.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+bool IsSet(const ChunkTrace::TimePoint& point) {
+    return point != ChunkTrace::TimePoint();
+}
+
+double RoundMs(double value) {
+    return std::round(value * 1000.0) / 1000.0;
+}
+
+std::string FormatPercentiles(const LatencyHistogram::Summary& summary) {
+    char text[64];
+    // Milliseconds until the tail reaches a second
+    if (summary.p99Ms < 1000.0) {
+        std::snprintf(text, sizeof(text), "%.0f/%.0f/%.0f ms", summary.p50Ms, summary.p95Ms, summary.p99Ms);
+    } else {
+        std::snprintf(text, sizeof(text), "%.1f/%.1f/%.1f s", summary.p50Ms / 1000.0, summary.p95Ms / 1000.0,
+                      summary.p99Ms / 1000.0);
+    }
+    return text;
+}
+
+} // namespace
+
+// LatencyHistogram
+
+LatencyHistogram::LatencyHistogram() {
+    Reset();
+}
+
+void LatencyHistogram::Record(uint64_t micros) {
+    counts[BucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    totalMicros.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t previous = maxMicros.load(std::memory_order_relaxed);
+    while (micros > previous && !maxMicros.compare_exchange_weak(previous, micros, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::Record(std::chrono::steady_clock::duration duration) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    Record(static_cast<uint64_t>(micros > 0 ? micros : 0));
+}
+
+LatencyHistogram::Summary LatencyHistogram::GetSummary() const {
+    Summary summary{};
+
+    // Copy first so the percentiles agree with one total even while writers run
+    std::vector<uint64_t> snapshot(BUCKET_COUNT);
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        snapshot[i] = counts[i].load(std::memory_order_relaxed);
+        summary.count += snapshot[i];
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    double maxMs = maxMicros.load(std::memory_order_relaxed) / 1000.0;
+    summary.maxMs = maxMs;
+    summary.meanMs = totalMicros.load(std::memory_order_relaxed) / 1000.0 / summary.count;
+
+    auto percentile = [&](double fraction) {
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * summary.count)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += snapshot[i];
+            if (seen >= rank) {
+                return std::min(BucketMidpoint(i) / 1000.0, maxMs);
+            }
+        }
+        return maxMs;
+    };
+    summary.p50Ms = percentile(0.50);
+    summary.p95Ms = percentile(0.95);
+    summary.p99Ms = percentile(0.99);
+    return summary;
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    totalMicros.store(0, std::memory_order_relaxed);
+    maxMicros.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t micros) {
+    if (micros < 2 * SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+
+    int topBit = 63;
+    while ((micros >> topBit) == 0) {
+        --topBit;
+    }
+    if (topBit >= MAX_VALUE_BITS) {
+        return BUCKET_COUNT - 1;
+    }
+
+    // Keep the top SUB_BUCKET_BITS + 1 bits: the octave picks the group, the rest the bucket
+    int shift = topBit - SUB_BUCKET_BITS;
+    uint64_t top = micros >> shift;
+    return static_cast<size_t>(2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + (top - SUB_BUCKETS));
+}
+
+uint64_t LatencyHistogram::BucketMidpoint(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    size_t offset = index - 2 * SUB_BUCKETS;
+    int shift = static_cast<int>(offset / SUB_BUCKETS) + 1;
+    uint64_t lower = (SUB_BUCKETS + offset % SUB_BUCKETS) << shift;
+    return lower + ((1ull << shift) >> 1);
+}
+
+// PipelineLatency
+
+void PipelineLatency::Record(Stage stage, std::chrono::steady_clock::duration duration) {
+    histograms[static_cast<size_t>(stage)].Record(duration);
+}
+
+void PipelineLatency::RecordChunk(const ChunkTrace& trace) {
+    auto span = [this](Stage stage, const ChunkTrace::TimePoint& start, const ChunkTrace::TimePoint& end) {
+        if (IsSet(start) && IsSet(end)) {
+            Record(stage, end - start);
+        }
+    };
+
+    span(Stage::Segment, trace.audioArrived, trace.enqueued);
+    span(Stage::Queue, trace.enqueued, trace.dequeued);
+    span(Stage::Send, trace.dequeued, trace.firstByte);
+    span(Stage::Receive, trace.firstByte, trace.received);
+    span(Stage::Parse, trace.received, trace.parsed);
+    span(Stage::Reorder, trace.completed, trace.delivered);
+    span(Stage::Display, trace.delivered, trace.displayed);
+    span(Stage::Total, trace.audioArrived, trace.displayed);
+}
+
+LatencyHistogram::Summary PipelineLatency::GetSummary(Stage stage) const {
+    return histograms[static_cast<size_t>(stage)].GetSummary();
+}
+
+void PipelineLatency::Reset() {
+    for (auto& histogram : histograms) {
+        histogram.Reset();
+    }
+}
+
+std::string PipelineLatency::FormatStatus() const {
+    LatencyHistogram::Summary total = GetSummary(Stage::Total);
+    if (total.count == 0) {
+        return "";
+    }
+    return "Latency p50/p95/p99 " + FormatPercentiles(total) + " (send " + FormatPercentiles(GetSummary(Stage::Send)) + ")";
+}
+
+bool PipelineLatency::WriteMetricsFile(const std::string& path) const {
+    nlohmann::json stages = nlohmann::json::object();
+    for (size_t i = 0; i < histograms.size(); ++i) {
+        LatencyHistogram::Summary summary = histograms[i].GetSummary();
+        stages[StageName(static_cast<Stage>(i))] = {
+            {"count", summary.count},
+            {"mean_ms", RoundMs(summary.meanMs)},
+            {"p50_ms", RoundMs(summary.p50Ms)},
+            {"p95_ms", RoundMs(summary.p95Ms)},
+            {"p99_ms", RoundMs(summary.p99Ms)},
+            {"max_ms", RoundMs(summary.maxMs)}
+        };
+    }
+
+    // Readers polling the file never see it half written
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        file << nlohmann::json{{"stages", stages}}.dump(2) << "\n";
+        if (!file) {
+            LOG_RATE_LIMITED(Warn, 1, 60000, "PipelineLatency: cannot write " + temporaryPath);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        LOG_RATE_LIMITED(Warn, 1, 60000, "PipelineLatency: cannot replace " + path + ": " + error.message());
+        return false;
+    }
+    return true;
+}
+
+const char* PipelineLatency::StageName(Stage stage) {
+    switch (stage) {
+        case Stage::Capture: return "capture";
+        case Stage::Convert: return "convert";
+        case Stage::Segment: return "segment";
+        case Stage::Queue: return "queue";
+        case Stage::Send: return "send";
+        case Stage::Receive: return "receive";
+        case Stage::Parse: return "parse";
+        case Stage::Reorder: return "reorder";
+        case Stage::Display: return "display";
+        case Stage::Total: return "total";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Log-linear histogram of durations in microseconds, in the style of
+// HdrHistogram: exact below 64 us, then 32 buckets per power of two, so any
+// reported value is within about 3% of the recorded one. Record is a relaxed
+// atomic increment and safe from any thread; readers see a consistent enough
+// picture for monitoring without stopping writers.
+class LatencyHistogram {
+public:
+    struct Summary {
+        uint64_t count;
+        double meanMs;
+        double p50Ms;
+        double p95Ms;
+        double p99Ms;
+        double maxMs;
+    };
+
+    LatencyHistogram();
+
+    void Record(uint64_t micros);
+    void Record(std::chrono::steady_clock::duration duration);
+
+    Summary GetSummary() const;
+    void Reset();
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 40;   // About 12 days; longer values land in the last bucket
+    static constexpr size_t BUCKET_COUNT = 2 * SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts;
+    std::atomic<uint64_t> totalMicros;
+    std::atomic<uint64_t> maxMicros;
+
+    static size_t BucketIndex(uint64_t micros);
+    static uint64_t BucketMidpoint(size_t index);
+};
+
+// Timestamps one uploaded chunk collects on its way from the first audio
+// that went into it to the text being shown. Unset points are left at the
+// clock's epoch and the stages that need them are not recorded.
+struct ChunkTrace {
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    TimePoint audioArrived;     // First packet of the chunk reached the recognizer
+    TimePoint enqueued;         // Cut and handed to the upload queue
+    TimePoint dequeued;         // Picked up by an upload worker
+    TimePoint firstByte;        // First response byte from the service
+    TimePoint received;         // Whole response read
+    TimePoint parsed;           // Transcript extracted
+    TimePoint completed;        // Upload finished, waiting for earlier chunks
+    TimePoint delivered;        // Released in capture order
+    TimePoint displayed;        // Transcription callbacks returned
+};
+
+// Per-stage latency of the transcription pipeline, shared by capture, the
+// recognizer and whoever reports it
+class PipelineLatency {
+public:
+    enum class Stage {
+        Capture,        // Capture thread to processing thread, per packet
+        Convert,        // Downmix, resample and convert, per packet
+        Segment,        // First audio of a chunk until the chunk is cut
+        Queue,          // Waiting for an upload worker
+        Send,           // Worker pickup to the first response byte
+        Receive,        // Rest of the response
+        Parse,
+        Reorder,        // Waiting for earlier chunks to finish
+        Display,        // Transcription callbacks, e.g. UpdateTranscription
+        Total,          // First audio of a chunk until its text is displayed
+        Count
+    };
+
+    void Record(Stage stage, std::chrono::steady_clock::duration duration);
+
+    // Records every stage whose start and end the trace has
+    void RecordChunk(const ChunkTrace& trace);
+
+    LatencyHistogram::Summary GetSummary(Stage stage) const;
+    void Reset();
+
+    // One line for a status bar, e.g. "Latency p50/p95/p99 2.1/3.4/4.0 s (send 0.8/1.2/1.9 s)"
+    std::string FormatStatus() const;
+
+    // Writes every stage's percentiles as JSON, replacing the file atomically
+    bool WriteMetricsFile(const std::string& path) const;
+
+    static const char* StageName(Stage stage);
+
+private:
+    std::array<LatencyHistogram, static_cast<size_t>(Stage::Count)> histograms;
+};
@@ -1,5 +1,6 @@
 #include "ProcessMonitor.h"
 #include "SimpleLogger.h"
+#include "TimelineTrace.h"
 #include <windows.h>
 #include <tlhelp32.h>
 #include <psapi.h>
@@ -100,8 +101,10 @@ std::vector<ProcessMonitor::ProcessInfo> ProcessMonitor::GetTeamsProcesses() con
 
 void ProcessMonitor::MonitoringThreadProc() {
     INFO_LOG("ProcessMonitor: Monitoring thread started");
+    TimelineTrace::SetThreadName("Process monitor");
     
     while (isMonitoring.load()) {
+        TimelineTrace::Scope check("CheckTeamsStatus");
         bool teamsFound = FindTeamsProcesses();
         bool inMeeting = CheckMeetingStatus();
         
@@ -131,6 +134,7 @@ void ProcessMonitor::MonitoringThreadProc() {
         lastTeamsFound = teamsFound;
         
         // Sleep for 2 seconds before next check
+        check.End();
         std::this_thread::sleep_for(std::chrono::seconds(2));
     }
     
@@ -0,0 +1,75 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace ResamplerDesign;
+
+PolyphaseResampler::PolyphaseResampler(uint32_t inputRate, uint32_t outputRate)
+    : inputRate(inputRate)
+    , outputRate(outputRate)
+    , coefficients(nullptr)
+    , historyCount(0)
+    , inputPosition(0)
+    , phase(0)
+{
+    // Capture rates we see in practice use the compile-time tables
+    if (inputRate == 48000 && outputRate == 16000) {
+        using Table = PolyphaseTable<48000, 16000>;
+        upFactor = Table::UP; downFactor = Table::DOWN; taps = Table::TAPS;
+        coefficients = Table::coefficients.data();
+    } else if (inputRate == 44100 && outputRate == 16000) {
+        using Table = PolyphaseTable<44100, 16000>;
+        upFactor = Table::UP; downFactor = Table::DOWN; taps = Table::TAPS;
+        coefficients = Table::coefficients.data();
+    } else if (inputRate == 32000 && outputRate == 16000) {
+        using Table = PolyphaseTable<32000, 16000>;
+        upFactor = Table::UP; downFactor = Table::DOWN; taps = Table::TAPS;
+        coefficients = Table::coefficients.data();
+    } else {
+        uint32_t divisor = std::gcd(inputRate, outputRate);
+        upFactor = static_cast<int>(outputRate / divisor);
+        downFactor = static_cast<int>(inputRate / divisor);
+        taps = TapsPerPhase(inputRate, outputRate);
+        designedCoefficients.resize(static_cast<size_t>(upFactor) * taps);
+        DesignPolyphaseFilter(designedCoefficients, upFactor, downFactor, taps);
+        coefficients = designedCoefficients.data();
+    }
+
+    history.resize(taps - 1 + BLOCK_SIZE);
+    Reset();
+}
+
+void PolyphaseResampler::Reset() {
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyCount = taps - 1;
+    inputPosition = taps - 1;
+    phase = 0;
+}
+
+size_t PolyphaseResampler::MaxOutputSamples(size_t inputCount) const {
+    return (inputCount * upFactor) / downFactor + 2;
+}
+
+size_t PolyphaseResampler::Process(const float* input, size_t inputCount, float* output) {
+    return Process(inputCount,
+        [input](float* destination, size_t offset, size_t count) {
+            std::memcpy(destination, input + offset, count * sizeof(float));
+        },
+        [output](size_t index, float value) {
+            output[index] = value;
+        });
+}
+
+size_t PolyphaseResampler::Process(const int16_t* input, size_t inputCount, int16_t* output) {
+    return Process(inputCount,
+        [input](float* destination, size_t offset, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] = static_cast<float>(input[offset + i]);
+            }
+        },
+        [output](size_t index, float value) {
+            float rounded = std::nearbyint(value);
+            output[index] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, rounded)));
+        });
+}
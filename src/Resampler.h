@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+// Windowed-sinc filter design for polyphase resampling. Everything here is
+// constexpr so the tables for the common capture rates are built by the
+// compiler; the same code designs filters for other rates at runtime.
+namespace ResamplerDesign {
+
+constexpr double PI = 3.14159265358979323846;
+
+// sin(x) by range reduction and a Taylor series (std::sin is not constexpr)
+constexpr double Sin(double x) {
+    while (x > PI) x -= 2.0 * PI;
+    while (x < -PI) x += 2.0 * PI;
+    if (x > PI / 2.0) x = PI - x;
+    if (x < -PI / 2.0) x = -PI - x;
+
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; ++n) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double Cos(double x) {
+    return Sin(x + PI / 2.0);
+}
+
+// Taps per polyphase branch: enough for a ~0.17 fs_out transition band
+constexpr int TapsPerPhase(uint32_t inputRate, uint32_t outputRate) {
+    uint32_t lower = inputRate < outputRate ? inputRate : outputRate;
+    return static_cast<int>((2 * inputRate + lower - 1) / lower) * 32;
+}
+
+// Fills out[p * taps + i] with the coefficients of phase p, stored reversed so
+// output = dot(out[p * taps ...], the last `taps` input samples, oldest first).
+// Prototype is a Blackman-windowed sinc at the upsampled rate L * fs_in with
+// its cutoff at 0.875 of the lower Nyquist frequency, scaled by L for unity gain.
+// sin/cos are advanced with the Chebyshev recurrence so the cost per coefficient
+// stays small enough for compile-time evaluation.
+template <typename Output>
+constexpr void DesignPolyphaseFilter(Output& out, int upFactor, int downFactor, int taps) {
+    const int length = upFactor * taps;
+    const double lowerRate = upFactor < downFactor ? upFactor : downFactor;
+    const double cutoff = 0.4375 * lowerRate / (static_cast<double>(upFactor) * downFactor); // cycles per upsampled sample
+    const double center = (length - 1) / 2.0;
+
+    // sin(theta * (i - center)) for the sinc numerator
+    const double theta = 2.0 * PI * cutoff;
+    const double sincStep = 2.0 * Cos(theta);
+    double sinPrevious = Sin(theta * (-1.0 - center));
+    double sinCurrent = Sin(theta * (0.0 - center));
+
+    // cos(2 pi i / (N - 1)) and cos(4 pi i / (N - 1)) for the Blackman window
+    const double windowTheta = length > 1 ? 2.0 * PI / (length - 1) : 0.0;
+    const double cos1Step = 2.0 * Cos(windowTheta);
+    const double cos2Step = 2.0 * Cos(2.0 * windowTheta);
+    double cos1Previous = Cos(-windowTheta);
+    double cos1Current = 1.0;
+    double cos2Previous = Cos(-2.0 * windowTheta);
+    double cos2Current = 1.0;
+
+    for (int i = 0; i < length; ++i) {
+        double t = i - center;
+        double sinc = (t > -1e-9 && t < 1e-9) ? 2.0 * cutoff : sinCurrent / (PI * t);
+        double window = length > 1 ? 0.42 - 0.5 * cos1Current + 0.08 * cos2Current : 1.0;
+        double coefficient = sinc * window * upFactor;
+
+        // Tap i belongs to phase i % L at delay i / L; store delays reversed
+        int phase = i % upFactor;
+        int delay = i / upFactor;
+        out[phase * taps + (taps - 1 - delay)] = static_cast<float>(coefficient);
+
+        double sinNext = sincStep * sinCurrent - sinPrevious;
+        sinPrevious = sinCurrent;
+        sinCurrent = sinNext;
+        double cos1Next = cos1Step * cos1Current - cos1Previous;
+        cos1Previous = cos1Current;
+        cos1Current = cos1Next;
+        double cos2Next = cos2Step * cos2Current - cos2Previous;
+        cos2Previous = cos2Current;
+        cos2Current = cos2Next;
+    }
+}
+
+// Filter table for a fixed rate pair, evaluated at compile time
+template <uint32_t InputRate, uint32_t OutputRate>
+struct PolyphaseTable {
+    static constexpr uint32_t DIVISOR = std::gcd(InputRate, OutputRate);
+    static constexpr int UP = static_cast<int>(OutputRate / DIVISOR);
+    static constexpr int DOWN = static_cast<int>(InputRate / DIVISOR);
+    static constexpr int TAPS = TapsPerPhase(InputRate, OutputRate);
+
+    static constexpr std::array<float, UP * TAPS> Design() {
+        std::array<float, UP * TAPS> table = {};
+        DesignPolyphaseFilter(table, UP, DOWN, TAPS);
+        return table;
+    }
+
+    static constexpr std::array<float, UP * TAPS> coefficients = Design();
+};
+
+} // namespace ResamplerDesign
+
+// Streaming rational-ratio polyphase FIR resampler for mono audio.
+// Filter history and output phase carry over between Process calls, so a
+// stream cut into arbitrary chunks resamples exactly like one long buffer.
+// No allocation happens after construction.
+class PolyphaseResampler {
+public:
+    PolyphaseResampler(uint32_t inputRate, uint32_t outputRate);
+
+    uint32_t GetInputRate() const { return inputRate; }
+    uint32_t GetOutputRate() const { return outputRate; }
+
+    // Upper bound on the samples produced by the next Process(count) call
+    size_t MaxOutputSamples(size_t inputCount) const;
+
+    // Consume inputCount samples and write the resampled output; returns the
+    // number of samples written. Output must hold MaxOutputSamples(inputCount).
+    size_t Process(const float* input, size_t inputCount, float* output);
+    size_t Process(const int16_t* input, size_t inputCount, int16_t* output);
+
+    // Streaming core for fused stages. load(float* destination, size_t offset,
+    // size_t count) supplies input samples [offset, offset + count) as float;
+    // store(size_t index, float value) receives each output sample.
+    template <typename Load, typename Store>
+    size_t Process(size_t inputCount, Load load, Store store);
+
+    // Forget the history, e.g. at the start of a new recording
+    void Reset();
+
+private:
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    uint32_t inputRate;
+    uint32_t outputRate;
+    int upFactor;
+    int downFactor;
+    int taps;
+
+    const float* coefficients;
+    std::vector<float> designedCoefficients;  // Only used for uncommon rate pairs
+
+    // Input not yet discarded: at least the last taps-1 samples, plus up to
+    // BLOCK_SIZE more before the buffer is compacted
+    std::vector<float> history;
+    size_t historyCount;
+    size_t inputPosition;   // Index in history of the newest sample for the next output
+    int phase;
+};
+
+template <typename Load, typename Store>
+size_t PolyphaseResampler::Process(size_t inputCount, Load load, Store store) {
+    const size_t tapCount = static_cast<size_t>(taps);
+    size_t consumed = 0;
+    size_t produced = 0;
+
+    while (consumed < inputCount) {
+        // Compact only when the buffer is full, not on every call: small
+        // packets would otherwise pay for a memmove and the store-forwarding
+        // stalls of re-reading the moved samples each time
+        if (historyCount == history.size()) {
+            size_t discard = inputPosition + 1 - tapCount;
+            size_t keep = historyCount - discard;
+            std::memmove(history.data(), history.data() + discard, keep * sizeof(float));
+            historyCount = keep;
+            inputPosition -= discard;
+        }
+
+        // Append as much input as fits after the retained history
+        size_t room = history.size() - historyCount;
+        size_t take = inputCount - consumed < room ? inputCount - consumed : room;
+        load(history.data() + historyCount, consumed, take);
+        historyCount += take;
+        consumed += take;
+
+        // Emit every output whose newest input sample is available
+        while (inputPosition < historyCount) {
+            const float* window = history.data() + inputPosition + 1 - tapCount;
+            const float* phaseTaps = coefficients + static_cast<size_t>(phase) * tapCount;
+
+            // Four independent accumulators (taps is a multiple of 32) let the
+            // compiler keep the multiply-adds in flight / vectorize the loop
+            float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+            for (size_t k = 0; k < tapCount; k += 4) {
+                sum0 += phaseTaps[k] * window[k];
+                sum1 += phaseTaps[k + 1] * window[k + 1];
+                sum2 += phaseTaps[k + 2] * window[k + 2];
+                sum3 += phaseTaps[k + 3] * window[k + 3];
+            }
+            store(produced++, (sum0 + sum1) + (sum2 + sum3));
+
+            phase += downFactor;
+            inputPosition += phase / upFactor;
+            phase %= upFactor;
+        }
+    }
+
+    return produced;
+}
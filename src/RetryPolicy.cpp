@@ -0,0 +1,174 @@
+#include "RetryPolicy.h"
+#include "SimpleLogger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+std::mt19937& Random() {
+    thread_local std::mt19937 random(std::random_device{}());
+    return random;
+}
+
+bool ParseMilliseconds(const std::string& text, double scale, std::chrono::milliseconds& result) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0.0) {
+        return false;   // HTTP-date forms are not used by the service; fall back to backoff
+    }
+    result = std::chrono::milliseconds(static_cast<int64_t>(value * scale));
+    return true;
+}
+
+} // namespace
+
+// RetryPolicy
+
+bool RetryPolicy::IsRetryableStatus(int statusCode) {
+    return statusCode == 408 || statusCode == 429 || (statusCode >= 500 && statusCode <= 599);
+}
+
+std::chrono::milliseconds RetryPolicy::RetryAfter(const HttpResponse& response) {
+    std::chrono::milliseconds delay;
+    if (ParseMilliseconds(response.GetHeader("retry-after-ms"), 1.0, delay) ||
+        ParseMilliseconds(response.GetHeader("Retry-After"), 1000.0, delay)) {
+        return delay;
+    }
+    return std::chrono::milliseconds(-1);
+}
+
+std::chrono::milliseconds RetryPolicy::NextDelay(uint32_t retry, std::chrono::milliseconds retryAfter) const {
+    if (retryAfter.count() >= 0) {
+        return retryAfter;
+    }
+
+    uint32_t exponent = std::min<uint32_t>(retry > 0 ? retry - 1 : 0, 20);
+    uint64_t ceiling = std::min<uint64_t>(static_cast<uint64_t>(settings.baseDelayMs) << exponent, settings.maxDelayMs);
+    std::uniform_int_distribution<uint64_t> jitter(ceiling / 2, ceiling);
+    return std::chrono::milliseconds(jitter(Random()));
+}
+
+// RetryBudget
+
+RetryBudget::RetryBudget(double ratio, double minTokens)
+    : ratio(ratio)
+    , maxTokens(minTokens)
+    , tokens(minTokens)
+{
+}
+
+void RetryBudget::RecordRequest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tokens = std::min(maxTokens, tokens + ratio);
+}
+
+bool RetryBudget::TryRetry() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tokens < 1.0) {
+        return false;
+    }
+    tokens -= 1.0;
+    return true;
+}
+
+// CircuitBreaker
+
+CircuitBreaker::CircuitBreaker(const std::string& name, uint32_t failureThreshold, std::chrono::milliseconds openDuration)
+    : name(name)
+    , failureThreshold(failureThreshold > 0 ? failureThreshold : 1)
+    , openDuration(openDuration)
+    , state(State::Closed)
+    , consecutiveFailures(0)
+    , probeInFlight(false)
+{
+}
+
+bool CircuitBreaker::AllowRequest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    switch (state) {
+        case State::Closed:
+            return true;
+
+        case State::Open:
+            if (Clock::now() < openUntil) {
+                return false;
+            }
+            state = State::HalfOpen;
+            probeInFlight = true;
+            INFO_LOG("CircuitBreaker " + name + ": half-open, sending a probe");
+            return true;
+
+        case State::HalfOpen:
+            // Only the probe goes through until it reports back
+            if (probeInFlight) {
+                return false;
+            }
+            probeInFlight = true;
+            return true;
+    }
+    return true;
+}
+
+void CircuitBreaker::RecordSuccess() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != State::Closed) {
+        INFO_LOG("CircuitBreaker " + name + ": closed");
+    }
+    state = State::Closed;
+    consecutiveFailures = 0;
+    probeInFlight = false;
+}
+
+void CircuitBreaker::RecordAbandoned() {
+    std::lock_guard<std::mutex> lock(mutex);
+    probeInFlight = false;
+}
+
+void CircuitBreaker::RecordFailure(std::chrono::milliseconds retryAfter) {
+    std::lock_guard<std::mutex> lock(mutex);
+    consecutiveFailures++;
+    probeInFlight = false;
+
+    // The service said when it will take requests again; until then they only add to the throttling
+    if (retryAfter.count() > 0) {
+        throttledUntil = std::max(throttledUntil, Clock::now() + retryAfter);
+    }
+    if (state == State::HalfOpen || consecutiveFailures >= failureThreshold) {
+        Open(std::max(openDuration, retryAfter));
+    }
+}
+
+CircuitBreaker::Clock::time_point CircuitBreaker::GetThrottledUntil() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return throttledUntil;
+}
+
+CircuitBreaker::State CircuitBreaker::GetState() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state;
+}
+
+const char* CircuitBreaker::StateName(State state) {
+    switch (state) {
+        case State::Closed: return "closed";
+        case State::Open: return "open";
+        case State::HalfOpen: return "half-open";
+        default: return "unknown";
+    }
+}
+
+void CircuitBreaker::Open(std::chrono::milliseconds duration) {
+    Clock::time_point until = Clock::now() + duration;
+    if (state != State::Open || until > openUntil) {
+        openUntil = until;
+    }
+    if (state != State::Open) {
+        WARN_LOG("CircuitBreaker " + name + ": open for " + std::to_string(duration.count()) + " ms after " +
+                 std::to_string(consecutiveFailures) + " consecutive failures");
+    }
+    state = State::Open;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "HttpClient.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// When and how long to wait before retrying a failed provider call:
+// exponential backoff with jitter, unless the service said how long to wait.
+class RetryPolicy {
+public:
+    struct Settings {
+        uint32_t maxAttempts = 3;          // Including the first
+        uint32_t baseDelayMs = 500;
+        uint32_t maxDelayMs = 8000;
+    };
+
+    RetryPolicy() = default;
+    explicit RetryPolicy(const Settings& settings) : settings(settings) {}
+
+    // 408, 429 and 5xx are worth another try; other errors will fail again
+    static bool IsRetryableStatus(int statusCode);
+
+    // Delay the service asked for in retry-after-ms or Retry-After (seconds);
+    // negative if it gave none
+    static std::chrono::milliseconds RetryAfter(const HttpResponse& response);
+
+    // Wait before the given retry (1 for the first retry). retryAfter wins
+    // when present; otherwise a random delay in the upper half of
+    // base * 2^(retry - 1), capped at maxDelayMs.
+    std::chrono::milliseconds NextDelay(uint32_t retry, std::chrono::milliseconds retryAfter) const;
+
+    uint32_t GetMaxAttempts() const { return settings.maxAttempts; }
+
+private:
+    Settings settings;
+};
+
+// Caps retries at a fraction of first attempts so a struggling service does
+// not receive a multiple of the normal load. Every request earns ratio
+// tokens, every retry spends one; minTokens is always available.
+class RetryBudget {
+public:
+    RetryBudget(double ratio, double minTokens);
+
+    void RecordRequest();
+    bool TryRetry();
+
+private:
+    std::mutex mutex;
+    double ratio;
+    double maxTokens;
+    double tokens;
+};
+
+// Per-endpoint breaker. After failureThreshold consecutive failures calls
+// are refused until the open period ends; then one probe goes through and
+// its result closes or reopens it. It also remembers how long the endpoint
+// last asked callers to hold off, so every caller honours a Retry-After.
+class CircuitBreaker {
+public:
+    enum class State {
+        Closed,
+        Open,
+        HalfOpen
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    CircuitBreaker(const std::string& name, uint32_t failureThreshold, std::chrono::milliseconds openDuration);
+
+    // False while open; the caller should shed the request
+    bool AllowRequest();
+
+    void RecordSuccess();
+
+    // The call was abandoned and says nothing about the endpoint; frees the
+    // probe slot if it was the probe
+    void RecordAbandoned();
+
+    // retryAfter, when positive, holds every caller off that long and keeps
+    // the breaker open at least that long if it opens
+    void RecordFailure(std::chrono::milliseconds retryAfter);
+
+    // Until when the endpoint asked not to be called; in the past if it did not
+    Clock::time_point GetThrottledUntil() const;
+
+    State GetState() const;
+    static const char* StateName(State state);
+
+private:
+    mutable std::mutex mutex;
+    std::string name;
+    uint32_t failureThreshold;
+    std::chrono::milliseconds openDuration;
+
+    State state;
+    uint32_t consecutiveFailures;
+    Clock::time_point openUntil;
+    Clock::time_point throttledUntil;
+    bool probeInFlight;
+
+    void Open(std::chrono::milliseconds duration);
+};
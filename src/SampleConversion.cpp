@@ -0,0 +1,288 @@
+#include "SampleConversion.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SAMPLE_CONVERSION_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace SampleConversion {
+
+namespace {
+
+// Scalar reference; the SIMD versions must match it bit for bit
+void FloatToPCM16Scalar(const float* input, int16_t* output, size_t sampleCount) {
+    for (size_t i = 0; i < sampleCount; ++i) {
+        float sample = input[i] < 1.0f ? input[i] : 1.0f;   // NaN maps to 1.0
+        sample = sample > -1.0f ? sample : -1.0f;
+        output[i] = static_cast<int16_t>(sample * 32767.0f);
+    }
+}
+
+void StereoToMonoScalar(const int16_t* input, int16_t* output, size_t frameCount) {
+    for (size_t i = 0; i < frameCount; ++i) {
+        int32_t left = input[i * 2];
+        int32_t right = input[i * 2 + 1];
+        output[i] = static_cast<int16_t>((left + right) / 2);
+    }
+}
+
+// The same arithmetic as AudioConverter's float downmix and RoundToPCM16
+void StereoFloatToMonoScalar(const float* input, int16_t* output, size_t frameCount) {
+    for (size_t i = 0; i < frameCount; ++i) {
+        float sample = (input[i * 2] + input[i * 2 + 1]) * (32767.0f / 2);
+        sample = sample < 32767.0f ? sample : 32767.0f;     // NaN maps to full scale
+        sample = sample > -32768.0f ? sample : -32768.0f;
+        output[i] = static_cast<int16_t>(sample + std::copysign(0.5f, sample));
+    }
+}
+
+#ifdef SAMPLE_CONVERSION_X86
+
+// minps returns its second operand when either is NaN, so min(x, 1) maps NaN
+// to 1.0 exactly like the scalar comparison. cvttps truncates toward zero and
+// the clamped range never saturates the int16 pack.
+TARGET_SSE2 inline __m128i FloatToInt32SSE2(__m128 samples, __m128 one, __m128 minusOne, __m128 scale) {
+    samples = _mm_max_ps(_mm_min_ps(samples, one), minusOne);
+    return _mm_cvttps_epi32(_mm_mul_ps(samples, scale));
+}
+
+TARGET_SSE2 void FloatToPCM16SSE2(const float* input, int16_t* output, size_t sampleCount) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= sampleCount; i += 8) {
+        __m128i low = FloatToInt32SSE2(_mm_loadu_ps(input + i), one, minusOne, scale);
+        __m128i high = FloatToInt32SSE2(_mm_loadu_ps(input + i + 4), one, minusOne, scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(low, high));
+    }
+    FloatToPCM16Scalar(input + i, output + i, sampleCount - i);
+}
+
+// (left + right) / 2 with C++ truncation: add the sign bit before the arithmetic shift
+TARGET_SSE2 inline __m128i HalveTowardZeroSSE2(__m128i sums) {
+    return _mm_srai_epi32(_mm_add_epi32(sums, _mm_srli_epi32(sums, 31)), 1);
+}
+
+TARGET_SSE2 void StereoToMonoSSE2(const int16_t* input, int16_t* output, size_t frameCount) {
+    const __m128i ones = _mm_set1_epi16(1);
+
+    size_t i = 0;
+    for (; i + 8 <= frameCount; i += 8) {
+        // madd with ones sums each adjacent L/R pair into an int32
+        __m128i first = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2)), ones);
+        __m128i second = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2 + 8)), ones);
+        __m128i mono = _mm_packs_epi32(HalveTowardZeroSSE2(first), HalveTowardZeroSSE2(second));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), mono);
+    }
+    StereoToMonoScalar(input + i * 2, output + i, frameCount - i);
+}
+
+// Clamp and round half away from zero: add 0.5 carrying the sample's sign, then truncate
+TARGET_SSE2 inline __m128i RoundToInt32SSE2(__m128 samples, __m128 high, __m128 low, __m128 signMask, __m128 half) {
+    samples = _mm_max_ps(_mm_min_ps(samples, high), low);
+    __m128 offset = _mm_or_ps(_mm_and_ps(samples, signMask), half);
+    return _mm_cvttps_epi32(_mm_add_ps(samples, offset));
+}
+
+TARGET_SSE2 void StereoFloatToMonoSSE2(const float* input, int16_t* output, size_t frameCount) {
+    const __m128 gain = _mm_set1_ps(32767.0f / 2);
+    const __m128 high = _mm_set1_ps(32767.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    size_t i = 0;
+    for (; i + 8 <= frameCount; i += 8) {
+        __m128i mono[2];
+        for (int part = 0; part < 2; ++part) {
+            const float* frames = input + (i + part * 4) * 2;
+            __m128 first = _mm_loadu_ps(frames);
+            __m128 second = _mm_loadu_ps(frames + 4);
+            __m128 left = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+            mono[part] = RoundToInt32SSE2(_mm_mul_ps(_mm_add_ps(left, right), gain), high, low, signMask, half);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(mono[0], mono[1]));
+    }
+    StereoFloatToMonoScalar(input + i * 2, output + i, frameCount - i);
+}
+
+TARGET_AVX2 inline __m256i FloatToInt32AVX2(__m256 samples, __m256 one, __m256 minusOne, __m256 scale) {
+    samples = _mm256_max_ps(_mm256_min_ps(samples, one), minusOne);
+    return _mm256_cvttps_epi32(_mm256_mul_ps(samples, scale));
+}
+
+TARGET_AVX2 void FloatToPCM16AVX2(const float* input, int16_t* output, size_t sampleCount) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 scale = _mm256_set1_ps(32767.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= sampleCount; i += 16) {
+        __m256i low = FloatToInt32AVX2(_mm256_loadu_ps(input + i), one, minusOne, scale);
+        __m256i high = FloatToInt32AVX2(_mm256_loadu_ps(input + i + 8), one, minusOne, scale);
+        // packs works per 128-bit lane; restore sample order across lanes
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+    }
+    // The compiler omits vzeroupper before the tail call, and dirty upper YMM
+    // state makes every later legacy-SSE instruction pay a transition penalty
+    _mm256_zeroupper();
+    FloatToPCM16SSE2(input + i, output + i, sampleCount - i);
+}
+
+TARGET_AVX2 inline __m256i HalveTowardZeroAVX2(__m256i sums) {
+    return _mm256_srai_epi32(_mm256_add_epi32(sums, _mm256_srli_epi32(sums, 31)), 1);
+}
+
+TARGET_AVX2 void StereoToMonoAVX2(const int16_t* input, int16_t* output, size_t frameCount) {
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    size_t i = 0;
+    for (; i + 16 <= frameCount; i += 16) {
+        __m256i first = _mm256_madd_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i * 2)), ones);
+        __m256i second = _mm256_madd_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i * 2 + 16)), ones);
+        __m256i packed = _mm256_packs_epi32(HalveTowardZeroAVX2(first), HalveTowardZeroAVX2(second));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    _mm256_zeroupper();
+    StereoToMonoSSE2(input + i * 2, output + i, frameCount - i);
+}
+
+TARGET_AVX2 inline __m256i RoundToInt32AVX2(__m256 samples, __m256 high, __m256 low, __m256 signMask, __m256 half) {
+    samples = _mm256_max_ps(_mm256_min_ps(samples, high), low);
+    __m256 offset = _mm256_or_ps(_mm256_and_ps(samples, signMask), half);
+    return _mm256_cvttps_epi32(_mm256_add_ps(samples, offset));
+}
+
+TARGET_AVX2 void StereoFloatToMonoAVX2(const float* input, int16_t* output, size_t frameCount) {
+    const __m256 gain = _mm256_set1_ps(32767.0f / 2);
+    const __m256 high = _mm256_set1_ps(32767.0f);
+    const __m256 low = _mm256_set1_ps(-32768.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    size_t i = 0;
+    for (; i + 16 <= frameCount; i += 16) {
+        __m256i mono[2];
+        for (int part = 0; part < 2; ++part) {
+            const float* frames = input + (i + part * 8) * 2;
+            __m256 first = _mm256_loadu_ps(frames);
+            __m256 second = _mm256_loadu_ps(frames + 8);
+            // shuffle works per 128-bit lane, leaving frames in the order 0 1 4 5 2 3 6 7
+            __m256 left = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 right = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+            __m256 sums = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_add_ps(left, right)), 0xD8));
+            mono[part] = RoundToInt32AVX2(_mm256_mul_ps(sums, gain), high, low, signMask, half);
+        }
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(mono[0], mono[1]), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+    }
+    _mm256_zeroupper();
+    StereoFloatToMonoSSE2(input + i * 2, output + i, frameCount - i);
+}
+
+#endif // SAMPLE_CONVERSION_X86
+
+} // namespace
+
+InstructionSet DetectInstructionSet() {
+#ifdef SAMPLE_CONVERSION_X86
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+
+    // AVX2 also needs the OS to save YMM state on context switches
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) {
+        return InstructionSet::AVX2;
+    }
+    if (sse2) {
+        return InstructionSet::SSE2;
+    }
+#endif
+    return InstructionSet::Scalar;
+}
+
+InstructionSet GetActiveInstructionSet() {
+    static const InstructionSet active = DetectInstructionSet();
+    return active;
+}
+
+const char* InstructionSetName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+        case InstructionSet::AVX2: return "AVX2";
+        case InstructionSet::SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+void FloatToPCM16(const float* input, int16_t* output, size_t sampleCount) {
+    FloatToPCM16(GetActiveInstructionSet(), input, output, sampleCount);
+}
+
+void StereoToMono(const int16_t* input, int16_t* output, size_t frameCount) {
+    StereoToMono(GetActiveInstructionSet(), input, output, frameCount);
+}
+
+void StereoFloatToMono(const float* input, int16_t* output, size_t frameCount) {
+    StereoFloatToMono(GetActiveInstructionSet(), input, output, frameCount);
+}
+
+void FloatToPCM16(InstructionSet instructionSet, const float* input, int16_t* output, size_t sampleCount) {
+    switch (instructionSet) {
+#ifdef SAMPLE_CONVERSION_X86
+        case InstructionSet::AVX2: FloatToPCM16AVX2(input, output, sampleCount); return;
+        case InstructionSet::SSE2: FloatToPCM16SSE2(input, output, sampleCount); return;
+#endif
+        default: FloatToPCM16Scalar(input, output, sampleCount); return;
+    }
+}
+
+void StereoToMono(InstructionSet instructionSet, const int16_t* input, int16_t* output, size_t frameCount) {
+    switch (instructionSet) {
+#ifdef SAMPLE_CONVERSION_X86
+        case InstructionSet::AVX2: StereoToMonoAVX2(input, output, frameCount); return;
+        case InstructionSet::SSE2: StereoToMonoSSE2(input, output, frameCount); return;
+#endif
+        default: StereoToMonoScalar(input, output, frameCount); return;
+    }
+}
+
+void StereoFloatToMono(InstructionSet instructionSet, const float* input, int16_t* output, size_t frameCount) {
+    switch (instructionSet) {
+#ifdef SAMPLE_CONVERSION_X86
+        case InstructionSet::AVX2: StereoFloatToMonoAVX2(input, output, frameCount); return;
+        case InstructionSet::SSE2: StereoFloatToMonoSSE2(input, output, frameCount); return;
+#endif
+        default: StereoFloatToMonoScalar(input, output, frameCount); return;
+    }
+}
+
+} // namespace SampleConversion
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Sample format kernels used by AudioConverter. Each kernel has a scalar
+// reference plus SSE2/AVX2 versions on x86; the fastest one the CPU and OS
+// support is picked once at runtime. All versions produce bit-identical output.
+namespace SampleConversion {
+
+enum class InstructionSet {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Best instruction set available on this machine
+InstructionSet DetectInstructionSet();
+
+// Instruction set used by the dispatched kernels below
+InstructionSet GetActiveInstructionSet();
+
+const char* InstructionSetName(InstructionSet instructionSet);
+
+// Clamp to [-1, 1], scale by 32767 and truncate toward zero
+void FloatToPCM16(const float* input, int16_t* output, size_t sampleCount);
+
+// Average interleaved L/R pairs, rounding toward zero; output holds frameCount samples
+void StereoToMono(const int16_t* input, int16_t* output, size_t frameCount);
+
+// Average interleaved float L/R pairs and scale by 32767 in float, then clamp
+// and round half away from zero once; output holds frameCount samples
+void StereoFloatToMono(const float* input, int16_t* output, size_t frameCount);
+
+// Explicit variants for benchmarks and verification. Calling a version the
+// CPU does not support is undefined; check DetectInstructionSet() first.
+void FloatToPCM16(InstructionSet instructionSet, const float* input, int16_t* output, size_t sampleCount);
+void StereoToMono(InstructionSet instructionSet, const int16_t* input, int16_t* output, size_t frameCount);
+void StereoFloatToMono(InstructionSet instructionSet, const float* input, int16_t* output, size_t frameCount);
+
+} // namespace SampleConversion
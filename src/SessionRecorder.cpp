@@ -0,0 +1,444 @@
+#include "SessionRecorder.h"
+#include "SimpleLogger.h"
+#include "TimelineTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint64_t WAV_MAX_BYTES = 0xFFFFFFFFull;
+const size_t DATA_CHUNK_OFFSET = SessionRecorder::HEADER_BYTES - 8;
+const size_t JUNK_CHUNK_OFFSET = 36;    // After RIFF/WAVE (12) and a 16-byte fmt chunk (24)
+
+void PutTag(uint8_t* at, const char* tag) {
+    std::memcpy(at, tag, 4);
+}
+
+void PutUInt16(uint8_t* at, uint16_t value) {
+    at[0] = static_cast<uint8_t>(value);
+    at[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void PutUInt32(uint8_t* at, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        at[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+size_t GreatestCommonDivisor(size_t a, size_t b) {
+    while (b != 0) {
+        size_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// "session-20240131-142501", local time
+std::string MakeSessionName() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char name[64];
+    if (std::strftime(name, sizeof(name), "session-%Y%m%d-%H%M%S", &local) == 0) {
+        return "session";
+    }
+    return name;
+}
+
+} // namespace
+
+// Unbuffered file written only at aligned offsets with aligned buffers
+class SessionRecorder::SegmentFile {
+public:
+    ~SegmentFile() { Close(); }
+
+    bool Open(const std::filesystem::path& path) {
+#ifdef _WIN32
+        handle = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, nullptr);
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        return descriptor >= 0;
+#endif
+    }
+
+    bool WriteAt(uint64_t offset, const uint8_t* data, size_t size) {
+#ifdef _WIN32
+        while (size > 0) {
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD written = 0;
+            if (!WriteFile(handle, data, static_cast<DWORD>(size), &written, &overlapped) || written == 0) {
+                return false;
+            }
+            data += written;
+            offset += written;
+            size -= written;
+        }
+        return true;
+#else
+        while (size > 0) {
+            ssize_t written = pwrite(descriptor, data, size, static_cast<off_t>(offset));
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            offset += static_cast<uint64_t>(written);
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+#endif
+    }
+
+    // Cut off the zero padding of the last block
+    bool Truncate(uint64_t size) {
+#ifdef _WIN32
+        FILE_END_OF_FILE_INFO endOfFile{};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        return SetFileInformationByHandle(handle, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)) != FALSE;
+#else
+        return ftruncate(descriptor, static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(handle);
+            handle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (descriptor >= 0) {
+            close(descriptor);
+            descriptor = -1;
+        }
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int descriptor = -1;
+#endif
+};
+
+void SessionRecorder::AlignedDelete::operator()(uint8_t* block) const {
+    ::operator delete(block, std::align_val_t(HEADER_BYTES));
+}
+
+uint8_t* SessionRecorder::AllocateAligned(size_t bytes) {
+    return static_cast<uint8_t*>(::operator new(bytes, std::align_val_t(HEADER_BYTES)));
+}
+
+SessionRecorder::SessionRecorder()
+    : sampleRate(0), channels(0), bitsPerSample(0), blockBytes(0), maxSegmentDataBytes(0), recording(false),
+      current(-1), stopRequested(false), segmentDataBytes(0), stats{} {
+}
+
+SessionRecorder::~SessionRecorder() {
+    Stop();
+}
+
+bool SessionRecorder::Start(const Settings& newSettings, uint32_t newSampleRate, uint16_t newChannels,
+                            uint16_t newBitsPerSample) {
+    if (recording.load()) {
+        WARN_LOG("SessionRecorder: already recording");
+        return false;
+    }
+
+    size_t frameBytes = static_cast<size_t>(newChannels) * (newBitsPerSample / 8);
+    if (newSampleRate == 0 || frameBytes == 0) {
+        ERROR_LOG("SessionRecorder: invalid audio format");
+        return false;
+    }
+
+    settings = newSettings;
+    sampleRate = newSampleRate;
+    channels = newChannels;
+    bitsPerSample = newBitsPerSample;
+
+    // Blocks hold whole frames and keep every write aligned
+    size_t unit = HEADER_BYTES / GreatestCommonDivisor(HEADER_BYTES, frameBytes) * frameBytes;
+    blockBytes = std::max(unit, settings.blockBytes / unit * unit);
+
+    // Segments hold whole blocks; only the last block of a segment is partial
+    uint64_t maxSegmentBytes = std::min(settings.maxSegmentBytes, WAV_MAX_BYTES);
+    uint64_t maxData = maxSegmentBytes > HEADER_BYTES ? maxSegmentBytes - HEADER_BYTES : 0;
+    maxSegmentDataBytes = std::max<uint64_t>(blockBytes, maxData / blockBytes * blockBytes);
+
+    std::error_code error;
+    std::filesystem::create_directories(settings.directory, error);
+    if (error) {
+        ERROR_LOG("SessionRecorder: cannot create " + settings.directory + ": " + error.message());
+        return false;
+    }
+
+    blocks.clear();
+    freeBlocks.clear();
+    fullBlocks.clear();
+    size_t blockCount = std::max<size_t>(2, settings.blockCount);
+    for (size_t i = 0; i < blockCount; ++i) {
+        blocks.push_back(Block{std::unique_ptr<uint8_t, AlignedDelete>(AllocateAligned(blockBytes)), 0});
+        freeBlocks.push_back(static_cast<int>(i));
+    }
+    current = -1;
+    stopRequested = false;
+    headerBlock.reset(AllocateAligned(HEADER_BYTES));
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats = Stats{};
+    }
+    sessionBaseName = MakeSessionName();
+    if (!OpenSegment()) {
+        return false;
+    }
+
+    recording = true;
+    writer = std::thread(&SessionRecorder::WriterThreadProc, this);
+
+    INFO_LOG("SessionRecorder: recording to " + GetStats().currentFile + " (" + std::to_string(blockCount) + " x " +
+             std::to_string(blockBytes / 1024) + " KB blocks)");
+    return true;
+}
+
+void SessionRecorder::Write(const uint8_t* data, size_t size) {
+    if (!recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    while (size > 0) {
+        if (current < 0) {
+            std::lock_guard<std::mutex> lock(blockMutex);
+            if (freeBlocks.empty()) {
+                // The disk is behind by the whole pool; lose this packet rather than block capture
+                std::lock_guard<std::mutex> statsLock(statsMutex);
+                stats.bytesDropped += size;
+                LOG_RATE_LIMITED(Warn, 3, 10000, "SessionRecorder: disk is falling behind, dropping audio");
+                return;
+            }
+            current = freeBlocks.front();
+            freeBlocks.pop_front();
+            blocks[current].used = 0;
+        }
+
+        Block& block = blocks[current];
+        size_t count = std::min(size, blockBytes - block.used);
+        std::memcpy(block.data.get() + block.used, data, count);
+        block.used += count;
+        data += count;
+        size -= count;
+
+        if (block.used == blockBytes) {
+            {
+                std::lock_guard<std::mutex> lock(blockMutex);
+                fullBlocks.push_back(current);
+            }
+            blockCondition.notify_one();
+            current = -1;
+        }
+    }
+}
+
+void SessionRecorder::Stop() {
+    if (!recording.exchange(false)) {
+        return;
+    }
+
+    // The capture side has stopped, so its partial block can be handed over
+    {
+        std::lock_guard<std::mutex> lock(blockMutex);
+        if (current >= 0) {
+            if (blocks[current].used > 0) {
+                fullBlocks.push_back(current);
+            } else {
+                freeBlocks.push_back(current);
+            }
+            current = -1;
+        }
+        stopRequested = true;
+    }
+    blockCondition.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    FinishSegment();
+
+    Stats finalStats = GetStats();
+    INFO_LOG("SessionRecorder: stopped, " + std::to_string(finalStats.bytesRecorded / 1024) + " KB in " +
+             std::to_string(finalStats.segments) + " segment(s), " + std::to_string(finalStats.bytesDropped) +
+             " bytes dropped, " + std::to_string(finalStats.writeErrors) + " write errors");
+}
+
+SessionRecorder::Stats SessionRecorder::GetStats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void SessionRecorder::WriterThreadProc() {
+    TimelineTrace::SetThreadName("Session recorder");
+    auto headerInterval = std::chrono::milliseconds(std::max<uint32_t>(100, settings.headerUpdateMs));
+    auto nextHeaderUpdate = std::chrono::steady_clock::now() + headerInterval;
+
+    while (true) {
+        int index = -1;
+        {
+            std::unique_lock<std::mutex> lock(blockMutex);
+            blockCondition.wait_until(lock, nextHeaderUpdate, [this] { return !fullBlocks.empty() || stopRequested; });
+            if (!fullBlocks.empty()) {
+                index = fullBlocks.front();
+                fullBlocks.pop_front();
+            } else if (stopRequested) {
+                break;
+            }
+        }
+
+        if (index >= 0) {
+            WriteBlock(blocks[index]);
+            {
+                std::lock_guard<std::mutex> lock(blockMutex);
+                freeBlocks.push_back(index);
+            }
+        }
+
+        if (std::chrono::steady_clock::now() >= nextHeaderUpdate) {
+            UpdateHeader();
+            nextHeaderUpdate = std::chrono::steady_clock::now() + headerInterval;
+        }
+    }
+}
+
+bool SessionRecorder::WriteBlock(const Block& block) {
+    TRACE_SCOPE("WriteBlock");
+    if (segment && segmentDataBytes + block.used > maxSegmentDataBytes) {
+        FinishSegment();
+        if (!OpenSegment()) {
+            return false;
+        }
+    }
+    if (!segment) {
+        // The segment could not be created; the rest of the session is lost
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.bytesDropped += block.used;
+        return false;
+    }
+
+    // A short final block is padded to the alignment and truncated when the segment is finished
+    size_t writeBytes = (block.used + HEADER_BYTES - 1) / HEADER_BYTES * HEADER_BYTES;
+    if (writeBytes > block.used) {
+        std::memset(block.data.get() + block.used, 0, writeBytes - block.used);
+    }
+
+    if (!segment->WriteAt(HEADER_BYTES + segmentDataBytes, block.data.get(), writeBytes)) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.writeErrors++;
+        stats.bytesDropped += block.used;
+        LOG_RATE_LIMITED(Error, 3, 10000, "SessionRecorder: write failed for " + stats.currentFile);
+        return false;
+    }
+
+    segmentDataBytes += block.used;
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.bytesRecorded += block.used;
+    return true;
+}
+
+bool SessionRecorder::OpenSegment() {
+    uint32_t number;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        number = ++stats.segments;
+    }
+
+    // The first file keeps the plain session name; later ones get -002, -003, ...
+    std::string fileName = sessionBaseName;
+    if (number > 1) {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "-%03u", number);
+        fileName += suffix;
+    }
+    std::filesystem::path path = std::filesystem::path(settings.directory) / (fileName + ".wav");
+
+    segment = std::make_unique<SegmentFile>();
+    segmentDataBytes = 0;
+    if (!segment->Open(path) || !UpdateHeader()) {
+        ERROR_LOG("SessionRecorder: cannot create " + path.string());
+        segment.reset();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.writeErrors++;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.currentFile = path.string();
+    if (number > 1) {
+        INFO_LOG("SessionRecorder: continuing in " + stats.currentFile);
+    }
+    return true;
+}
+
+void SessionRecorder::FinishSegment() {
+    if (!segment) {
+        return;
+    }
+    UpdateHeader();
+    if (!segment->Truncate(HEADER_BYTES + segmentDataBytes)) {
+        WARN_LOG("SessionRecorder: could not trim the padding from the last block");
+    }
+    segment.reset();
+}
+
+bool SessionRecorder::UpdateHeader() {
+    if (!segment) {
+        return false;
+    }
+    BuildHeader(headerBlock.get(), segmentDataBytes);
+    return segment->WriteAt(0, headerBlock.get(), HEADER_BYTES);
+}
+
+void SessionRecorder::BuildHeader(uint8_t* header, uint64_t dataBytes) const {
+    uint16_t blockAlign = static_cast<uint16_t>(channels * (bitsPerSample / 8));
+
+    std::memset(header, 0, HEADER_BYTES);
+    PutTag(header, "RIFF");
+    PutUInt32(header + 4, static_cast<uint32_t>(DATA_CHUNK_OFFSET + dataBytes));
+    PutTag(header + 8, "WAVE");
+
+    PutTag(header + 12, "fmt ");
+    PutUInt32(header + 16, 16);
+    PutUInt16(header + 20, bitsPerSample == 32 ? 3 : 1);    // IEEE float or PCM
+    PutUInt16(header + 22, channels);
+    PutUInt32(header + 24, sampleRate);
+    PutUInt32(header + 28, sampleRate * blockAlign);
+    PutUInt16(header + 32, blockAlign);
+    PutUInt16(header + 34, bitsPerSample);
+
+    // JUNK fills the rest of the block so the samples start aligned
+    PutTag(header + JUNK_CHUNK_OFFSET, "JUNK");
+    PutUInt32(header + JUNK_CHUNK_OFFSET + 4, static_cast<uint32_t>(DATA_CHUNK_OFFSET - JUNK_CHUNK_OFFSET - 8));
+
+    PutTag(header + DATA_CHUNK_OFFSET, "data");
+    PutUInt32(header + DATA_CHUNK_OFFSET + 4, static_cast<uint32_t>(dataBytes));
+}
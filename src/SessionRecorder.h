@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams a whole recording session to WAV files on disk. The capture side
+// copies packets into a few large aligned blocks; a background thread writes
+// full blocks at aligned offsets. The file header takes one 4 KB block
+// (padded with a JUNK chunk), so every write is aligned. The header is
+// rewritten with the current sizes every few seconds, so a crash leaves a
+// playable file. Files roll over to a new segment before they reach the WAV
+// 4 GB limit or the configured size. Memory use is fixed by the block pool.
+class SessionRecorder {
+public:
+    struct Settings {
+        std::string directory;
+        uint64_t maxSegmentBytes = 0xFFFFFFFFull;  // Clamped to the WAV 4 GB limit
+        size_t blockBytes = 1 << 20;               // Rounded to a multiple of the alignment and frame size
+        size_t blockCount = 4;                     // Pool size: how far the disk may fall behind
+        uint32_t headerUpdateMs = 5000;
+    };
+
+    struct Stats {
+        uint64_t bytesRecorded;        // Audio bytes written to disk
+        uint64_t bytesDropped;         // Audio lost because every block was waiting for the disk
+        uint32_t segments;
+        uint32_t writeErrors;
+        std::string currentFile;
+    };
+
+    static constexpr size_t HEADER_BYTES = 4096;   // Also the write alignment
+
+    SessionRecorder();
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    // Open the first segment and start the writer. 32-bit samples are float.
+    bool Start(const Settings& settings, uint32_t sampleRate, uint16_t channels, uint16_t bitsPerSample);
+
+    // Capture thread. Copies into the current block and never waits on the disk.
+    void Write(const uint8_t* data, size_t size);
+
+    // Write out what is buffered, finalize the file and stop the writer.
+    // Call after the capture side has stopped writing.
+    void Stop();
+
+    bool IsRecording() const { return recording.load(); }
+    Stats GetStats() const;
+
+private:
+    struct AlignedDelete {
+        void operator()(uint8_t* block) const;
+    };
+
+    struct Block {
+        std::unique_ptr<uint8_t, AlignedDelete> data;
+        size_t used;
+    };
+
+    class SegmentFile;
+
+    Settings settings;
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint16_t bitsPerSample;
+    size_t blockBytes;
+    uint64_t maxSegmentDataBytes;
+
+    std::atomic<bool> recording;
+    std::thread writer;
+
+    // Block pool: the capture side fills `current`, the writer drains `fullBlocks`
+    std::vector<Block> blocks;
+    int current;
+    mutable std::mutex blockMutex;
+    std::condition_variable blockCondition;
+    std::deque<int> freeBlocks;
+    std::deque<int> fullBlocks;
+    bool stopRequested;
+
+    // Writer thread only
+    std::unique_ptr<SegmentFile> segment;
+    std::string sessionBaseName;
+    uint64_t segmentDataBytes;
+    std::unique_ptr<uint8_t, AlignedDelete> headerBlock;
+
+    mutable std::mutex statsMutex;
+    Stats stats;
+
+    void WriterThreadProc();
+    bool WriteBlock(const Block& block);
+    bool OpenSegment();
+    void FinishSegment();
+    bool UpdateHeader();
+    void BuildHeader(uint8_t* header, uint64_t dataBytes) const;
+    static uint8_t* AllocateAligned(size_t bytes);
+};
@@ -1,5 +1,468 @@
 #include "SimpleLogger.h"
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
 
-// Static member initialization
-std::ofstream SimpleLogger::logFile;
-bool SimpleLogger::initialized = false;
\ No newline at end of file
+namespace {
+
+// Keep a batch from growing without bound while the queue is drained
+const size_t MAX_BATCH_BYTES = 64 * 1024;
+
+struct Record {
+    std::chrono::system_clock::time_point time;
+    SimpleLogger::Level level;
+    std::string message;
+};
+
+// Bounded multi-producer, single-consumer ring. Each slot's sequence number
+// says whose turn it is: equal to the position while free for the producer
+// claiming that position, position + 1 once filled for the consumer.
+class RecordQueue {
+public:
+    explicit RecordQueue(size_t requestedCapacity)
+        : enqueuePosition(0)
+        , dequeuePosition(0)
+    {
+        capacity = 4;
+        while (capacity < requestedCapacity) {
+            capacity <<= 1;
+        }
+        slots.reset(new Slot[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns the position taken, or false when the queue is full
+    bool TryPush(Record&& record, size_t& position) {
+        size_t pos = enqueuePosition.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[pos & (capacity - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                pos = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = std::move(record);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        position = pos;
+        return true;
+    }
+
+    // Consumer thread only
+    bool TryPop(Record& record) {
+        Slot& slot = slots[dequeuePosition & (capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+            return false;
+        }
+        record = std::move(slot.record);
+        slot.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+        dequeuePosition++;
+        return true;
+    }
+
+    size_t Capacity() const { return capacity; }
+    size_t PushedCount() const { return enqueuePosition.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t capacity;
+
+    // Producers and the consumer work on separate cache lines
+    alignas(64) std::atomic<size_t> enqueuePosition;
+    alignas(64) size_t dequeuePosition;
+};
+
+// Formats "YYYY-MM-DD HH:MM:SS.mmm [LEVEL] message\n"; the date part is
+// reformatted only when the second changes
+class RecordFormatter {
+public:
+    RecordFormatter() : cachedSecond(-1) { cachedTimestamp[0] = '\0'; }
+
+    void Append(std::string& out, const Record& record) {
+        std::time_t seconds = std::chrono::system_clock::to_time_t(record.time);
+        if (seconds != cachedSecond) {
+            std::tm* timeinfo = std::localtime(&seconds);
+            if (timeinfo == nullptr || std::strftime(cachedTimestamp, sizeof(cachedTimestamp), "%Y-%m-%d %H:%M:%S", timeinfo) == 0) {
+                cachedTimestamp[0] = '\0';
+            }
+            cachedSecond = seconds;
+        }
+        auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+
+        char fraction[8];
+        std::snprintf(fraction, sizeof(fraction), ".%03d", static_cast<int>(milliseconds));
+        out += cachedTimestamp;
+        out += fraction;
+        out += " [";
+        out += SimpleLogger::LevelName(record.level);
+        out += "] ";
+        out += record.message;
+        out += '\n';
+    }
+
+private:
+    std::time_t cachedSecond;
+    char cachedTimestamp[32];
+};
+
+struct LoggerState {
+    std::mutex lifecycleMutex;             // Serializes Initialize and Close
+    std::atomic<bool> running{false};
+    bool closeRegistered = false;
+    SimpleLogger::Settings settings;
+    std::unique_ptr<RecordQueue> queue;
+    std::thread writer;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable writtenCondition;
+    std::atomic<bool> wakePending{false};  // Lets producers skip the mutex when a wake is already on its way
+    bool wakeRequested = false;
+    bool stopRequested = false;
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> rotations{0};
+
+    // Writer thread only
+    std::ofstream file;
+    uint64_t fileBytes = 0;
+    std::string batch;
+    RecordFormatter formatter;
+};
+
+// Never destroyed, so logging from other static destructors stays safe
+LoggerState& State() {
+    static LoggerState* state = new LoggerState();
+    return *state;
+}
+
+void RequestWake(LoggerState& state) {
+    if (state.wakePending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(state.wakeMutex);
+        state.wakeRequested = true;
+    }
+    state.wakeCondition.notify_one();
+}
+
+void OpenLogFile(LoggerState& state) {
+    {
+        std::ifstream existing(state.settings.filePath, std::ios::binary | std::ios::ate);
+        std::streamoff size = existing ? static_cast<std::streamoff>(existing.tellg()) : 0;
+        state.fileBytes = size > 0 ? static_cast<uint64_t>(size) : 0;
+    }
+    state.file.open(state.settings.filePath, std::ios::binary | std::ios::app);
+}
+
+// debug.log -> debug.log.1 -> ... -> debug.log.N, the oldest is deleted
+void RotateLogFile(LoggerState& state) {
+    const std::string& path = state.settings.filePath;
+    state.file.close();
+
+    uint32_t backups = state.settings.maxBackupFiles;
+    if (backups > 0) {
+        std::remove((path + "." + std::to_string(backups)).c_str());
+        for (uint32_t i = backups - 1; i >= 1; --i) {
+            std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(path.c_str(), (path + ".1").c_str());
+    }
+
+    state.file.open(path, std::ios::binary | std::ios::trunc);
+    state.fileBytes = 0;
+    state.rotations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WriteBatch(LoggerState& state) {
+    if (state.batch.empty()) {
+        return;
+    }
+    if (state.settings.console) {
+        std::cout.write(state.batch.data(), static_cast<std::streamsize>(state.batch.size()));
+    }
+    if (state.file.is_open()) {
+        state.file.write(state.batch.data(), static_cast<std::streamsize>(state.batch.size()));
+        state.fileBytes += state.batch.size();
+        if (state.fileBytes >= state.settings.maxFileBytes) {
+            RotateLogFile(state);
+        }
+    }
+    state.batch.clear();
+}
+
+// Drain the queue into batched writes, then flush once
+void DrainQueue(LoggerState& state) {
+    Record record;
+    uint64_t count = 0;
+    while (state.queue->TryPop(record)) {
+        state.formatter.Append(state.batch, record);
+        count++;
+        if (state.batch.size() >= MAX_BATCH_BYTES) {
+            WriteBatch(state);
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+    WriteBatch(state);
+    if (state.settings.console) {
+        std::cout.flush();
+    }
+    if (state.file.is_open()) {
+        state.file.flush();
+    }
+
+    state.batches.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(state.wakeMutex);
+        state.written.fetch_add(count, std::memory_order_release);
+    }
+    state.writtenCondition.notify_all();
+}
+
+void WriterThreadProc(LoggerState& state) {
+    const auto interval = std::chrono::milliseconds(state.settings.flushIntervalMs);
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(state.wakeMutex);
+            state.wakeCondition.wait_for(lock, interval, [&state] { return state.wakeRequested || state.stopRequested; });
+            state.wakeRequested = false;
+            state.wakePending.store(false, std::memory_order_release);
+            stopping = state.stopRequested;
+        }
+        DrainQueue(state);
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+// Used while the writer is not running
+void WriteDirect(const Record& record) {
+    static std::mutex directMutex;
+    std::lock_guard<std::mutex> lock(directMutex);
+    static RecordFormatter formatter;
+    std::string line;
+    formatter.Append(line, record);
+    std::cout << line << std::flush;
+}
+
+void CloseAtExit() {
+    SimpleLogger::Close();
+}
+
+} // namespace
+
+std::atomic<int> SimpleLogger::minimumLevel{static_cast<int>(SimpleLogger::Level::Debug)};
+
+void SimpleLogger::Initialize() {
+    Initialize(Settings());
+}
+
+void SimpleLogger::Initialize(const Settings& settings) {
+    LoggerState& state = State();
+    {
+        std::lock_guard<std::mutex> lock(state.lifecycleMutex);
+        if (state.running.load()) {
+            return;
+        }
+
+        state.settings = settings;
+        if (!state.queue) {
+            state.queue = std::make_unique<RecordQueue>(settings.queueCapacity);
+        }
+        OpenLogFile(state);
+        state.stopRequested = false;
+        state.wakeRequested = false;
+        state.writer = std::thread(WriterThreadProc, std::ref(state));
+        state.running.store(true, std::memory_order_release);
+
+        // Queued records are written out even if nobody calls Close
+        if (!state.closeRegistered) {
+            std::atexit(CloseAtExit);
+            state.closeRegistered = true;
+        }
+    }
+    LogMessage(Level::Info, "=== LOGGER INITIALIZED ===");
+}
+
+void SimpleLogger::LogMessage(Level level, std::string message) {
+    if (!IsEnabled(level)) {
+        return;
+    }
+    LoggerState& state = State();
+    Record record{std::chrono::system_clock::now(), level, std::move(message)};
+
+    if (!state.running.load(std::memory_order_acquire)) {
+        WriteDirect(record);
+        return;
+    }
+
+    size_t position;
+    if (!state.queue->TryPush(std::move(record), position)) {
+        state.dropped.fetch_add(1, std::memory_order_relaxed);
+        RequestWake(state);
+        return;
+    }
+
+    // Errors go out at once; bursts wake the writer every quarter queue
+    if (level == Level::Error || (position & (state.queue->Capacity() / 4 - 1)) == 0) {
+        RequestWake(state);
+    }
+}
+
+void SimpleLogger::Flush() {
+    LoggerState& state = State();
+    if (!state.running.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    uint64_t target = state.queue->PushedCount();
+    std::unique_lock<std::mutex> lock(state.wakeMutex);
+    while (state.written.load(std::memory_order_acquire) < target && state.running.load()) {
+        state.wakeRequested = true;
+        state.wakeCondition.notify_one();
+        state.writtenCondition.wait_for(lock, std::chrono::milliseconds(state.settings.flushIntervalMs));
+    }
+}
+
+void SimpleLogger::Close() {
+    LoggerState& state = State();
+    if (!state.running.load()) {
+        return;
+    }
+    LogMessage(Level::Info, "=== LOGGER SHUTTING DOWN ===");
+
+    std::lock_guard<std::mutex> lock(state.lifecycleMutex);
+    if (!state.running.load()) {
+        return;
+    }
+    state.running.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> wakeLock(state.wakeMutex);
+        state.stopRequested = true;
+    }
+    state.wakeCondition.notify_one();
+    if (state.writer.joinable()) {
+        state.writer.join();
+    }
+
+    // Pick up anything pushed while the writer was stopping
+    DrainQueue(state);
+    state.file.close();
+}
+
+SimpleLogger::Stats SimpleLogger::GetStats() {
+    LoggerState& state = State();
+    Stats stats = {};
+    stats.logged = state.queue ? state.queue->PushedCount() : 0;
+    stats.dropped = state.dropped.load();
+    stats.written = state.written.load();
+    stats.batches = state.batches.load();
+    stats.rotations = state.rotations.load();
+    return stats;
+}
+
+const char* SimpleLogger::LevelName(Level level) {
+    switch (level) {
+        case Level::Debug: return "DEBUG";
+        case Level::Audio: return "AUDIO";
+        case Level::Info: return "INFO";
+        case Level::Config: return "CONFIG";
+        case Level::Warn: return "WARN";
+        default: return "ERROR";
+    }
+}
+
+void SimpleLogger::SetLevel(Level level) {
+    minimumLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+SimpleLogger::Level SimpleLogger::GetLevel() {
+    return static_cast<Level>(minimumLevel.load(std::memory_order_relaxed));
+}
+
+SimpleLogger::Level SimpleLogger::ParseLevel(const std::string& name, Level fallback) {
+    std::string upper;
+    for (char c : name) {
+        upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    for (Level level : {Level::Debug, Level::Audio, Level::Info, Level::Config, Level::Warn, Level::Error}) {
+        if (upper == LevelName(level)) {
+            return level;
+        }
+    }
+    return fallback;
+}
+
+std::string SimpleLogger::WithSuppressed(std::string message, uint64_t suppressed) {
+    if (suppressed > 0) {
+        message += " (" + std::to_string(suppressed) + " similar messages suppressed)";
+    }
+    return message;
+}
+
+LogRateLimiter::LogRateLimiter(uint32_t burst, uint32_t intervalMs)
+    : burst(burst)
+    , intervalNs(static_cast<int64_t>(intervalMs) * 1000000)
+    , calls(0)
+    , nextAllowedNs(0)
+    , suppressedCount(0)
+{
+}
+
+bool LogRateLimiter::Allow(uint64_t& suppressed) {
+    suppressed = 0;
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    if (calls.load(std::memory_order_relaxed) < burst) {
+        uint64_t call = calls.fetch_add(1, std::memory_order_relaxed);
+        if (call < burst) {
+            // The last burst call starts the first interval
+            if (call + 1 == burst) {
+                nextAllowedNs.store(now + intervalNs, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+
+    // One caller per interval wins the slot
+    int64_t next = nextAllowedNs.load(std::memory_order_relaxed);
+    if (now >= next && nextAllowedNs.compare_exchange_strong(next, now + intervalNs, std::memory_order_relaxed)) {
+        suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    suppressedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
@@ -1,59 +1,182 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <ctime>
-#include <windows.h>
 
-// Simple logging macros for debugging
+// Sites below this level are removed at compile time: 0 DEBUG, 1 AUDIO,
+// 2 INFO, 3 CONFIG, 4 WARN, 5 ERROR. Release builds keep INFO and above.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 2
+#else
+#define LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// Asynchronous logger. Callers only stamp the time and push the message into a
+// lock-free queue; a background thread formats the records, writes them in
+// batches to the console and the log file, and rotates the file by size.
+// Before Initialize (and after Close) messages go straight to the console.
 class SimpleLogger {
-private:
-    static std::ofstream logFile;
-    static bool initialized;
-    
 public:
-    static void Initialize() {
-        if (!initialized) {
-            logFile.open("debug.log", std::ios::app);
-            initialized = true;
-            LogMessage("INFO", "=== LOGGER INITIALIZED ===");
-        }
-    }
-    
-    static void LogMessage(const std::string& level, const std::string& message) {
-        time_t now = time(0);
-        tm* timeinfo = localtime(&now);
-        char timestamp[100];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-        
-        std::string logEntry = std::string(timestamp) + " [" + level + "] " + message;
-        
-        // Output to console
-        std::cout << logEntry << std::endl;
-        
-        // Output to file
-        if (logFile.is_open()) {
-            logFile << logEntry << std::endl;
-            logFile.flush();
-        }
+    enum class Level {
+        Debug,
+        Audio,
+        Info,
+        Config,
+        Warn,
+        Error
+    };
+
+    struct Settings {
+        std::string filePath = "debug.log";
+        uint64_t maxFileBytes = 10 * 1024 * 1024;  // Rotate once the file grows past this
+        uint32_t maxBackupFiles = 3;               // debug.log.1 (newest) ... debug.log.N
+        uint32_t flushIntervalMs = 200;            // Batches are written and flushed at least this often
+        size_t queueCapacity = 8192;               // Records; rounded up to a power of two
+        bool console = true;
+    };
+
+    struct Stats {
+        uint64_t logged;       // Records accepted by the queue
+        uint64_t dropped;      // Records lost because the queue was full
+        uint64_t written;
+        uint64_t batches;
+        uint64_t rotations;
+    };
+
+    // Start the writer thread. The queue is sized by the first call and kept
+    // for the life of the process; calling again while running does nothing.
+    static void Initialize();
+    static void Initialize(const Settings& settings);
+
+    // Never blocks on I/O. ERROR records wake the writer immediately.
+    static void LogMessage(Level level, std::string message);
+
+    // Wait until everything logged so far is written and flushed
+    static void Flush();
+
+    // Write what is queued and stop the writer thread
+    static void Close();
+
+    static Stats GetStats();
+    static const char* LevelName(Level level);
+
+    // Runtime threshold, checked by the macros before the message is built
+    static void SetLevel(Level level);
+    static Level GetLevel();
+    static bool IsEnabled(Level level) {
+        return static_cast<int>(level) >= minimumLevel.load(std::memory_order_relaxed);
     }
-    
-    static void Close() {
-        if (logFile.is_open()) {
-            LogMessage("INFO", "=== LOGGER SHUTTING DOWN ===");
-            logFile.close();
-        }
+
+    // "debug", "info", ... (case-insensitive); unknown names give fallback
+    static Level ParseLevel(const std::string& name, Level fallback);
+
+    // Appends "(N similar messages suppressed)" when N > 0
+    static std::string WithSuppressed(std::string message, uint64_t suppressed);
+
+private:
+    static std::atomic<int> minimumLevel;
+};
+
+// Per-call-site limiter: the first `burst` calls pass, then at most one per
+// interval. Counts what it holds back so the next message can say so.
+class LogRateLimiter {
+public:
+    LogRateLimiter(uint32_t burst, uint32_t intervalMs);
+
+    // True if this call may log; suppressed receives the calls skipped since the last one
+    bool Allow(uint64_t& suppressed);
+
+private:
+    const uint64_t burst;
+    const int64_t intervalNs;
+    std::atomic<uint64_t> calls;
+    std::atomic<int64_t> nextAllowedNs;
+    std::atomic<uint64_t> suppressedCount;
+};
+
+// Per-call-site sampler: every nth call passes. The interval is visible at
+// the call site, so nothing is reported as suppressed.
+class LogSampler {
+public:
+    explicit LogSampler(uint64_t every) : every(every > 0 ? every : 1), calls(0) {}
+
+    bool Allow(uint64_t& suppressed) {
+        suppressed = 0;
+        return (calls.fetch_add(1, std::memory_order_relaxed) + 1) % every == 0;
     }
+
+private:
+    const uint64_t every;
+    std::atomic<uint64_t> calls;
 };
 
-// Static member initialization - moved to cpp file to avoid multiple definitions
+#define SIMPLE_LOG(level, msg) \
+    do { \
+        if (SimpleLogger::IsEnabled(level)) { \
+            SimpleLogger::LogMessage(level, msg); \
+        } \
+    } while (0)
+
+// Shared by the limited macros; each expansion gets its own static limiter
+#define SIMPLE_LOG_LIMITED(level, Limiter, limiterArgs, msg) \
+    do { \
+        if (static_cast<int>(SimpleLogger::Level::level) >= LOG_MIN_LEVEL && \
+            SimpleLogger::IsEnabled(SimpleLogger::Level::level)) { \
+            static Limiter siteLimiter limiterArgs; \
+            uint64_t siteSuppressed = 0; \
+            if (siteLimiter.Allow(siteSuppressed)) { \
+                SimpleLogger::LogMessage(SimpleLogger::Level::level, SimpleLogger::WithSuppressed(msg, siteSuppressed)); \
+            } \
+        } \
+    } while (0)
+
+// Compiled-out sites still name the message, so variables used only in log
+// messages do not trigger -Wunused-variable; it is never evaluated
+#define SIMPLE_LOG_DISABLED(msg) \
+    do { \
+        if (false) { \
+            (void)(msg); \
+        } \
+    } while (0)
+
+// Convenience macros. The message expression is only evaluated when the level is enabled.
+#if LOG_MIN_LEVEL <= 0
+#define DEBUG_LOG(msg) SIMPLE_LOG(SimpleLogger::Level::Debug, msg)
+#else
+#define DEBUG_LOG(msg) SIMPLE_LOG_DISABLED(msg)
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+#define AUDIO_LOG(stage, size, format) SIMPLE_LOG(SimpleLogger::Level::Audio, std::string("[") + stage + "] Size: " + std::to_string(size) + " bytes, " + format)
+#else
+#define AUDIO_LOG(stage, size, format) SIMPLE_LOG_DISABLED(std::string("[") + stage + "] Size: " + std::to_string(size) + " bytes, " + format)
+#endif
+
+#if LOG_MIN_LEVEL <= 2
+#define INFO_LOG(msg) SIMPLE_LOG(SimpleLogger::Level::Info, msg)
+#else
+#define INFO_LOG(msg) SIMPLE_LOG_DISABLED(msg)
+#endif
+
+#if LOG_MIN_LEVEL <= 3
+#define CONFIG_LOG(key, value) SIMPLE_LOG(SimpleLogger::Level::Config, std::string("[") + key + "] = " + value)
+#else
+#define CONFIG_LOG(key, value) SIMPLE_LOG_DISABLED(std::string("[") + key + "] = " + value)
+#endif
+
+#if LOG_MIN_LEVEL <= 4
+#define WARN_LOG(msg) SIMPLE_LOG(SimpleLogger::Level::Warn, msg)
+#else
+#define WARN_LOG(msg) SIMPLE_LOG_DISABLED(msg)
+#endif
+
+#define ERROR_LOG(msg) SIMPLE_LOG(SimpleLogger::Level::Error, msg)
 
-// Convenience macros
-#define DEBUG_LOG(msg) SimpleLogger::LogMessage("DEBUG", msg)
-#define INFO_LOG(msg) SimpleLogger::LogMessage("INFO", msg)
-#define WARN_LOG(msg) SimpleLogger::LogMessage("WARN", msg)
-#define ERROR_LOG(msg) SimpleLogger::LogMessage("ERROR", msg)
-#define AUDIO_LOG(stage, size, format) SimpleLogger::LogMessage("AUDIO", std::string("[") + stage + "] Size: " + std::to_string(size) + " bytes, " + format)
-#define CONFIG_LOG(key, value) SimpleLogger::LogMessage("CONFIG", std::string("[") + key + "] = " + value)
\ No newline at end of file
+// Rate-limited sites, e.g. LOG_RATE_LIMITED(Warn, 5, 10000, "...") logs the
+// first 5 calls and then one every 10 s. LOG_EVERY_N(Debug, 50, "...") logs every 50th call.
+#define LOG_RATE_LIMITED(level, burst, intervalMs, msg) SIMPLE_LOG_LIMITED(level, LogRateLimiter, (burst, intervalMs), msg)
+#define LOG_EVERY_N(level, n, msg) SIMPLE_LOG_LIMITED(level, LogSampler, (n), msg)
@@ -0,0 +1,645 @@
+#include "SocketHttpClient.h"
+#include "CancellationToken.h"
+#include "SimpleLogger.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+#endif
+#endif
+
+namespace {
+
+#ifdef _WIN32
+const int SEND_FLAGS = 0;
+#elif defined(MSG_NOSIGNAL)
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+const size_t READ_CHUNK_SIZE = 16 * 1024;
+const size_t MAX_GATHER_SPANS = 16;     // Buffers handed to one send call
+const int CANCEL_POLL_MS = 100;     // How often a wait looks at the cancellation token
+const int ACK_POLL_MS = 10;         // How often the unacknowledged byte count is checked
+
+bool WouldBlock() {
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINTR;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+bool ConnectInProgress() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+void SetNonBlocking(intptr_t socket) {
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(static_cast<SOCKET>(socket), FIONBIO, &nonBlocking);
+#else
+    int flags = fcntl(static_cast<int>(socket), F_GETFL, 0);
+    fcntl(static_cast<int>(socket), F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+// Waits until the socket can be read or written, for at most timeout (zero:
+// no limit) and never past the request's deadline. On failure error says
+// why: "timed out" or "cancelled".
+bool WaitForSocket(intptr_t socket, bool forWrite, std::chrono::milliseconds timeout,
+                   const HttpRequest& request, std::string& error) {
+    auto until = request.deadline;
+    if (timeout.count() > 0) {
+        until = std::min(until, std::chrono::steady_clock::now() + timeout);
+    }
+
+    while (true) {
+        if (request.cancel && request.cancel->IsCancelled()) {
+            error = "cancelled";
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= until) {
+            error = "timed out";
+            return false;
+        }
+
+        // Wake up now and then to notice cancellation
+        int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count() + 1;
+        int slice = static_cast<int>(std::min<int64_t>(remaining, CANCEL_POLL_MS));
+#ifdef _WIN32
+        WSAPOLLFD descriptor = {};
+        descriptor.fd = static_cast<SOCKET>(socket);
+        descriptor.events = forWrite ? POLLWRNORM : POLLRDNORM;
+        int ready = WSAPoll(&descriptor, 1, slice);
+#else
+        pollfd descriptor = {};
+        descriptor.fd = static_cast<int>(socket);
+        descriptor.events = forWrite ? POLLOUT : POLLIN;
+        int ready = poll(&descriptor, 1, slice);
+#endif
+        if (ready > 0) {
+            return true;    // Errors and hang-ups surface in the next send or recv
+        }
+        if (ready < 0 && !WouldBlock()) {
+            error = "poll failed";
+            return false;
+        }
+    }
+}
+
+// When the peer has acknowledged everything written, so the time taken
+// reflects the link rather than the local send buffer. Gives up (returning
+// the time then) as soon as response data arrives or the request's limits
+// are reached. Only Linux reports unacknowledged bytes; elsewhere, or if the
+// query fails, it returns an unset time at once.
+std::chrono::steady_clock::time_point WaitForAcknowledgement(intptr_t socket, const HttpRequest& request) {
+#ifdef __linux__
+    auto started = std::chrono::steady_clock::now();
+    while (true) {
+        int unacknowledged = 0;
+        if (ioctl(static_cast<int>(socket), SIOCOUTQ, &unacknowledged) != 0) {
+            return std::chrono::steady_clock::time_point();
+        }
+        if (unacknowledged == 0) {
+            break;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if ((request.cancel && request.cancel->IsCancelled()) || now >= request.deadline ||
+            (request.sendTimeout.count() > 0 && now - started >= request.sendTimeout)) {
+            break;
+        }
+        pollfd descriptor = {};
+        descriptor.fd = static_cast<int>(socket);
+        descriptor.events = POLLIN;
+        if (poll(&descriptor, 1, ACK_POLL_MS) != 0) {
+            break;      // The response (or an error) is the reader's to handle
+        }
+    }
+    return std::chrono::steady_clock::now();
+#else
+    (void)socket;
+    (void)request;
+    return std::chrono::steady_clock::time_point();
+#endif
+}
+
+std::string ToLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string Trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+// Buffered reader over a connected non-blocking socket; every wait for data
+// is bounded by the request's receive timeout and deadline
+class SocketReader {
+public:
+    SocketReader(intptr_t socket, const HttpRequest& request)
+        : socket(socket), request(request), position(0), bytesReceived(0) {}
+
+    size_t BytesReceived() const { return bytesReceived; }
+    bool HasUnreadData() const { return position < buffer.size(); }
+
+    // Why the last read failed when it was not the peer closing: "timed out" or "cancelled"
+    const std::string& WaitError() const { return waitError; }
+
+    // Error text for a read that failed while doing what
+    std::string Failure(const std::string& what) const {
+        return (waitError.empty() ? std::string("connection closed") : waitError) + " " + what;
+    }
+
+    bool ReadLine(std::string& line) {
+        while (true) {
+            size_t end = buffer.find("\r\n", position);
+            if (end != std::string::npos) {
+                line = buffer.substr(position, end - position);
+                position = end + 2;
+                return true;
+            }
+            if (!Fill()) {
+                return false;
+            }
+        }
+    }
+
+    bool ReadExact(size_t count, std::string& out) {
+        while (buffer.size() - position < count) {
+            if (!Fill()) {
+                return false;
+            }
+        }
+        out.append(buffer, position, count);
+        position += count;
+        return true;
+    }
+
+    // False if a wait failed before the peer closed the connection
+    bool ReadToEnd(std::string& out) {
+        do {
+            out.append(buffer, position, std::string::npos);
+            position = buffer.size();
+        } while (Fill());
+        return waitError.empty();
+    }
+
+private:
+    intptr_t socket;
+    const HttpRequest& request;
+    std::string buffer;
+    size_t position;
+    size_t bytesReceived;
+    std::string waitError;
+
+    bool Fill() {
+        if (position > 0) {
+            buffer.erase(0, position);
+            position = 0;
+        }
+
+        char chunk[READ_CHUNK_SIZE];
+        while (true) {
+#ifdef _WIN32
+            int received = recv(static_cast<SOCKET>(socket), chunk, static_cast<int>(sizeof(chunk)), 0);
+#else
+            ssize_t received = recv(static_cast<int>(socket), chunk, sizeof(chunk), 0);
+#endif
+            if (received > 0) {
+                buffer.append(chunk, static_cast<size_t>(received));
+                bytesReceived += static_cast<size_t>(received);
+                return true;
+            }
+            if (received == 0 || !WouldBlock()) {
+                return false;
+            }
+            if (!WaitForSocket(socket, false, request.receiveTimeout, request, waitError)) {
+                return false;
+            }
+        }
+    }
+};
+
+} // namespace
+
+SocketHttpClient::SocketHttpClient(size_t maxIdlePerHost)
+    : maxIdlePerHost(maxIdlePerHost)
+    , requestsSent(0)
+    , connectionsOpened(0)
+    , connectionsReused(0)
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+}
+
+SocketHttpClient::~SocketHttpClient() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (auto& host : idleConnections) {
+            for (SocketHandle socket : host.second) {
+                CloseSocket(socket);
+            }
+        }
+        idleConnections.clear();
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+HttpClient::Stats SocketHttpClient::GetStats() const {
+    Stats stats;
+    stats.requestsSent = requestsSent.load();
+    stats.connectionsOpened = connectionsOpened.load();
+    stats.connectionsReused = connectionsReused.load();
+    return stats;
+}
+
+bool SocketHttpClient::CanTimeUploads() const {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+HttpResponse SocketHttpClient::Send(const HttpRequest& request) {
+    HttpUrl url;
+    if (!HttpUrl::Parse(request.url, url)) {
+        throw std::runtime_error("Invalid URL: " + request.url);
+    }
+    if (url.IsSecure()) {
+        throw std::runtime_error("HTTPS is not supported by the socket HTTP backend: " + url.host);
+    }
+
+    // A pooled connection may have been closed by the server while idle. If it
+    // fails before any response byte arrives, retry once on a fresh connection.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (request.cancel && request.cancel->IsCancelled()) {
+            throw std::runtime_error("HTTP request to " + url.HostKey() + " cancelled");
+        }
+        bool reused = false;
+        SocketHandle socket = AcquireConnection(url, request, reused);
+
+        HttpResponse response;
+        bool keepAlive = false;
+        bool retryable = false;
+        std::string error;
+        requestsSent++;
+
+        if (Exchange(socket, url, request, response, keepAlive, retryable, error)) {
+            if (keepAlive) {
+                ReleaseConnection(url, socket);
+            } else {
+                CloseSocket(socket);
+            }
+            return response;
+        }
+
+        CloseSocket(socket);
+        if (!(reused && retryable)) {
+            throw std::runtime_error("HTTP request to " + url.HostKey() + " failed: " + error);
+        }
+        DEBUG_LOG("SocketHttpClient - stale pooled connection to " + url.HostKey() + ", reconnecting");
+    }
+
+    throw std::runtime_error("HTTP request to " + url.HostKey() + " failed");
+}
+
+SocketHttpClient::SocketHandle SocketHttpClient::AcquireConnection(const HttpUrl& url, const HttpRequest& request, bool& reused) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        auto it = idleConnections.find(url.HostKey());
+        if (it != idleConnections.end()) {
+            while (!it->second.empty()) {
+                SocketHandle socket = it->second.back();
+                it->second.pop_back();
+                if (IsConnectionAlive(socket)) {
+                    connectionsReused++;
+                    reused = true;
+                    return socket;
+                }
+                CloseSocket(socket);
+            }
+        }
+    }
+
+    reused = false;
+    return OpenConnection(url, request);
+}
+
+void SocketHttpClient::ReleaseConnection(const HttpUrl& url, SocketHandle socket) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    auto& idle = idleConnections[url.HostKey()];
+    if (idle.size() >= maxIdlePerHost) {
+        CloseSocket(socket);
+        return;
+    }
+    idle.push_back(socket);
+}
+
+SocketHttpClient::SocketHandle SocketHttpClient::OpenConnection(const HttpUrl& url, const HttpRequest& request) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo* addresses = nullptr;
+    std::string port = std::to_string(url.port);
+    if (getaddrinfo(url.host.c_str(), port.c_str(), &hints, &addresses) != 0 || !addresses) {
+        throw std::runtime_error("Failed to resolve host: " + url.host);
+    }
+
+    SocketHandle result = -1;
+    std::string error;
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+#ifdef _WIN32
+        SOCKET s = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (s == INVALID_SOCKET) {
+            continue;
+        }
+        BOOL noDelay = TRUE;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        SocketHandle candidate = static_cast<SocketHandle>(s);
+        SetNonBlocking(candidate);
+        bool connected = connect(s, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0;
+#else
+        int s = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (s < 0) {
+            continue;
+        }
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+#ifdef SO_NOSIGPIPE
+        int noSigPipe = 1;
+        setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+        SocketHandle candidate = static_cast<SocketHandle>(s);
+        SetNonBlocking(candidate);
+        bool connected = connect(s, address->ai_addr, address->ai_addrlen) == 0;
+#endif
+        // Non-blocking connect: wait for the handshake, then ask how it went
+        if (!connected && ConnectInProgress() &&
+            WaitForSocket(candidate, true, request.connectTimeout, request, error)) {
+            int socketError = 0;
+            socklen_t length = sizeof(socketError);
+            getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&socketError), &length);
+            connected = socketError == 0;
+        }
+        if (!connected) {
+            CloseSocket(candidate);
+            if (error == "cancelled" || std::chrono::steady_clock::now() >= request.deadline) {
+                break;
+            }
+            continue;
+        }
+        result = candidate;
+        break;
+    }
+    freeaddrinfo(addresses);
+
+    if (result == -1) {
+        throw std::runtime_error("Failed to connect to " + url.HostKey() + (error.empty() ? "" : ": " + error));
+    }
+
+    connectionsOpened++;
+    DEBUG_LOG("SocketHttpClient - opened connection to " + url.HostKey());
+    return result;
+}
+
+bool SocketHttpClient::Exchange(SocketHandle socket, const HttpUrl& url, const HttpRequest& request,
+                                HttpResponse& response, bool& keepAlive, bool& retryable, std::string& error) {
+    retryable = false;
+
+    // Request head
+    std::string head = request.method + " " + url.path + " HTTP/1.1\r\n";
+    head += "Host: " + url.host + (url.port != 80 ? ":" + std::to_string(url.port) : "") + "\r\n";
+    head += "User-Agent: TeamsTranscriptionApp/1.0\r\n";
+    head += "Connection: keep-alive\r\n";
+    for (const auto& header : request.headers) {
+        head += header.first + ": " + header.second + "\r\n";
+    }
+    if (!request.body.empty() || request.method == "POST" || request.method == "PUT") {
+        head += "Content-Length: " + std::to_string(request.BodySize()) + "\r\n";
+    }
+    head += "\r\n";
+
+    // Head and body leave together, so small parts do not go out as packets of their own
+    std::vector<HttpBodySpan> spans;
+    spans.reserve(request.body.size() + 1);
+    spans.emplace_back(head.data(), head.size());
+    spans.insert(spans.end(), request.body.begin(), request.body.end());
+    response.sendStartedAt = std::chrono::steady_clock::now();
+    if (!SendAll(socket, std::move(spans), request, error)) {
+        retryable = error.empty();
+        error = error.empty() ? "send failed" : error + " while sending";
+        return false;
+    }
+    response.sentAt = WaitForAcknowledgement(socket, request);
+
+    // Status line
+    SocketReader reader(socket, request);
+    std::string line;
+    if (!reader.ReadLine(line)) {
+        retryable = reader.BytesReceived() == 0 && reader.WaitError().empty();
+        error = reader.Failure("before response");
+        return false;
+    }
+    response.firstByteAt = std::chrono::steady_clock::now();
+
+    size_t firstSpace = line.find(' ');
+    if (line.compare(0, 5, "HTTP/") != 0 || firstSpace == std::string::npos) {
+        error = "malformed status line: " + line;
+        return false;
+    }
+    bool http10 = line.compare(0, firstSpace, "HTTP/1.0") == 0;
+    response.statusCode = std::atoi(line.c_str() + firstSpace + 1);
+
+    // Headers
+    while (true) {
+        if (!reader.ReadLine(line)) {
+            error = reader.Failure("while reading headers");
+            return false;
+        }
+        if (line.empty()) {
+            break;
+        }
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            response.headers.emplace_back(Trim(line.substr(0, colon)), Trim(line.substr(colon + 1)));
+        }
+    }
+
+    std::string connection = ToLower(response.GetHeader("Connection"));
+    keepAlive = http10 ? connection == "keep-alive" : connection != "close";
+
+    // Body
+    std::string transferEncoding = ToLower(response.GetHeader("Transfer-Encoding"));
+    std::string contentLength = response.GetHeader("Content-Length");
+    bool noBody = request.method == "HEAD" || response.statusCode == 204 || response.statusCode == 304 ||
+                  (response.statusCode >= 100 && response.statusCode < 200);
+
+    if (noBody) {
+        // Nothing to read
+    } else if (transferEncoding.find("chunked") != std::string::npos) {
+        while (true) {
+            if (!reader.ReadLine(line)) {
+                error = reader.Failure("while reading chunk size");
+                return false;
+            }
+            size_t chunkSize = std::strtoul(line.c_str(), nullptr, 16);
+            if (chunkSize == 0) {
+                break;
+            }
+            if (!reader.ReadExact(chunkSize, response.body) || !reader.ReadLine(line)) {
+                error = reader.Failure("while reading chunk");
+                return false;
+            }
+        }
+        // Trailers
+        do {
+            if (!reader.ReadLine(line)) {
+                error = reader.Failure("while reading trailers");
+                return false;
+            }
+        } while (!line.empty());
+    } else if (!contentLength.empty()) {
+        size_t length = std::strtoul(contentLength.c_str(), nullptr, 10);
+        if (!reader.ReadExact(length, response.body)) {
+            error = reader.Failure("while reading body");
+            return false;
+        }
+    } else {
+        // Body delimited by connection close
+        keepAlive = false;
+        if (!reader.ReadToEnd(response.body)) {
+            error = reader.Failure("while reading body");
+            return false;
+        }
+    }
+
+    // Anything left over means the stream is out of sync; do not reuse it
+    if (reader.HasUnreadData()) {
+        keepAlive = false;
+    }
+
+    return true;
+}
+
+bool SocketHttpClient::IsConnectionAlive(SocketHandle socket) {
+    // An idle keep-alive connection must not be readable: readable means the
+    // peer closed it (EOF) or sent something unexpected.
+#ifdef _WIN32
+    WSAPOLLFD descriptor = {};
+    descriptor.fd = static_cast<SOCKET>(socket);
+    descriptor.events = POLLRDNORM;
+    return WSAPoll(&descriptor, 1, 0) == 0;
+#else
+    pollfd descriptor = {};
+    descriptor.fd = static_cast<int>(socket);
+    descriptor.events = POLLIN;
+    return poll(&descriptor, 1, 0) == 0;
+#endif
+}
+
+bool SocketHttpClient::SendAll(SocketHandle socket, std::vector<HttpBodySpan> spans, const HttpRequest& request, std::string& error) {
+    size_t first = 0;   // First span with bytes left to send
+    while (true) {
+        while (first < spans.size() && spans[first].size == 0) {
+            first++;
+        }
+        if (first == spans.size()) {
+            return true;
+        }
+
+#ifdef _WIN32
+        WSABUF buffers[MAX_GATHER_SPANS];
+        DWORD count = 0;
+        for (size_t i = first; i < spans.size() && count < MAX_GATHER_SPANS; ++i) {
+            buffers[count].buf = reinterpret_cast<CHAR*>(const_cast<uint8_t*>(spans[i].data));
+            buffers[count].len = static_cast<ULONG>(std::min<size_t>(spans[i].size, 1 << 30));
+            count++;
+        }
+        DWORD sentBytes = 0;
+        int64_t sent = WSASend(static_cast<SOCKET>(socket), buffers, count, &sentBytes, 0, nullptr, nullptr) == 0
+                           ? static_cast<int64_t>(sentBytes) : -1;
+#else
+        iovec vectors[MAX_GATHER_SPANS];
+        size_t count = 0;
+        for (size_t i = first; i < spans.size() && count < MAX_GATHER_SPANS; ++i) {
+            vectors[count].iov_base = const_cast<uint8_t*>(spans[i].data);
+            vectors[count].iov_len = spans[i].size;
+            count++;
+        }
+        msghdr message = {};
+        message.msg_iov = vectors;
+        message.msg_iovlen = count;
+        ssize_t sent = sendmsg(static_cast<int>(socket), &message, SEND_FLAGS);
+#endif
+        if (sent <= 0) {
+            if (sent < 0 && WouldBlock() && WaitForSocket(socket, true, request.sendTimeout, request, error)) {
+                continue;
+            }
+            return false;
+        }
+
+        // Step past what went out, possibly ending inside a span
+        size_t remaining = static_cast<size_t>(sent);
+        while (remaining > 0) {
+            size_t step = std::min(remaining, spans[first].size);
+            spans[first].data += step;
+            spans[first].size -= step;
+            remaining -= step;
+            if (spans[first].size == 0) {
+                first++;
+            }
+        }
+    }
+}
+
+void SocketHttpClient::CloseSocket(SocketHandle socket) {
+    if (socket == -1) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(socket));
+#else
+    close(static_cast<int>(socket));
+#endif
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "HttpClient.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Plain-HTTP/1.1 client on BSD sockets (Winsock on Windows).
+// Keeps a pool of idle keep-alive connections per host:port and reuses them for
+// later requests. HTTPS is not supported; use WinHttpClient for TLS endpoints.
+// Sockets are non-blocking so every wait honours the request's timeouts,
+// deadline and cancellation; name resolution is not bounded.
+class SocketHttpClient : public HttpClient {
+public:
+    explicit SocketHttpClient(size_t maxIdlePerHost = 4);
+    ~SocketHttpClient() override;
+
+    HttpResponse Send(const HttpRequest& request) override;
+    Stats GetStats() const override;
+    bool CanTimeUploads() const override;
+
+private:
+    // SOCKET on Windows, file descriptor elsewhere; -1 when invalid
+    using SocketHandle = intptr_t;
+
+    size_t maxIdlePerHost;
+    std::mutex poolMutex;
+    std::map<std::string, std::vector<SocketHandle>> idleConnections;
+
+    std::atomic<uint64_t> requestsSent;
+    std::atomic<uint64_t> connectionsOpened;
+    std::atomic<uint64_t> connectionsReused;
+
+    SocketHandle AcquireConnection(const HttpUrl& url, const HttpRequest& request, bool& reused);
+    void ReleaseConnection(const HttpUrl& url, SocketHandle socket);
+    SocketHandle OpenConnection(const HttpUrl& url, const HttpRequest& request);
+
+    // Writes the request and reads the full response. On failure, retryable is
+    // set when nothing was received, so the request can go out on a new connection;
+    // never after a timeout or cancellation.
+    bool Exchange(SocketHandle socket, const HttpUrl& url, const HttpRequest& request,
+                  HttpResponse& response, bool& keepAlive, bool& retryable, std::string& error);
+
+    static bool IsConnectionAlive(SocketHandle socket);
+    // Gathers the spans into as few send calls as the system allows
+    static bool SendAll(SocketHandle socket, std::vector<HttpBodySpan> spans, const HttpRequest& request, std::string& error);
+    static void CloseSocket(SocketHandle socket);
+};
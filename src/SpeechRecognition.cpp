@@ -1,93 +1,178 @@
 #include "SpeechRecognition.h"
 #include "SimpleLogger.h"
+#include "UploadQueue.h"
+#include "UploadSpool.h"
+#include "BandwidthEstimator.h"
+#include "CancellationToken.h"
+#include "FlacEncoder.h"
+#include "HttpClient.h"
+#include "RetryPolicy.h"
+#include "SampleConversion.h"
+#include "TimelineTrace.h"
+#include "UtteranceSegmenter.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <thread>
 #include <chrono>
-#include <windows.h>
-#include <winhttp.h>
+#include <cstring>
+#include <deque>
 #include <vector>
 #include <string>
-
-#pragma comment(lib, "winhttp.lib")
+#include <mutex>
 
 // Audio converter implementation
-std::vector<BYTE> AudioConverter::ConvertAudioFormat(
-    const std::vector<BYTE>& inputData,
-    const AudioCapture::AudioFormat& inputFormat,
-    AudioCapture::AudioFormat& outputFormat
-) {
-    // Set optimal output format for Azure OpenAI
-    outputFormat.sampleRate = 16000;    // 16kHz is optimal for speech recognition
-    outputFormat.channels = 1;          // Mono
-    outputFormat.bitsPerSample = 16;    // 16-bit PCM
-    outputFormat.bytesPerSecond = outputFormat.sampleRate * outputFormat.channels * (outputFormat.bitsPerSample / 8);
-    
-    // Convert 32-bit float input to 16-bit PCM
-    size_t sampleCount = inputData.size() / sizeof(float);
-    const float* floatData = reinterpret_cast<const float*>(inputData.data());
-    std::vector<int16_t> pcmData = ConvertFloatToPCM16(floatData, sampleCount);
-    
-    // Convert stereo to mono if needed
-    if (inputFormat.channels == 2) {
-        pcmData = StereoToMono(pcmData);
+namespace {
+
+const uint32_t OUTPUT_SAMPLE_RATE = 16000;
+const size_t DIRECT_BLOCK_FRAMES = 256;
+
+// Gain that maps one input sample onto the 16-bit range
+template <typename Sample> struct SampleScale;
+template <> struct SampleScale<float> { static constexpr float VALUE = 32767.0f; };
+template <> struct SampleScale<int16_t> { static constexpr float VALUE = 1.0f; };
+
+inline int16_t RoundToPCM16(float value) {
+    value = value < 32767.0f ? value : 32767.0f;   // NaN maps to full scale
+    value = value > -32768.0f ? value : -32768.0f;
+    return static_cast<int16_t>(value + std::copysign(0.5f, value));   // Branchless round half away
+}
+
+// Average interleaved frames to mono floats already scaled to the 16-bit range
+template <typename Sample, int Channels>
+inline void DownmixFrames(const Sample* frames, size_t count, int channels, float* destination) {
+    const int channelCount = Channels > 0 ? Channels : channels;
+    const float gain = SampleScale<Sample>::VALUE / channelCount;
+    for (size_t i = 0; i < count; ++i) {
+        const Sample* frame = frames + i * channelCount;
+        float sum = 0.0f;
+        for (int c = 0; c < channelCount; ++c) {
+            sum += static_cast<float>(frame[c]);
+        }
+        destination[i] = sum * gain;
     }
-    
-    // Downsample if needed
-    if (inputFormat.sampleRate != outputFormat.sampleRate) {
-        pcmData = Downsample(pcmData, inputFormat.sampleRate, outputFormat.sampleRate, inputFormat.channels == 2 ? 1 : inputFormat.channels);
+}
+
+} // namespace
+
+AudioFormat AudioConverter::GetOutputFormat() {
+    AudioFormat format;
+    format.sampleRate = OUTPUT_SAMPLE_RATE;   // 16kHz is optimal for speech recognition
+    format.channels = 1;                      // Mono
+    format.bitsPerSample = 16;                // 16-bit PCM
+    format.bytesPerSecond = format.sampleRate * format.channels * (format.bitsPerSample / 8);
+    return format;
+}
+
+size_t AudioConverter::MaxOutputSamples(size_t inputBytes, const AudioFormat& inputFormat) const {
+    size_t frameBytes = static_cast<size_t>(inputFormat.channels) * (inputFormat.bitsPerSample / 8);
+    if (frameBytes == 0 || inputFormat.sampleRate == 0) {
+        return 0;
     }
-    
-    // Convert back to BYTE vector
-    std::vector<BYTE> result(pcmData.size() * sizeof(int16_t));
-    memcpy(result.data(), pcmData.data(), result.size());
-    
-    return result;
+    size_t frameCount = inputBytes / frameBytes;
+    if (inputFormat.sampleRate == OUTPUT_SAMPLE_RATE) {
+        return frameCount;
+    }
+    return static_cast<size_t>((static_cast<uint64_t>(frameCount) * OUTPUT_SAMPLE_RATE) / inputFormat.sampleRate) + 2;
 }
 
-std::vector<int16_t> AudioConverter::ConvertFloatToPCM16(const float* floatData, size_t sampleCount) {
-    std::vector<int16_t> pcmData(sampleCount);
-    
-    for (size_t i = 0; i < sampleCount; ++i) {
-        // Clamp float to [-1.0, 1.0] range and convert to 16-bit
-        float sample = std::max(-1.0f, std::min(1.0f, floatData[i]));
-        pcmData[i] = static_cast<int16_t>(sample * 32767.0f);
+size_t AudioConverter::ConvertInto(const uint8_t* input, size_t inputBytes, const AudioFormat& inputFormat,
+                                   int16_t* output, size_t outputCapacity) {
+    TRACE_SCOPE("ConvertAudio");
+    int channels = inputFormat.channels;
+    if (channels == 0 || (inputFormat.bitsPerSample != 32 && inputFormat.bitsPerSample != 16)) {
+        WARN_LOG("AudioConverter - unsupported input format: " + std::to_string(inputFormat.bitsPerSample) +
+                 " bits, " + std::to_string(channels) + " channels");
+        return 0;
+    }
+    if (MaxOutputSamples(inputBytes, inputFormat) > outputCapacity) {
+        ERROR_LOG("AudioConverter - output span too small: " + std::to_string(outputCapacity) + " samples");
+        return 0;
+    }
+
+    // The resampler carries its filter history and phase across packets
+    uint32_t inputRate = inputFormat.sampleRate;
+    if (inputRate != OUTPUT_SAMPLE_RATE && (!resampler || resampler->GetInputRate() != inputRate)) {
+        resampler = std::make_unique<PolyphaseResampler>(inputRate, OUTPUT_SAMPLE_RATE);
+    }
+
+    size_t frameCount = inputBytes / (static_cast<size_t>(channels) * (inputFormat.bitsPerSample / 8));
+    if (inputFormat.bitsPerSample == 32) {
+        const float* samples = reinterpret_cast<const float*>(input);
+        if (channels == 2 && inputRate == OUTPUT_SAMPLE_RATE) {
+            return ConvertStereoFloatDirect(samples, frameCount, output);
+        }
+        switch (channels) {
+            case 1: return ConvertFrames<float, 1>(samples, frameCount, channels, inputRate, output);
+            case 2: return ConvertFrames<float, 2>(samples, frameCount, channels, inputRate, output);
+            default: return ConvertFrames<float, 0>(samples, frameCount, channels, inputRate, output);
+        }
+    }
+
+    const int16_t* samples = reinterpret_cast<const int16_t*>(input);
+    switch (channels) {
+        case 1: return ConvertFrames<int16_t, 1>(samples, frameCount, channels, inputRate, output);
+        case 2: return ConvertFrames<int16_t, 2>(samples, frameCount, channels, inputRate, output);
+        default: return ConvertFrames<int16_t, 0>(samples, frameCount, channels, inputRate, output);
     }
-    
-    return pcmData;
 }
 
-std::vector<int16_t> AudioConverter::Downsample(const std::vector<int16_t>& input, int inputRate, int outputRate, int channels) {
-    if (inputRate == outputRate) {
-        return input;
+template <typename Sample, int Channels>
+size_t AudioConverter::ConvertFrames(const Sample* input, size_t frameCount, int channels, uint32_t inputRate, int16_t* output) {
+    const size_t stride = Channels > 0 ? Channels : static_cast<size_t>(channels);
+    auto load = [input, stride, channels](float* destination, size_t offset, size_t count) {
+        DownmixFrames<Sample, Channels>(input + offset * stride, count, channels, destination);
+    };
+    auto store = [output](size_t index, float value) {
+        output[index] = RoundToPCM16(value);
+    };
+
+    if (inputRate != OUTPUT_SAMPLE_RATE) {
+        return resampler->Process(frameCount, load, store);
     }
-    
-    // Simple downsampling using decimation
-    float ratio = static_cast<float>(inputRate) / outputRate;
-    size_t outputSamples = static_cast<size_t>(input.size() / ratio);
-    std::vector<int16_t> output(outputSamples);
-    
-    for (size_t i = 0; i < outputSamples; ++i) {
-        size_t inputIndex = static_cast<size_t>(i * ratio);
-        if (inputIndex < input.size()) {
-            output[i] = input[inputIndex];
+
+    // Already at the output rate: downmix through a small stack block
+    float block[DIRECT_BLOCK_FRAMES];
+    for (size_t offset = 0; offset < frameCount; offset += DIRECT_BLOCK_FRAMES) {
+        size_t count = std::min(DIRECT_BLOCK_FRAMES, frameCount - offset);
+        load(block, offset, count);
+        for (size_t i = 0; i < count; ++i) {
+            store(offset + i, block[i]);
         }
     }
-    
-    return output;
+    return frameCount;
+}
+
+size_t AudioConverter::ConvertStereoFloatDirect(const float* input, size_t frameCount, int16_t* output) {
+    SampleConversion::StereoFloatToMono(input, output, frameCount);
+    return frameCount;
 }
 
-std::vector<int16_t> AudioConverter::StereoToMono(const std::vector<int16_t>& stereoData) {
-    std::vector<int16_t> monoData(stereoData.size() / 2);
+std::vector<uint8_t> AudioConverter::ConvertAudioFormat(
+    const std::vector<uint8_t>& inputData,
+    const AudioFormat& inputFormat,
+    AudioFormat& outputFormat
+) {
+    TRACE_SCOPE("ConvertAudioFormat");
+    outputFormat = GetOutputFormat();
     
-    for (size_t i = 0; i < monoData.size(); ++i) {
-        // Average left and right channels
-        int32_t left = stereoData[i * 2];
-        int32_t right = stereoData[i * 2 + 1];
-        monoData[i] = static_cast<int16_t>((left + right) / 2);
-    }
+    // Single allocation; the conversion itself writes in place
+    std::vector<uint8_t> result(MaxOutputSamples(inputData.size(), inputFormat) * sizeof(int16_t));
+    size_t samples = ConvertInto(inputData.data(), inputData.size(), inputFormat,
+                                 reinterpret_cast<int16_t*>(result.data()), result.size() / sizeof(int16_t));
+    result.resize(samples * sizeof(int16_t));
     
-    return monoData;
+    return result;
+}
+
+void AudioConverter::Reset() {
+    if (resampler) {
+        resampler->Reset();
+    }
 }
 
 // Abstract interface for speech providers
@@ -95,9 +180,28 @@ class SpeechRecognition::ISpeechProvider {
 public:
     virtual ~ISpeechProvider() = default;
     virtual bool Initialize(const SpeechConfig& config) = 0;
-    virtual void ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) = 0;
+    virtual void ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format) = 0;
     virtual void SetTranscriptionCallback(TranscriptionCallback callback) = 0;
+    virtual void SetSegmentCallback(SegmentCallback callback) {}
+    virtual void SetRecoveredCallback(RecoveredCallback callback) {}
     virtual bool IsInitialized() const = 0;
+
+    // Send whatever audio is buffered without waiting for a full chunk
+    virtual void Flush() {}
+
+    // Audio the voice gate kept back; only advances the segment timeline
+    virtual void SkipAudio(size_t bytes, const AudioFormat& format) {}
+
+    virtual void WaitForUploads(size_t maxOutstanding) {}
+
+    // Where to record per-stage latency; set before audio flows
+    virtual void SetLatencyTracker(std::shared_ptr<PipelineLatency> tracker) {}
+
+    // Abandon queued and in-flight requests; later audio is sent as usual
+    virtual void CancelUploads() {}
+
+    // Per-deployment traffic, for providers that route uploads
+    virtual std::vector<DeploymentStats> GetDeploymentStats() const { return {}; }
 };
 
 // Azure Speech Services Provider
@@ -106,7 +210,7 @@ private:
     bool initialized;
     SpeechRecognition::SpeechConfig config;
     SpeechRecognition::TranscriptionCallback callback;
-    std::vector<BYTE> audioBuffer;
+    std::vector<uint8_t> audioBuffer;
     size_t bufferThreshold;
 
 public:
@@ -127,7 +231,7 @@ public:
         return true;
     }
 
-    void ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) override {
+    void ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format) override {
         if (!initialized || !callback) {
             WARN_LOG("AzureSpeechProvider::ProcessAudioData - Not initialized (" + std::string(initialized ? "true" : "false") + ") or no callback (" + std::string(callback ? "set" : "null") + ")");
             return;
@@ -155,7 +259,7 @@ public:
     }
 
 private:
-    void ProcessAccumulatedAudio(const AudioCapture::AudioFormat& format) {
+    void ProcessAccumulatedAudio(const AudioFormat& format) {
         // This is a stub implementation for demonstration
         // In a real implementation, this would send audio to Azure Speech Services
         
@@ -219,7 +323,7 @@ public:
         return initialized;
     }
 
-    void ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) override {
+    void ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format) override {
         // Stub implementation
     }
 
@@ -249,7 +353,7 @@ public:
         return initialized;
     }
 
-    void ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) override {
+    void ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format) override {
         // Stub implementation
     }
 
@@ -268,305 +372,913 @@ private:
     bool initialized;
     SpeechRecognition::SpeechConfig config;
     SpeechRecognition::TranscriptionCallback callback;
-    std::vector<BYTE> audioBuffer;
-    std::chrono::steady_clock::time_point lastTranscription;
+    SpeechRecognition::SegmentCallback segmentCallback;
+    SpeechRecognition::RecoveredCallback recoveredCallback;
+    std::mutex callbackMutex;
+    AudioConverter audioConverter;
+
+    // Where each queued segment sits on the input timeline, by upload sequence
+    std::mutex timelineMutex;
+    std::map<uint64_t, std::pair<double, double>> segmentTimes;
+    double skippedSeconds;      // Audio the voice gate held back (audio thread only)
+
+    // Arrival time of each converted packet, by the stream position it ends
+    // at, so a segment can be traced back to its first audio, which starts
+    // the clock on its upload deadline (audio thread only)
+    std::shared_ptr<PipelineLatency> latency;
+    std::deque<std::pair<uint64_t, ChunkTrace::TimePoint>> packetArrivals;
+    uint64_t convertedSamples;
+
+    // Packets are converted straight into the segmenter's buffer, which cuts
+    // it into utterances with WAV header space in front
+    std::unique_ptr<UtteranceSegmenter> segmenter;
+
+    // Shared by the upload workers so connections are reused across chunks
+    std::unique_ptr<HttpClient> httpClient;
+
+    // With outputFormat "flac" chunks are compressed in place before they are
+    // queued; the encoder output buffer only grows (audio thread only)
+    std::unique_ptr<FlacEncoder> flacEncoder;
+    std::vector<uint8_t> flacBuffer;
+
+    // With adaptiveUploadFormat the send rate the workers measure picks each
+    // chunk's encoding, down to 8 kHz FLAC on a slow link (ladder and 8 kHz
+    // path are audio thread only)
+    BandwidthEstimator bandwidth;
+    std::unique_ptr<UploadFormatLadder> formatLadder;
+    std::unique_ptr<FlacEncoder> narrowbandEncoder;
+    std::unique_ptr<PolyphaseResampler> narrowbandResampler;
+    std::vector<int16_t> narrowbandSamples;
+
+    // Multipart framing around the audio file, built once per session; each
+    // request sends prefix, chunk and trailer as three spans
+    std::string multipartContentType;
+    std::string multipartPrefix;
+    std::string multipartFlacPrefix;    // For chunks that were compressed
+    std::string multipartTrailer;
+
+    // Throttling and failures: retry with backoff within a budget. Each
+    // attempt goes to the deployment the router picks, which stops calling a
+    // deployment for a while when it keeps failing or throttling.
+    RetryPolicy retryPolicy;
+    RetryBudget retryBudget;
+    std::unique_ptr<DeploymentRouter> router;
+    std::atomic<int64_t> lastTranscribedMs;     // Steady clock, when the endpoint last answered 200
+
+    // Chunks whose upload failed because the endpoint was unreachable,
+    // failing or throttling, that the queue shed when full, or that shutdown
+    // kept from being sent are kept in a file-backed spool. A drainer thread
+    // uploads them, oldest first, when no live chunk is waiting, and delivers
+    // the results late. Records an earlier run left are drained too and go to
+    // the recovered callback.
+    std::unique_ptr<UploadSpool> spool;
+    std::atomic<bool> stopping;     // Set by the destructor; the uploads it cancels are spooled
+    std::thread spoolDrainer;
+    std::mutex drainMutex;
+    std::condition_variable drainCondition;
+    bool drainStopping;
+    std::unique_ptr<CancellationToken> drainCancel;
+
+    // Uploads run on worker threads so the capture thread never waits on HTTP.
+    // Declared last so the workers are joined before the state they use goes away.
+    std::unique_ptr<UploadQueue> uploadQueue;
+
+    static constexpr size_t UPLOAD_QUEUE_CAPACITY = 8;     // Chunks waiting for a free request slot
+    static constexpr uint32_t MAX_IN_FLIGHT_REQUESTS = 16;
+    static constexpr size_t WAV_HEADER_SIZE = 44;
+    static constexpr size_t MIN_UPLOAD_BYTES = 16000;      // 0.5 s of 16 kHz mono PCM
+    static constexpr double RETRY_BUDGET_RATIO = 0.2;      // Retries per first attempt, on average
+    static constexpr double RETRY_BUDGET_MIN = 10.0;       // Retries always allowed in a burst
+    static constexpr uint32_t BREAKER_FAILURES = 5;
+    static constexpr uint32_t BREAKER_OPEN_MS = 10000;
+    static constexpr uint32_t DRAIN_RETRY_MIN_MS = 1000;    // Backoff while the spool cannot be drained
+    static constexpr uint32_t DRAIN_RETRY_MAX_MS = 30000;
+    static constexpr uint32_t SPOOL_MAX_ATTEMPTS = 10;      // Failures while other chunks succeed before a record is given up
+
+    // How an upload ended, which decides whether the chunk is worth spooling
+    enum class UploadOutcome {
+        Transcribed,    // The endpoint answered 200; the text may still be empty
+        Failed,         // Network errors or retryable statuses until out of attempts, time or budget
+        Deferred,       // Not sent: circuit open, or throttled past the deadline
+        Rejected,       // The endpoint refused the request; it would fail again
+        Cancelled
+    };
 
 public:
-    AzureOpenAISpeechProvider() : initialized(false) {}
+    AzureOpenAISpeechProvider()
+        : initialized(false), skippedSeconds(0.0), convertedSamples(0),
+          retryBudget(RETRY_BUDGET_RATIO, RETRY_BUDGET_MIN), lastTranscribedMs(0), stopping(false), drainStopping(false) {}
+
+    ~AzureOpenAISpeechProvider() override {
+        // Cancels the uploads in flight, so shutdown does not wait on the network.
+        // Those and the chunks still queued are spooled, so the drainer stops after them.
+        stopping = true;
+        if (uploadQueue) {
+            uploadQueue->Stop();
+        }
+        StopSpoolDrainer();
+
+        if (router) {
+            for (const auto& deployment : router->GetStats()) {
+                INFO_LOG("AzureOpenAI deployment " + deployment.name + ": " + std::to_string(deployment.requests) + " requests, " +
+                         std::to_string(deployment.succeeded) + " ok, " + std::to_string(deployment.throttled) + " throttled, " +
+                         std::to_string(deployment.failed) + " failed, latency EWMA " +
+                         std::to_string(static_cast<int>(deployment.latencyMs)) + " ms");
+            }
+        }
+    }
 
     bool Initialize(const SpeechRecognition::SpeechConfig& speechConfig) override {
         config = speechConfig;
         
-        if (config.apiKey.empty() || config.endpoint.empty()) {
+        std::vector<DeploymentRouter::Target> targets = DeploymentTargets();
+        if (targets.empty()) {
             std::cerr << "Azure OpenAI API key and endpoint are required" << std::endl;
             return false;
         }
         
+        UtteranceSegmenter::Settings segmentSettings;
+        segmentSettings.minUtteranceMs = config.minUtteranceMs;
+        segmentSettings.maxUtteranceMs = config.maxUtteranceMs;
+        segmentSettings.maxLatencyMs = config.maxLatencyMs;
+        segmenter = std::make_unique<UtteranceSegmenter>(AudioConverter::GetOutputFormat().sampleRate, WAV_HEADER_SIZE, segmentSettings);
+
+        // Each request slot is an upload worker with its own connection, and the spool drainer one more
+        size_t inFlight = std::min<uint32_t>(std::max<uint32_t>(1, config.maxInFlightRequests), MAX_IN_FLIGHT_REQUESTS);
+        httpClient = HttpClient::Create(inFlight + (config.spoolPath.empty() ? 0 : 1));
+
+        const AudioFormat outputFormat = AudioConverter::GetOutputFormat();
+        flacEncoder.reset();
+        formatLadder.reset();
+        if (!config.outputFormat.empty() && config.outputFormat != "wav" && config.outputFormat != "flac") {
+            WARN_LOG("AzureOpenAI - Unknown outputFormat '" + config.outputFormat + "', uploading WAV");
+        }
+        // A send rate from a client that cannot see the server acknowledge the
+        // body would only time the local send buffer
+        bool adaptive = config.adaptiveUploadFormat;
+        if (adaptive && !httpClient->CanTimeUploads()) {
+            WARN_LOG("AzureOpenAI - adaptiveUploadFormat needs upload timing this HTTP client cannot provide; "
+                     "keeping outputFormat");
+            adaptive = false;
+        }
+        if (config.outputFormat == "flac" || adaptive) {
+            flacEncoder = std::make_unique<FlacEncoder>(outputFormat.sampleRate, outputFormat.channels);
+        }
+        if (adaptive) {
+            uint32_t narrowbandRate = UploadFormatLadder::SampleRate(UploadFormatLadder::Level::Flac8k);
+            formatLadder = std::make_unique<UploadFormatLadder>(ConfiguredUploadFormat());
+            narrowbandEncoder = std::make_unique<FlacEncoder>(narrowbandRate, outputFormat.channels);
+            narrowbandResampler = std::make_unique<PolyphaseResampler>(outputFormat.sampleRate, narrowbandRate);
+        }
+        BuildMultipartFraming();
+
+        RetryPolicy::Settings retrySettings;
+        retrySettings.maxAttempts = std::max<uint32_t>(1, config.maxUploadAttempts);
+        retryPolicy = RetryPolicy(retrySettings);
+        DeploymentRouter::Settings routerSettings;
+        routerSettings.breakerFailures = BREAKER_FAILURES;
+        routerSettings.breakerOpen = std::chrono::milliseconds(BREAKER_OPEN_MS);
+        if (!config.deploymentRouting.empty() && !DeploymentRouter::ParsePolicy(config.deploymentRouting, routerSettings.policy)) {
+            WARN_LOG("AzureOpenAI - Unknown deploymentRouting '" + config.deploymentRouting + "', routing by latency");
+        }
+        router = std::make_unique<DeploymentRouter>(targets, routerSettings);
+        uploadQueue = std::make_unique<UploadQueue>(UPLOAD_QUEUE_CAPACITY, inFlight,
+                                                    std::chrono::milliseconds(config.headOfLineMaxWaitMs));
+        uploadQueue->Start(
+            [this](UploadQueue::Chunk& chunk) { return UploadChunk(chunk); },
+            [this](uint64_t sequence, const std::string& text, const ChunkTrace& trace) {
+                DeliverTranscription(sequence, text, trace);
+            },
+            [this](UploadQueue::Chunk& chunk) { SpoolChunk(chunk, AudioTime(chunk)); });
+        StartSpoolDrainer();
+
         initialized = true;
-        lastTranscription = std::chrono::steady_clock::now();
+        INFO_LOG("AzureOpenAI audio conversion kernels: " +
+                 std::string(SampleConversion::InstructionSetName(SampleConversion::GetActiveInstructionSet())));
         std::cout << "Azure OpenAI Speech Provider (GPT-4o) initialized" << std::endl;
-        std::cout << "Endpoint: " << config.endpoint << std::endl;
-        std::cout << "Deployment: " << config.deployment << std::endl;
+        for (const auto& target : targets) {
+            std::cout << "Deployment: " << target.name << " (weight " << target.weight << ") at " << target.url << std::endl;
+        }
         return true;
     }
 
-    void ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) override {
-        if (!initialized || !callback) {
-            WARN_LOG("AzureOpenAISpeechProvider::ProcessAudioData - Not initialized (" + std::string(initialized ? "true" : "false") + ") or no callback (" + std::string(callback ? "set" : "null") + ")");
+    void ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format) override {
+        if (!initialized || (!callback && !segmentCallback)) {
+            LOG_RATE_LIMITED(Warn, 5, 10000, "AzureOpenAISpeechProvider::ProcessAudioData - Not initialized (" + std::string(initialized ? "true" : "false") + ") or no callback (" + std::string(callback || segmentCallback ? "set" : "null") + ")");
             return;
         }
 
-        // Accumulate audio data
-        audioBuffer.insert(audioBuffer.end(), audioData.begin(), audioData.end());
-        AUDIO_LOG("AzureOpenAISpeechProvider", audioData.size(), "Buffer total: " + std::to_string(audioBuffer.size()));
+        // Convert each packet as it arrives, directly into the segmenter's buffer
+        auto arrived = std::chrono::steady_clock::now();
+        size_t maxSamples = audioConverter.MaxOutputSamples(audioData.size(), format);
+        int16_t* destination = segmenter->Reserve(maxSamples);
+        size_t samples = audioConverter.ConvertInto(audioData.data(), audioData.size(), format, destination, maxSamples);
+        segmenter->Commit(samples);
+        AUDIO_LOG("AzureOpenAISpeechProvider", audioData.size(), "Converted samples: " + std::to_string(samples));
+
+        convertedSamples += samples;
+        if (samples > 0) {
+            packetArrivals.emplace_back(convertedSamples, arrived);
+        }
+        if (latency) {
+            latency->Record(PipelineLatency::Stage::Convert, std::chrono::steady_clock::now() - arrived);
+        }
 
-        // Process every 1 second of audio for lower latency (reduced from 3 seconds)
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - lastTranscription).count();
-        
-        size_t bytesPerSecond = format.sampleRate * format.channels * (format.bitsPerSample / 8);
-        size_t oneSecondOfAudio = bytesPerSecond * 1;  // Reduced buffer size for real-time
-        
-        DEBUG_LOG("AzureOpenAI - Buffer: " + std::to_string(audioBuffer.size()) + "/" + std::to_string(oneSecondOfAudio) + " bytes, Elapsed: " + std::to_string(elapsed) + "s");
-        
-        if (audioBuffer.size() >= oneSecondOfAudio && elapsed >= 1) {
-            INFO_LOG("AzureOpenAI processing audio chunk - " + std::to_string(audioBuffer.size()) + " bytes");
-            
-            // Convert audio format for optimal Azure OpenAI processing
-            AudioCapture::AudioFormat optimizedFormat;
-            std::vector<BYTE> convertedAudio = AudioConverter::ConvertAudioFormat(audioBuffer, format, optimizedFormat);
-            INFO_LOG("Audio converted: " + std::to_string(audioBuffer.size()) + " -> " + std::to_string(convertedAudio.size()) + " bytes, " +
-                     std::to_string(format.sampleRate) + "Hz -> " + std::to_string(optimizedFormat.sampleRate) + "Hz, " +
-                     std::to_string(format.channels) + "ch -> " + std::to_string(optimizedFormat.channels) + "ch");
-            
-            // Create WAV file with optimized format
-            std::vector<BYTE> wavData = CreateWavFile(convertedAudio, optimizedFormat);
-            INFO_LOG("Created optimized WAV file: " + std::to_string(wavData.size()) + " bytes");
-            
-            // Log WAV sample for debugging
-            static int wavCount = 0;
-            DEBUG_LOG("Created WAV sample #" + std::to_string(++wavCount) + " - " + std::to_string(wavData.size()) + " bytes");
-            
-            // Send to Azure OpenAI for transcription (async in future implementation)
-            std::string transcriptionText = SendToAzureOpenAI(wavData);
-            
-            if (!transcriptionText.empty() && callback) {
-                INFO_LOG("AzureOpenAI transcription successful: '" + transcriptionText + "'");
-                callback(transcriptionText, 0.95);
-                std::cout << "Azure OpenAI transcription: " << transcriptionText << std::endl;
-            } else {
-                WARN_LOG("AzureOpenAI - Empty transcription or no callback");
-            }
-            
-            // Clear buffer and update timestamp
-            audioBuffer.clear();
-            lastTranscription = now;
+        EnqueueReadySegments();
+    }
+
+    // Called when speech ends or recording stops so the tail is not held back
+    void Flush() override {
+        if (!initialized) {
+            return;
         }
+        segmenter->Flush();
+        EnqueueReadySegments();
     }
 
     void SetTranscriptionCallback(SpeechRecognition::TranscriptionCallback cb) override {
-        callback = cb;
+        {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            callback = cb;
+        }
         INFO_LOG("AzureOpenAI transcription callback set");
         std::cout << "Azure OpenAI transcription callback set" << std::endl;
     }
 
+    void SetSegmentCallback(SpeechRecognition::SegmentCallback cb) override {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        segmentCallback = cb;
+    }
+
+    void SetRecoveredCallback(SpeechRecognition::RecoveredCallback cb) override {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        recoveredCallback = cb;
+    }
+
+    void SkipAudio(size_t bytes, const AudioFormat& format) override {
+        size_t frameBytes = static_cast<size_t>(format.channels) * (format.bitsPerSample / 8);
+        if (frameBytes > 0 && format.sampleRate > 0) {
+            skippedSeconds += static_cast<double>(bytes / frameBytes) / format.sampleRate;
+        }
+    }
+
+    void WaitForUploads(size_t maxOutstanding) override {
+        if (uploadQueue) {
+            uploadQueue->WaitForOutstanding(maxOutstanding);
+        }
+    }
+
+    void SetLatencyTracker(std::shared_ptr<PipelineLatency> tracker) override {
+        latency = tracker;
+    }
+
+    void CancelUploads() override {
+        if (uploadQueue) {
+            uploadQueue->Cancel();
+        }
+    }
+
     bool IsInitialized() const override {
         return initialized;
     }
 
+    std::vector<SpeechRecognition::DeploymentStats> GetDeploymentStats() const override {
+        return router ? router->GetStats() : std::vector<SpeechRecognition::DeploymentStats>();
+    }
+
 private:
-    std::vector<BYTE> CreateWavFile(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) {
-        std::vector<BYTE> wavFile;
-        
-        // WAV header (44 bytes)
-        uint32_t dataSize = audioData.size();
+    // The configured deployments, or the single endpoint; entries without a
+    // URL or key are skipped
+    std::vector<DeploymentRouter::Target> DeploymentTargets() const {
+        std::vector<DeploymentRouter::Target> targets;
+        std::vector<SpeechRecognition::DeploymentConfig> deployments = config.deployments;
+        if (deployments.empty()) {
+            deployments.push_back(SpeechRecognition::DeploymentConfig{config.deployment, config.endpoint, config.apiKey, 1});
+        }
+        for (const auto& deployment : deployments) {
+            DeploymentRouter::Target target;
+            target.url = deployment.endpoint;
+            target.apiKey = deployment.apiKey.empty() ? config.apiKey : deployment.apiKey;
+            target.weight = std::max<uint32_t>(1, deployment.weight);
+            target.name = deployment.name.empty() ? DeploymentName(deployment.endpoint) : deployment.name;
+            if (target.url.empty() || target.apiKey.empty()) {
+                if (!config.deployments.empty()) {
+                    WARN_LOG("AzureOpenAI - deployment '" + target.name + "' has no endpoint or API key, skipped");
+                }
+                continue;
+            }
+            targets.push_back(target);
+        }
+        return targets;
+    }
+
+    // The name in .../deployments/NAME/..., else the host
+    static std::string DeploymentName(const std::string& endpoint) {
+        const std::string marker = "/deployments/";
+        size_t start = endpoint.find(marker);
+        if (start != std::string::npos) {
+            start += marker.size();
+            return endpoint.substr(start, endpoint.find('/', start) - start);
+        }
+        HttpUrl url;
+        return HttpUrl::Parse(endpoint, url) ? url.HostKey() : endpoint;
+    }
+
+    UploadFormatLadder::Level ConfiguredUploadFormat() const {
+        return config.outputFormat == "flac" ? UploadFormatLadder::Level::Flac16k : UploadFormatLadder::Level::Wav16k;
+    }
+
+    // Encoding for the next chunk, from the send rate the workers measured
+    UploadFormatLadder::Level SelectUploadFormat() {
+        if (!formatLadder) {
+            return ConfiguredUploadFormat();
+        }
+        UploadFormatLadder::Level previous = formatLadder->GetLevel();
+        double bytesPerSecond = bandwidth.GetBytesPerSecond();
+        UploadFormatLadder::Level level = formatLadder->Select(bytesPerSecond, std::chrono::steady_clock::now());
+        if (level != previous) {
+            INFO_LOG("AzureOpenAI upload format " + std::string(UploadFormatLadder::LevelName(previous)) + " -> " +
+                     UploadFormatLadder::LevelName(level) + ": send rate " + std::to_string(bytesPerSecond / 1000.0) +
+                     " KB/s, " + UploadFormatLadder::LevelName(previous) + " needs " +
+                     std::to_string(formatLadder->GetBytesPerAudioSecond(previous) / 1000.0) + " KB per audio second");
+        }
+        return level;
+    }
+
+    void EnqueueReadySegments() {
+        const AudioFormat outputFormat = AudioConverter::GetOutputFormat();
+
+        UtteranceSegmenter::Segment segment;
+        while (segmenter->PopSegment(segment)) {
+            TRACE_SCOPE("CreateWavChunk");
+            uint32_t dataSize = static_cast<uint32_t>(segment.data.size() - WAV_HEADER_SIZE);
+            INFO_LOG("AzureOpenAI processing segment - samples " + std::to_string(segment.startSample) + "-" +
+                     std::to_string(segment.endSample) + " (" + std::to_string(dataSize) + " bytes), cut at " +
+                     UtteranceSegmenter::CutReasonName(segment.reason));
+
+            // Checked on the PCM, since a compressed chunk says nothing about its length
+            if (dataSize < MIN_UPLOAD_BYTES) {
+                DEBUG_LOG("AzureOpenAI - Insufficient audio data: " + std::to_string(dataSize) + " bytes (minimum " +
+                          std::to_string(MIN_UPLOAD_BYTES) + " bytes)");
+                continue;
+            }
+
+            // The header (or FLAC stream) is written in place, so the segment is uploaded without another copy
+            UploadFormatLadder::Level level = SelectUploadFormat();
+            uint32_t uploadRate = EncodeChunk(segment.data, level, outputFormat);
+            if (formatLadder) {
+                double audioSeconds = static_cast<double>(dataSize) / outputFormat.bytesPerSecond;
+                formatLadder->RecordEncoded(level, segment.data.size(), audioSeconds);
+            }
+
+            // Segments never span audio the voice gate skipped, so one offset places them
+            double startSeconds = skippedSeconds + static_cast<double>(segment.startSample) / outputFormat.sampleRate;
+            double endSeconds = skippedSeconds + static_cast<double>(segment.endSample) / outputFormat.sampleRate;
+
+            ChunkTrace trace;
+            trace.audioArrived = TakeArrivalTime(segment.startSample, segment.endSample);
+
+            // Hand the segment to the upload workers; this never waits on the network.
+            // Holding the lock keeps the result from being delivered before its times are recorded.
+            uint64_t sequence;
+            {
+                std::lock_guard<std::mutex> lock(timelineMutex);
+                sequence = uploadQueue->Enqueue(std::move(segment.data), uploadRate,
+                                                outputFormat.channels, outputFormat.bitsPerSample, trace);
+                segmentTimes[sequence] = std::make_pair(startSeconds, endSeconds);
+            }
+            DEBUG_LOG("AzureOpenAI queued chunk #" + std::to_string(sequence) + " for upload");
+        }
+    }
+
+    // When the packet holding startSample arrived; forgets packets that end
+    // before endSample, since later segments start after it
+    ChunkTrace::TimePoint TakeArrivalTime(uint64_t startSample, uint64_t endSample) {
+        ChunkTrace::TimePoint arrived;
+        for (const auto& packet : packetArrivals) {
+            if (packet.first > startSample) {
+                arrived = packet.second;
+                break;
+            }
+        }
+        while (!packetArrivals.empty() && packetArrivals.front().first <= endSample) {
+            packetArrivals.pop_front();
+        }
+        return arrived;
+    }
+
+    // Runs on an upload worker thread; the chunk already holds a complete audio file
+    std::string UploadChunk(UploadQueue::Chunk& chunk) {
+        DEBUG_LOG("Uploading chunk #" + std::to_string(chunk.sequence) + " - " + std::to_string(chunk.audio.size()) + " bytes");
+
+        // A result that arrives after the deadline is too late for a live
+        // transcript, so neither a slow request nor retries may run past it
+        auto audioTime = AudioTime(chunk);
+        auto deadline = audioTime + std::chrono::milliseconds(config.uploadDeadlineMs);
+        UploadOutcome outcome;
+        std::string text = SendToAzureOpenAI(chunk.audio, chunk.trace, chunk.cancel.get(), deadline, outcome);
+        // Uploads cut short by shutdown are kept too; a cancel by the user is not
+        if (outcome == UploadOutcome::Failed || outcome == UploadOutcome::Deferred ||
+            (outcome == UploadOutcome::Cancelled && stopping.load())) {
+            SpoolChunk(chunk, audioTime);
+        }
+        return text;
+    }
+
+    static ChunkTrace::TimePoint AudioTime(const UploadQueue::Chunk& chunk) {
+        return chunk.trace.audioArrived != ChunkTrace::TimePoint() ? chunk.trace.audioArrived : chunk.trace.enqueued;
+    }
+
+    // Keep a chunk the endpoint could not take for the drainer; its live
+    // slot is still delivered as a failure, in order
+    void SpoolChunk(const UploadQueue::Chunk& chunk, ChunkTrace::TimePoint audioTime) {
+        if (!spool) {
+            return;
+        }
+        UploadSpool::Record record{};
+        record.sequence = chunk.sequence;
+        record.sampleRate = chunk.sampleRate;
+        record.capturedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            (std::chrono::system_clock::now() - (std::chrono::steady_clock::now() - audioTime)).time_since_epoch()).count();
+        {
+            std::lock_guard<std::mutex> lock(timelineMutex);
+            auto it = segmentTimes.find(chunk.sequence);
+            if (it != segmentTimes.end()) {
+                record.startSeconds = it->second.first;
+                record.endSeconds = it->second.second;
+            }
+        }
+        if (!spool->Append(record, chunk.audio.data(), chunk.audio.size())) {
+            return;
+        }
+        INFO_LOG("AzureOpenAI spooled chunk #" + std::to_string(chunk.sequence) + " for a later upload (" +
+                 std::to_string(spool->GetStats().pending) + " waiting)");
+        {
+            std::lock_guard<std::mutex> lock(drainMutex);
+        }
+        drainCondition.notify_one();
+    }
+
+    void StartSpoolDrainer() {
+        StopSpoolDrainer();
+        spool.reset();
+        if (config.spoolPath.empty()) {
+            return;
+        }
+        auto opened = std::make_unique<UploadSpool>();
+        if (!opened->Open(config.spoolPath, static_cast<uint64_t>(std::max<uint32_t>(1, config.spoolMaxMB)) << 20)) {
+            WARN_LOG("AzureOpenAI - upload spool unavailable, failed chunks will be lost");
+            return;
+        }
+        spool = std::move(opened);
+        drainStopping = false;
+        drainCancel = std::make_unique<CancellationToken>();
+        spoolDrainer = std::thread(&AzureOpenAISpeechProvider::DrainSpool, this);
+    }
+
+    void StopSpoolDrainer() {
+        if (!spoolDrainer.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(drainMutex);
+            drainStopping = true;
+        }
+        drainCondition.notify_one();
+        drainCancel->Cancel();
+        spoolDrainer.join();
+
+        UploadSpool::Stats stats = spool->GetStats();
+        INFO_LOG("AzureOpenAI upload spool: " + std::to_string(stats.pending) + " chunks left for the next session, " +
+                 std::to_string(stats.appended) + " spooled, " + std::to_string(stats.dropped) + " dropped when full");
+    }
+
+    // Drainer thread: one spooled chunk at a time, oldest first
+    void DrainSpool() {
+        TimelineTrace::SetThreadName("Spool drainer");
+        UploadSpool::Record record;
+        std::vector<uint8_t> audio;
+        std::chrono::milliseconds backoff(0);
+
+        std::unique_lock<std::mutex> lock(drainMutex);
+        while (!drainStopping) {
+            if (backoff.count() > 0) {
+                drainCondition.wait_for(lock, backoff, [this] { return drainStopping; });
+            } else {
+                drainCondition.wait(lock, [this] { return drainStopping || spool->GetStats().pending > 0; });
+            }
+            if (drainStopping) {
+                break;
+            }
+
+            // Live chunks have the deadline; the spool waits until none is queued
+            if (uploadQueue && uploadQueue->GetStats().pending > 0) {
+                backoff = std::chrono::milliseconds(DRAIN_RETRY_MIN_MS);
+                continue;
+            }
+            if (!spool->PeekOldest(record, audio)) {
+                backoff = std::chrono::milliseconds(0);
+                continue;
+            }
+
+            lock.unlock();
+            bool drained = DrainRecord(record, audio);
+            lock.lock();
+            if (drained) {
+                backoff = std::chrono::milliseconds(0);
+            } else {
+                backoff = std::min(std::chrono::milliseconds(DRAIN_RETRY_MAX_MS),
+                                   std::max(std::chrono::milliseconds(DRAIN_RETRY_MIN_MS), backoff * 2));
+            }
+        }
+    }
+
+    // Upload one spooled chunk; false if the endpoint is still unavailable
+    bool DrainRecord(const UploadSpool::Record& record, const std::vector<uint8_t>& audio) {
+        ChunkTrace trace;
+        trace.enqueued = std::chrono::steady_clock::now();
+        int64_t startedMs = std::chrono::duration_cast<std::chrono::milliseconds>(trace.enqueued.time_since_epoch()).count();
+        auto deadline = trace.enqueued + std::chrono::milliseconds(config.uploadDeadlineMs);
+        UploadOutcome outcome;
+        std::string text = SendToAzureOpenAI(audio, trace, drainCancel.get(), deadline, outcome);
+
+        switch (outcome) {
+            case UploadOutcome::Transcribed:
+                spool->Remove(record.id);
+                DeliverSpooledTranscription(record, text);
+                return true;
+            case UploadOutcome::Rejected:
+                spool->Remove(record.id);
+                WARN_LOG("AzureOpenAI - spooled chunk #" + std::to_string(record.sequence) + " rejected, discarded");
+                return true;
+            case UploadOutcome::Failed:
+                // Only failures while other uploads succeed count against the chunk itself
+                if (lastTranscribedMs.load() > startedMs && spool->RecordAttempt(record.id) >= SPOOL_MAX_ATTEMPTS) {
+                    spool->Remove(record.id);
+                    WARN_LOG("AzureOpenAI - spooled chunk #" + std::to_string(record.sequence) + " failed " +
+                             std::to_string(SPOOL_MAX_ATTEMPTS) + " times, discarded");
+                    return true;
+                }
+                return false;
+            case UploadOutcome::Deferred:
+            case UploadOutcome::Cancelled:
+                return false;
+        }
+        return false;
+    }
+
+    // Results of spooled chunks arrive after the live ones around them. A
+    // chunk from an earlier run has no place on this session's timeline, and
+    // its sequence number belongs to that run, so it only goes to the
+    // recovered callback.
+    void DeliverSpooledTranscription(const UploadSpool::Record& record, const std::string& text) {
+        if (text.empty()) {
+            return;
+        }
+        int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        bool earlierSession = record.session != spool->GetSession();
+        INFO_LOG("AzureOpenAI spooled chunk #" + std::to_string(record.sequence) +
+                 (earlierSession ? " of session " + std::to_string(record.session) : std::string()) + " transcribed " +
+                 std::to_string((nowMs - record.capturedAtMs) / 1000) + " s after capture: '" + text + "'");
+
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        if (earlierSession) {
+            if (recoveredCallback) {
+                recoveredCallback(SpeechRecognition::RecoveredTranscript{
+                    record.capturedAtMs, std::max(0.0, record.endSeconds - record.startSeconds), text, 0.95});
+            }
+            return;
+        }
+        if (segmentCallback) {
+            segmentCallback(SpeechRecognition::TranscriptSegment{record.sequence, record.startSeconds, record.endSeconds,
+                                                                 text, 0.95, true});
+        }
+        if (callback) {
+            callback(text, 0.95);
+        }
+    }
+
+    // Called by the upload queue in capture order
+    void DeliverTranscription(uint64_t sequence, const std::string& text, const ChunkTrace& trace) {
+        std::pair<double, double> times(0.0, 0.0);
+        {
+            std::lock_guard<std::mutex> lock(timelineMutex);
+            auto it = segmentTimes.find(sequence);
+            if (it != segmentTimes.end()) {
+                times = it->second;
+                segmentTimes.erase(it);
+            }
+        }
+
+        if (text.empty()) {
+            WARN_LOG("AzureOpenAI - Empty transcription for chunk #" + std::to_string(sequence));
+        } else {
+            INFO_LOG("AzureOpenAI transcription #" + std::to_string(sequence) + " successful: '" + text + "'");
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            if (segmentCallback) {
+                segmentCallback(SpeechRecognition::TranscriptSegment{sequence, times.first, times.second, text, 0.95});
+            }
+            if (callback) {
+                callback(text, 0.95);
+                std::cout << "Azure OpenAI transcription: " << text << std::endl;
+            }
+        }
+
+        // Only chunks that produced text have a complete path to trace
+        if (latency && !text.empty()) {
+            ChunkTrace finished = trace;
+            finished.displayed = std::chrono::steady_clock::now();
+            latency->RecordChunk(finished);
+        }
+    }
+
+    // Turn the PCM behind the header space into the file uploaded at level,
+    // in place; returns the sample rate of the file
+    uint32_t EncodeChunk(std::vector<uint8_t>& chunk, UploadFormatLadder::Level level, const AudioFormat& format) {
+        AudioFormat fileFormat = format;
+        size_t frameBytes = format.channels * sizeof(int16_t);
+        size_t frames = (chunk.size() - WAV_HEADER_SIZE) / frameBytes;
+        const int16_t* samples = reinterpret_cast<const int16_t*>(chunk.data() + WAV_HEADER_SIZE);
+        FlacEncoder* encoder = flacEncoder.get();
+
+        if (level == UploadFormatLadder::Level::Flac8k) {
+            // Each chunk is filtered on its own: segments are not contiguous audio
+            TRACE_SCOPE("Downsample");
+            narrowbandResampler->Reset();
+            size_t maxFrames = narrowbandResampler->MaxOutputSamples(frames);
+            if (narrowbandSamples.size() < maxFrames) {
+                narrowbandSamples.resize(maxFrames);
+            }
+            frames = narrowbandResampler->Process(samples, frames, narrowbandSamples.data());
+            samples = narrowbandSamples.data();
+            fileFormat.sampleRate = UploadFormatLadder::SampleRate(level);
+            fileFormat.bytesPerSecond = static_cast<uint32_t>(fileFormat.sampleRate * frameBytes);
+            encoder = narrowbandEncoder.get();
+        }
+
+        if (UploadFormatLadder::IsFlac(level) && CompressToFlac(chunk, *encoder, samples, frames)) {
+            return fileFormat.sampleRate;
+        }
+        uint32_t dataSize = static_cast<uint32_t>(frames * frameBytes);
+        if (samples != reinterpret_cast<const int16_t*>(chunk.data() + WAV_HEADER_SIZE)) {
+            memcpy(chunk.data() + WAV_HEADER_SIZE, samples, dataSize);
+            chunk.resize(WAV_HEADER_SIZE + dataSize);
+        }
+        WriteWavHeader(chunk.data(), dataSize, fileFormat);
+        return fileFormat.sampleRate;
+    }
+
+    // Replace the chunk with a FLAC stream of samples; false leaves it alone,
+    // for the rare block that does not compress
+    bool CompressToFlac(std::vector<uint8_t>& chunk, FlacEncoder& encoder, const int16_t* samples, size_t frames) {
+        TRACE_SCOPE("EncodeFlac");
+        size_t maxSize = encoder.MaxEncodedSize(frames);
+        if (flacBuffer.size() < maxSize) {
+            flacBuffer.resize(maxSize);
+        }
+
+        size_t encoded = encoder.Encode(samples, frames, flacBuffer.data(), flacBuffer.size());
+        if (encoded == 0 || encoded > chunk.size()) {
+            DEBUG_LOG("AzureOpenAI - FLAC did not shrink a " + std::to_string(chunk.size()) + " byte chunk, sending WAV");
+            return false;
+        }
+
+        DEBUG_LOG("AzureOpenAI - FLAC encoded " + std::to_string(chunk.size()) + " bytes to " + std::to_string(encoded));
+        memcpy(chunk.data(), flacBuffer.data(), encoded);
+        chunk.resize(encoded);
+        return true;
+    }
+
+    // Fill the 44-byte PCM WAV header at the front of a chunk
+    static void WriteWavHeader(uint8_t* header, uint32_t dataSize, const AudioFormat& format) {
         uint32_t fileSize = dataSize + 36;
         uint16_t channels = format.channels;
         uint32_t sampleRate = format.sampleRate;
         uint16_t bitsPerSample = format.bitsPerSample;
         uint32_t byteRate = sampleRate * channels * (bitsPerSample / 8);
         uint16_t blockAlign = channels * (bitsPerSample / 8);
+        uint32_t fmtSize = 16;
+        uint16_t audioFormat = 1; // PCM
         
         // RIFF header
-        wavFile.insert(wavFile.end(), {'R', 'I', 'F', 'F'});
-        wavFile.insert(wavFile.end(), (BYTE*)&fileSize, (BYTE*)&fileSize + 4);
-        wavFile.insert(wavFile.end(), {'W', 'A', 'V', 'E'});
+        memcpy(header, "RIFF", 4);
+        memcpy(header + 4, &fileSize, 4);
+        memcpy(header + 8, "WAVE", 4);
         
         // fmt chunk
-        wavFile.insert(wavFile.end(), {'f', 'm', 't', ' '});
-        uint32_t fmtSize = 16;
-        wavFile.insert(wavFile.end(), (BYTE*)&fmtSize, (BYTE*)&fmtSize + 4);
-        uint16_t audioFormat = 1; // PCM
-        wavFile.insert(wavFile.end(), (BYTE*)&audioFormat, (BYTE*)&audioFormat + 2);
-        wavFile.insert(wavFile.end(), (BYTE*)&channels, (BYTE*)&channels + 2);
-        wavFile.insert(wavFile.end(), (BYTE*)&sampleRate, (BYTE*)&sampleRate + 4);
-        wavFile.insert(wavFile.end(), (BYTE*)&byteRate, (BYTE*)&byteRate + 4);
-        wavFile.insert(wavFile.end(), (BYTE*)&blockAlign, (BYTE*)&blockAlign + 2);
-        wavFile.insert(wavFile.end(), (BYTE*)&bitsPerSample, (BYTE*)&bitsPerSample + 2);
+        memcpy(header + 12, "fmt ", 4);
+        memcpy(header + 16, &fmtSize, 4);
+        memcpy(header + 20, &audioFormat, 2);
+        memcpy(header + 22, &channels, 2);
+        memcpy(header + 24, &sampleRate, 4);
+        memcpy(header + 28, &byteRate, 4);
+        memcpy(header + 32, &blockAlign, 2);
+        memcpy(header + 34, &bitsPerSample, 2);
         
         // data chunk
-        wavFile.insert(wavFile.end(), {'d', 'a', 't', 'a'});
-        wavFile.insert(wavFile.end(), (BYTE*)&dataSize, (BYTE*)&dataSize + 4);
-        wavFile.insert(wavFile.end(), audioData.begin(), audioData.end());
-        
-        return wavFile;
+        memcpy(header + 36, "data", 4);
+        memcpy(header + 40, &dataSize, 4);
     }
     
-    std::string SendToAzureOpenAI(const std::vector<BYTE>& wavData) {
-        // Check if we have sufficient audio data (at least 0.5 seconds of audio for real-time)
-        // With optimized format: 16kHz * 1 channel * 2 bytes per sample * 0.5 seconds = 16,000 bytes
-        if (wavData.size() < 16000) {
-            DEBUG_LOG("AzureOpenAI - Insufficient audio data: " + std::to_string(wavData.size()) + " bytes (minimum 16,000 bytes)");
-            return ""; // Not enough audio data yet, no transcription
-        }
-        
+    std::string SendToAzureOpenAI(const std::vector<uint8_t>& wavData, ChunkTrace& trace, CancellationToken* cancel,
+                                  ChunkTrace::TimePoint deadline, UploadOutcome& outcome) {
         INFO_LOG("AzureOpenAI - Processing " + std::to_string(wavData.size()) + " bytes of audio for transcription");
         
         try {
-            return SendAudioToAzureOpenAI(wavData);
+            return SendAudioToAzureOpenAI(wavData, trace, cancel, deadline, outcome);
         }
         catch (const std::exception& e) {
             ERROR_LOG("AzureOpenAI HTTP request failed: " + std::string(e.what()));
+            outcome = UploadOutcome::Failed;
             return "";
         }
     }
     
 private:
-    std::string SendAudioToAzureOpenAI(const std::vector<BYTE>& wavData) {
-        // Parse the endpoint URL
-        std::wstring url = std::wstring(config.endpoint.begin(), config.endpoint.end());
-        
-        // Initialize WinHTTP
-        HINTERNET hSession = WinHttpOpen(L"TeamsTranscriptionApp/1.0",
-                                       WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                                       WINHTTP_NO_PROXY_NAME,
-                                       WINHTTP_NO_PROXY_BYPASS,
-                                       0);
-        if (!hSession) {
-            throw std::runtime_error("Failed to initialize WinHTTP session");
-        }
-        
-        // Parse URL components
-        URL_COMPONENTS urlComp = {};
-        urlComp.dwStructSize = sizeof(urlComp);
-        wchar_t hostName[256];
-        wchar_t urlPath[1024];
-        urlComp.lpszHostName = hostName;
-        urlComp.dwHostNameLength = sizeof(hostName) / sizeof(wchar_t);
-        urlComp.lpszUrlPath = urlPath;
-        urlComp.dwUrlPathLength = sizeof(urlPath) / sizeof(wchar_t);
-        
-        if (!WinHttpCrackUrl(url.c_str(), 0, 0, &urlComp)) {
-            WinHttpCloseHandle(hSession);
-            throw std::runtime_error("Failed to parse Azure OpenAI URL");
-        }
-        
-        // Connect to server
-        HINTERNET hConnect = WinHttpConnect(hSession, urlComp.lpszHostName, urlComp.nPort, 0);
-        if (!hConnect) {
-            WinHttpCloseHandle(hSession);
-            throw std::runtime_error("Failed to connect to Azure OpenAI server");
-        }
-        
-        // Create request
-        DWORD flags = (urlComp.nScheme == INTERNET_SCHEME_HTTPS) ? WINHTTP_FLAG_SECURE : 0;
-        HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST", urlComp.lpszUrlPath,
-                                              NULL, WINHTTP_NO_REFERER,
-                                              WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
-        if (!hRequest) {
-            WinHttpCloseHandle(hConnect);
-            WinHttpCloseHandle(hSession);
-            throw std::runtime_error("Failed to create HTTP request");
-        }
-        
-        // Prepare multipart form data
-        std::string boundary = "----WebKitFormBoundary" + std::to_string(GetTickCount64());
-        std::string contentType = "multipart/form-data; boundary=" + boundary;
-        std::wstring contentTypeW = std::wstring(contentType.begin(), contentType.end());
-        
-        // Set headers
-        std::wstring apiKey = std::wstring(config.apiKey.begin(), config.apiKey.end());
-        std::wstring authHeader = L"api-key: " + apiKey;
-        
-        if (!WinHttpAddRequestHeaders(hRequest, authHeader.c_str(), -1, WINHTTP_ADDREQ_FLAG_ADD) ||
-            !WinHttpAddRequestHeaders(hRequest, contentTypeW.c_str(), -1, WINHTTP_ADDREQ_FLAG_ADD | WINHTTP_ADDREQ_FLAG_REPLACE)) {
-            WinHttpCloseHandle(hRequest);
-            WinHttpCloseHandle(hConnect);
-            WinHttpCloseHandle(hSession);
-            throw std::runtime_error("Failed to set HTTP headers");
-        }
-        
-        // Build multipart body
-        std::vector<BYTE> requestBody = BuildMultipartBody(wavData, boundary);
-        
-        // Send request
-        if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                              requestBody.data(), requestBody.size(),
-                              requestBody.size(), 0)) {
-            WinHttpCloseHandle(hRequest);
-            WinHttpCloseHandle(hConnect);
-            WinHttpCloseHandle(hSession);
-            throw std::runtime_error("Failed to send HTTP request");
-        }
-        
-        // Receive response
-        if (!WinHttpReceiveResponse(hRequest, NULL)) {
-            WinHttpCloseHandle(hRequest);
-            WinHttpCloseHandle(hConnect);
-            WinHttpCloseHandle(hSession);
-            throw std::runtime_error("Failed to receive HTTP response");
-        }
-        
-        // Get status code
-        DWORD statusCode = 0;
-        DWORD statusCodeSize = sizeof(statusCode);
-        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-                          NULL, &statusCode, &statusCodeSize, NULL);
-        
-        // Read response body
-        std::string responseData;
-        DWORD bytesAvailable = 0;
-        while (WinHttpQueryDataAvailable(hRequest, &bytesAvailable) && bytesAvailable > 0) {
-            std::vector<char> buffer(bytesAvailable + 1);
-            DWORD bytesRead = 0;
-            if (WinHttpReadData(hRequest, buffer.data(), bytesAvailable, &bytesRead)) {
-                buffer[bytesRead] = '\0';
-                responseData.append(buffer.data(), bytesRead);
+    std::string SendAudioToAzureOpenAI(const std::vector<uint8_t>& wavData, ChunkTrace& trace, CancellationToken* cancel,
+                                       ChunkTrace::TimePoint deadline, UploadOutcome& outcome) {
+        TRACE_SCOPE("SendAudioToAzureOpenAI");
+        // The WAV or FLAC file is sent from the chunk itself, between the session's multipart framing
+        // The URL and key are set per attempt, for the deployment it goes to
+        HttpRequest request;
+        request.method = "POST";
+        request.headers.emplace_back("api-key", "");
+        request.headers.emplace_back("Content-Type", multipartContentType);
+        const std::string& prefix = wavData.size() >= 4 && memcmp(wavData.data(), "fLaC", 4) == 0 ? multipartFlacPrefix : multipartPrefix;
+        request.body.emplace_back(prefix.data(), prefix.size());
+        request.body.emplace_back(wavData.data(), wavData.size());
+        request.body.emplace_back(multipartTrailer.data(), multipartTrailer.size());
+
+        request.connectTimeout = std::chrono::milliseconds(config.connectTimeoutMs);
+        request.sendTimeout = std::chrono::milliseconds(config.sendTimeoutMs);
+        request.receiveTimeout = std::chrono::milliseconds(config.receiveTimeoutMs);
+        request.deadline = deadline;
+        request.cancel = cancel;
+        retryBudget.RecordRequest();
+
+        for (uint32_t attempt = 1; ; ++attempt) {
+            // A Retry-After seen by any worker holds every chunk back from that
+            // deployment; only when all of them are throttled does the chunk wait
+            int target;
+            ChunkTrace::TimePoint availableAt;
+            while ((target = router->Acquire(availableAt)) < 0) {
+                if (availableAt == ChunkTrace::TimePoint::max()) {
+                    LOG_RATE_LIMITED(Warn, 5, 10000, "AzureOpenAI - every deployment's circuit is open, chunk not sent");
+                    outcome = UploadOutcome::Deferred;
+                    return "";
+                }
+                if (availableAt > deadline) {
+                    ERROR_LOG("Azure OpenAI upload abandoned: the endpoint is throttling past the chunk's deadline");
+                    outcome = UploadOutcome::Deferred;
+                    return "";
+                }
+                auto now = std::chrono::steady_clock::now();
+                if (!WaitBeforeRetry(std::chrono::duration_cast<std::chrono::milliseconds>(availableAt - now), cancel)) {
+                    outcome = UploadOutcome::Cancelled;
+                    return "";
+                }
+            }
+            auto attemptStarted = std::chrono::steady_clock::now();
+            if (attemptStarted >= deadline) {
+                router->Complete(target, DeploymentRouter::Result::Abandoned, std::chrono::steady_clock::duration(), 0);
+                ERROR_LOG("Azure OpenAI upload abandoned: the chunk's deadline passed before it could be sent");
+                outcome = UploadOutcome::Deferred;
+                return "";
+            }
+            const DeploymentRouter::Target& deployment = router->GetTarget(target);
+            request.url = deployment.url;
+            request.headers[0].second = deployment.apiKey;
+
+            // The client keeps the session and connection open between chunks
+            HttpResponse response;
+            std::string failure;
+            std::chrono::milliseconds retryAfter(-1);
+            try {
+                TRACE_SCOPE("HttpSend");
+                response = httpClient->Send(request);
+            }
+            catch (const std::exception& e) {
+                failure = "HTTP request failed: " + std::string(e.what());
+            }
+            auto elapsed = std::chrono::steady_clock::now() - attemptStarted;
+            if (cancel && cancel->IsCancelled()) {
+                // Abandoned by us, which says nothing about the endpoint
+                router->Complete(target, DeploymentRouter::Result::Abandoned, elapsed, 0);
+                INFO_LOG("Azure OpenAI upload cancelled");
+                outcome = UploadOutcome::Cancelled;
+                return "";
+            }
+
+            if (failure.empty()) {
+                // The body went out whatever the status, so every answer times the link
+                if (response.sentAt != ChunkTrace::TimePoint()) {
+                    auto sending = response.sentAt - response.sendStartedAt;
+                    bandwidth.RecordSend(request.BodySize(), sending);
+                    DEBUG_LOG("AzureOpenAI - Sent " + std::to_string(request.BodySize()) + " bytes in " +
+                              std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(sending).count()) +
+                              " ms, estimated send rate " + std::to_string(bandwidth.GetBytesPerSecond() / 1000.0) + " KB/s");
+                }
+                trace.firstByte = response.firstByteAt;
+                trace.received = std::chrono::steady_clock::now();
+
+                if (response.statusCode == 200) {
+                    router->Complete(target, DeploymentRouter::Result::Success, elapsed, request.BodySize());
+                    lastTranscribedMs.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+                    INFO_LOG("Azure OpenAI response: " + response.body);
+                    std::string text = ParseTranscriptionResponse(response.body);
+                    trace.parsed = std::chrono::steady_clock::now();
+                    outcome = UploadOutcome::Transcribed;
+                    return text;
+                }
+
+                failure = "status code " + std::to_string(response.statusCode) + ", response: " + response.body;
+                if (!RetryPolicy::IsRetryableStatus(response.statusCode)) {
+                    // The endpoint answered; the request itself is wrong and would fail again
+                    router->Complete(target, DeploymentRouter::Result::Rejected, elapsed, request.BodySize());
+                    ERROR_LOG("Azure OpenAI API returned " + failure);
+                    outcome = UploadOutcome::Rejected;
+                    return "";
+                }
+                retryAfter = RetryPolicy::RetryAfter(response);
+            }
+            // A network error leaves the status 0
+            router->Complete(target, response.statusCode == 429 ? DeploymentRouter::Result::Throttled : DeploymentRouter::Result::Failed,
+                             elapsed, response.statusCode != 0 ? request.BodySize() : 0, retryAfter);
+            failure += " from " + deployment.name;
+
+            // With other deployments to try, the router holds this one off and the retry need not wait as long
+            std::chrono::milliseconds delay = retryPolicy.NextDelay(attempt, router->GetCount() > 1 ? std::chrono::milliseconds(-1) : retryAfter);
+            std::string reason;
+            if (attempt >= retryPolicy.GetMaxAttempts()) {
+                reason = "no attempts left";
+            } else if (std::chrono::steady_clock::now() + delay > deadline) {
+                reason = "a retry in " + std::to_string(delay.count()) + " ms would pass the deadline";
+            } else if (!retryBudget.TryRetry()) {
+                reason = "retry budget exhausted";
+            }
+            if (!reason.empty()) {
+                ERROR_LOG("Azure OpenAI upload failed after " + std::to_string(attempt) + " attempts (" + failure + "), " + reason);
+                outcome = UploadOutcome::Failed;
+                return "";
+            }
+
+            WARN_LOG("Azure OpenAI attempt " + std::to_string(attempt) + " failed (" + failure + "), retrying in " +
+                     std::to_string(delay.count()) + " ms");
+            if (!WaitBeforeRetry(delay, cancel)) {
+                outcome = UploadOutcome::Cancelled;
+                return "";
             }
         }
-        
-        // Cleanup
-        WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        
-        // Parse response
-        if (statusCode != 200) {
-            ERROR_LOG("Azure OpenAI API returned status code: " + std::to_string(statusCode) + ", response: " + responseData);
-            return "";
+    }
+
+    // False if the upload was cancelled while waiting
+    bool WaitBeforeRetry(std::chrono::milliseconds delay, CancellationToken* cancel) {
+        TRACE_SCOPE("RetryBackoff");
+        if (!cancel) {
+            std::this_thread::sleep_for(delay);
+            return true;
         }
-        
-        INFO_LOG("Azure OpenAI response: " + responseData);
-        return ParseTranscriptionResponse(responseData);
+        if (!cancel->WaitFor(delay)) {
+            INFO_LOG("Azure OpenAI upload cancelled while waiting to retry");
+            return false;
+        }
+        return true;
     }
     
-    std::vector<BYTE> BuildMultipartBody(const std::vector<BYTE>& wavData, const std::string& boundary) {
-        std::vector<BYTE> body;
-        
-        // Add file part
-        std::string fileHeader = "--" + boundary + "\r\n";
-        fileHeader += "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n";
-        fileHeader += "Content-Type: audio/wav\r\n\r\n";
-        
-        body.insert(body.end(), fileHeader.begin(), fileHeader.end());
-        body.insert(body.end(), wavData.begin(), wavData.end());
-        
-        // Add model parameter
-        std::string modelParam = "\r\n--" + boundary + "\r\n";
-        modelParam += "Content-Disposition: form-data; name=\"model\"\r\n\r\n";
-        modelParam += "whisper-1\r\n";
-        
-        body.insert(body.end(), modelParam.begin(), modelParam.end());
-        
-        // Add language parameter
-        std::string langParam = "--" + boundary + "\r\n";
-        langParam += "Content-Disposition: form-data; name=\"language\"\r\n\r\n";
-        langParam += "en\r\n";
-        
-        body.insert(body.end(), langParam.begin(), langParam.end());
-        
-        // Add response format parameter
-        std::string formatParam = "--" + boundary + "\r\n";
-        formatParam += "Content-Disposition: form-data; name=\"response_format\"\r\n\r\n";
-        formatParam += "json\r\n";
-        
-        body.insert(body.end(), formatParam.begin(), formatParam.end());
-        
+    // Everything in the form except the file contents; the boundary only has
+    // to be absent from the audio, which a random one is in practice
+    void BuildMultipartFraming() {
+        std::string boundary = "----WebKitFormBoundary" + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        multipartContentType = "multipart/form-data; boundary=" + boundary;
+
+        // File part header
+        multipartPrefix = "--" + boundary + "\r\n";
+        multipartFlacPrefix = multipartPrefix;
+        multipartPrefix += "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n";
+        multipartPrefix += "Content-Type: audio/wav\r\n\r\n";
+        multipartFlacPrefix += "Content-Disposition: form-data; name=\"file\"; filename=\"audio.flac\"\r\n";
+        multipartFlacPrefix += "Content-Type: audio/flac\r\n\r\n";
+
+        // Model parameter
+        multipartTrailer = "\r\n--" + boundary + "\r\n";
+        multipartTrailer += "Content-Disposition: form-data; name=\"model\"\r\n\r\n";
+        multipartTrailer += "whisper-1\r\n";
+
+        // Language parameter
+        multipartTrailer += "--" + boundary + "\r\n";
+        multipartTrailer += "Content-Disposition: form-data; name=\"language\"\r\n\r\n";
+        multipartTrailer += "en\r\n";
+
+        // Response format parameter
+        multipartTrailer += "--" + boundary + "\r\n";
+        multipartTrailer += "Content-Disposition: form-data; name=\"response_format\"\r\n\r\n";
+        multipartTrailer += "json\r\n";
+
         // Close boundary
-        std::string endBoundary = "--" + boundary + "--\r\n";
-        body.insert(body.end(), endBoundary.begin(), endBoundary.end());
-        
-        return body;
+        multipartTrailer += "--" + boundary + "--\r\n";
     }
     
     std::string ParseTranscriptionResponse(const std::string& jsonResponse) {
@@ -609,7 +1321,7 @@ class WindowsSpeechProvider : public SpeechRecognition::ISpeechProvider {
 private:
     bool initialized;
     SpeechRecognition::TranscriptionCallback callback;
-    std::vector<BYTE> audioBuffer;
+    std::vector<uint8_t> audioBuffer;
     static int transcriptionCounter;
 
 public:
@@ -621,7 +1333,7 @@ public:
         return true;
     }
 
-    void ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) override {
+    void ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format) override {
         if (!initialized || !callback) {
             WARN_LOG("WindowsSpeechProvider::ProcessAudioData - Not initialized (" + std::string(initialized ? "true" : "false") + ") or no callback (" + std::string(callback ? "set" : "null") + ")");
             return;
@@ -672,6 +1384,11 @@ int WindowsSpeechProvider::transcriptionCounter = 0;
 // SpeechRecognition Implementation
 SpeechRecognition::SpeechRecognition()
     : initialized(false)
+    , preRollStart(0)
+    , preRollSize(0)
+    , preRollFormat()
+    , skippedFramesInChunk(0)
+    , vadStats()
 {
 }
 
@@ -680,7 +1397,22 @@ SpeechRecognition::~SpeechRecognition() = default;
 bool SpeechRecognition::Initialize(const SpeechConfig& config) {
     currentConfig = config;
     INFO_LOG("SpeechRecognition::Initialize - Provider: " + std::to_string((int)config.provider) + 
-             ", Endpoint: " + config.endpoint + ", API Key: " + (config.apiKey.empty() ? "EMPTY" : "SET"));
+             ", Endpoint: " + config.endpoint + ", API Key: " + (config.apiKey.empty() ? "EMPTY" : "SET") +
+             ", VAD: " + (config.enableVoiceActivityDetection ? "on" : "off"));
+
+    if (config.enableVoiceActivityDetection) {
+        voiceDetector = std::make_unique<VoiceActivityDetector>();
+    } else {
+        voiceDetector.reset();
+    }
+    preRollSize = 0;
+    skippedFramesInChunk = 0;
+    {
+        std::lock_guard<std::mutex> lock(vadStatsMutex);
+        vadStats = VadStats();
+        vadStats.enabled = config.enableVoiceActivityDetection;
+    }
+
     return InitializeProvider();
 }
 
@@ -737,6 +1469,15 @@ bool SpeechRecognition::InitializeProvider() {
         } else {
             WARN_LOG("No transcription callback available when initializing " + providerName + " provider");
         }
+        if (segmentCallback) {
+            speechProvider->SetSegmentCallback(segmentCallback);
+        }
+        if (recoveredCallback) {
+            speechProvider->SetRecoveredCallback(recoveredCallback);
+        }
+        if (latency) {
+            speechProvider->SetLatencyTracker(latency);
+        }
 
         initialized = speechProvider->IsInitialized();
         INFO_LOG(providerName + " speech provider initialization " + (initialized ? "SUCCESS" : "FAILED"));
@@ -750,18 +1491,41 @@ bool SpeechRecognition::InitializeProvider() {
     }
 }
 
-void SpeechRecognition::ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format) {
+void SpeechRecognition::ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format) {
+    TRACE_SCOPE("RecognizeAudio");
     if (!initialized || !speechProvider) {
-        static int warnCount = 0;
-        if (++warnCount <= 5) { // Only warn first 5 times to avoid spam
-            WARN_LOG("SpeechRecognition::ProcessAudioData - Not initialized (" + std::string(initialized ? "true" : "false") + ") or no provider (" + std::string(speechProvider ? "set" : "null") + ")");
-        }
+        LOG_RATE_LIMITED(Warn, 5, 10000, "SpeechRecognition::ProcessAudioData - Not initialized (" + std::string(initialized ? "true" : "false") + ") or no provider (" + std::string(speechProvider ? "set" : "null") + ")");
         return;
     }
 
     try {
-        DEBUG_LOG("SpeechRecognition forwarding " + std::to_string(audioData.size()) + " bytes to provider");
-        speechProvider->ProcessAudioData(audioData, format);
+        if (!voiceDetector) {
+            DEBUG_LOG("SpeechRecognition forwarding " + std::to_string(audioData.size()) + " bytes to provider");
+            speechProvider->ProcessAudioData(audioData, format);
+            return;
+        }
+
+        // Only audio with speech (plus a short pre-roll and hangover) reaches the provider
+        bool wasActive = voiceDetector->IsSpeechActive();
+        bool speech = voiceDetector->Process(audioData.data(), audioData.size(),
+                                             format.sampleRate, format.channels, format.bitsPerSample);
+        if (speech) {
+            if (!wasActive) {
+                INFO_LOG("VAD - speech started, forwarding " + std::to_string(PRE_ROLL_MS) + "ms pre-roll");
+                ForwardPreRoll(format);
+            }
+            DEBUG_LOG("SpeechRecognition forwarding " + std::to_string(audioData.size()) + " bytes to provider");
+            speechProvider->ProcessAudioData(audioData, format);
+
+            // Speech ended inside this packet: send the tail instead of waiting for a full chunk
+            if (!voiceDetector->IsSpeechActive()) {
+                INFO_LOG("VAD - speech ended, flushing provider");
+                speechProvider->Flush();
+            }
+        } else {
+            StorePreRoll(audioData, format);
+        }
+        RecordVadDecision(speech, audioData.size(), format);
     }
     catch (const std::exception& e) {
         ERROR_LOG("Exception processing audio data: " + std::string(e.what()));
@@ -769,6 +1533,151 @@ void SpeechRecognition::ProcessAudioData(const std::vector<BYTE>& audioData, con
     }
 }
 
+void SpeechRecognition::Flush() {
+    if (speechProvider) {
+        speechProvider->Flush();
+    }
+
+    // The next recording starts with a fresh noise estimate and no pre-roll
+    if (voiceDetector) {
+        voiceDetector->Reset();
+    }
+    if (preRollSize > 0) {
+        SkipAudio(preRollSize, preRollFormat);
+    }
+    preRollSize = 0;
+}
+
+void SpeechRecognition::WaitForUploads(size_t maxOutstanding) {
+    if (speechProvider) {
+        speechProvider->WaitForUploads(maxOutstanding);
+    }
+}
+
+void SpeechRecognition::CancelUploads() {
+    if (speechProvider) {
+        speechProvider->CancelUploads();
+    }
+}
+
+void SpeechRecognition::SetSegmentCallback(SegmentCallback callback) {
+    segmentCallback = callback;
+    if (speechProvider) {
+        speechProvider->SetSegmentCallback(callback);
+    }
+}
+
+void SpeechRecognition::SetRecoveredCallback(RecoveredCallback callback) {
+    recoveredCallback = callback;
+    if (speechProvider) {
+        speechProvider->SetRecoveredCallback(callback);
+    }
+}
+
+void SpeechRecognition::SetLatencyTracker(std::shared_ptr<PipelineLatency> tracker) {
+    latency = tracker;
+    if (speechProvider) {
+        speechProvider->SetLatencyTracker(tracker);
+    }
+}
+
+void SpeechRecognition::SkipAudio(size_t bytes, const AudioFormat& format) {
+    if (speechProvider && bytes > 0) {
+        speechProvider->SkipAudio(bytes, format);
+    }
+}
+
+SpeechRecognition::VadStats SpeechRecognition::GetVadStats() const {
+    std::lock_guard<std::mutex> lock(vadStatsMutex);
+    return vadStats;
+}
+
+std::vector<SpeechRecognition::DeploymentStats> SpeechRecognition::GetDeploymentStats() const {
+    return speechProvider ? speechProvider->GetDeploymentStats() : std::vector<DeploymentStats>();
+}
+
+void SpeechRecognition::RecordVadDecision(bool forwarded, size_t bytes, const AudioFormat& format) {
+    size_t frameBytes = static_cast<size_t>(format.channels) * (format.bitsPerSample / 8);
+    VoiceActivityDetector::Stats detector = voiceDetector->GetStats();
+
+    std::lock_guard<std::mutex> lock(vadStatsMutex);
+    vadStats.speechActive = voiceDetector->IsSpeechActive();
+    vadStats.speechFrames = detector.speechFrames;
+    vadStats.silenceFrames = detector.silenceFrames;
+    vadStats.speechSegments = detector.speechSegments;
+
+    if (forwarded) {
+        vadStats.packetsForwarded++;
+        return;
+    }
+
+    vadStats.packetsSkipped++;
+    if (frameBytes > 0) {
+        skippedFramesInChunk += bytes / frameBytes;
+        uint64_t chunkFrames = static_cast<uint64_t>(format.sampleRate) * SKIPPED_CHUNK_SECONDS;
+        while (chunkFrames > 0 && skippedFramesInChunk >= chunkFrames) {
+            skippedFramesInChunk -= chunkFrames;
+            vadStats.chunksSkipped++;
+        }
+    }
+}
+
+// Keep the last PRE_ROLL_MS of skipped audio so the onset of speech, which the
+// detector only confirms a few frames late, is not clipped
+void SpeechRecognition::StorePreRoll(const std::vector<uint8_t>& audioData, const AudioFormat& format) {
+    size_t frameBytes = static_cast<size_t>(format.channels) * (format.bitsPerSample / 8);
+    size_t capacity = static_cast<size_t>(format.sampleRate) * PRE_ROLL_MS / 1000 * frameBytes;
+    if (capacity == 0) {
+        return;
+    }
+    if (preRoll.size() != capacity) {
+        SkipAudio(preRollSize, preRollFormat);
+        preRoll.assign(capacity, 0);
+        preRollStart = 0;
+        preRollSize = 0;
+    }
+
+    preRollFormat = format;
+
+    // Whatever falls out of the ring is never forwarded
+    const uint8_t* data = audioData.data();
+    size_t bytes = audioData.size();
+    if (bytes > capacity) {
+        SkipAudio(bytes - capacity, format);
+        data += bytes - capacity;
+        bytes = capacity;
+    }
+
+    // Append at the end of the ring, overwriting the oldest bytes
+    size_t writePos = (preRollStart + preRollSize) % capacity;
+    size_t firstPart = std::min(bytes, capacity - writePos);
+    memcpy(preRoll.data() + writePos, data, firstPart);
+    memcpy(preRoll.data(), data + firstPart, bytes - firstPart);
+
+    size_t newSize = preRollSize + bytes;
+    if (newSize > capacity) {
+        SkipAudio(newSize - capacity, format);
+        preRollStart = (preRollStart + newSize - capacity) % capacity;
+        newSize = capacity;
+    }
+    preRollSize = newSize;
+}
+
+void SpeechRecognition::ForwardPreRoll(const AudioFormat& format) {
+    if (preRollSize == 0) {
+        return;
+    }
+
+    std::vector<uint8_t> audio(preRollSize);
+    size_t firstPart = std::min(preRollSize, preRoll.size() - preRollStart);
+    memcpy(audio.data(), preRoll.data() + preRollStart, firstPart);
+    memcpy(audio.data() + firstPart, preRoll.data(), preRollSize - firstPart);
+    preRollStart = 0;
+    preRollSize = 0;
+
+    speechProvider->ProcessAudioData(audio, format);
+}
+
 void SpeechRecognition::SetTranscriptionCallback(TranscriptionCallback callback) {
     transcriptionCallback = callback;
     INFO_LOG("SpeechRecognition::SetTranscriptionCallback called");
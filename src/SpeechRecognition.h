@@ -1,30 +1,53 @@
 ﻿#pragma once
 
-#include "AudioCapture.h"
+#include "AudioFormat.h"
+#include "DeploymentRouter.h"
+#include "PipelineLatency.h"
+#include "Resampler.h"
+#include "VoiceActivityDetector.h"
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
-// Audio conversion utilities
+// Audio conversion utilities. Holds resampler state between calls, so use one
+// converter per audio stream.
 class AudioConverter {
 public:
+    // Format produced for Azure OpenAI: 16 kHz mono 16-bit PCM
+    static AudioFormat GetOutputFormat();
+
+    // Upper bound on the samples ConvertInto writes for inputBytes of input
+    size_t MaxOutputSamples(size_t inputBytes, const AudioFormat& inputFormat) const;
+
+    // Downmix, resample and convert to 16-bit in one pass, writing straight into
+    // output. Accepts 32-bit float or 16-bit PCM input with any channel count.
+    // Returns the number of samples written; never allocates once the
+    // resampler for the input rate exists.
+    size_t ConvertInto(const uint8_t* input, size_t inputBytes, const AudioFormat& inputFormat,
+                       int16_t* output, size_t outputCapacity);
+
     // Convert audio format for optimal Azure OpenAI processing
-    static std::vector<BYTE> ConvertAudioFormat(
-        const std::vector<BYTE>& inputData,
-        const AudioCapture::AudioFormat& inputFormat,
-        AudioCapture::AudioFormat& outputFormat
+    std::vector<uint8_t> ConvertAudioFormat(
+        const std::vector<uint8_t>& inputData,
+        const AudioFormat& inputFormat,
+        AudioFormat& outputFormat
     );
+
+    // Drop filter history, e.g. when a new recording starts
+    void Reset();
     
 private:
-    // Convert 32-bit float to 16-bit PCM
-    static std::vector<int16_t> ConvertFloatToPCM16(const float* floatData, size_t sampleCount);
-    
-    // Downsample audio data
-    static std::vector<int16_t> Downsample(const std::vector<int16_t>& input, int inputRate, int outputRate, int channels);
-    
-    // Convert stereo to mono
-    static std::vector<int16_t> StereoToMono(const std::vector<int16_t>& stereoData);
+    std::unique_ptr<PolyphaseResampler> resampler;
+
+    // Fused stage for one input layout; Channels == 0 reads the count at runtime
+    template <typename Sample, int Channels>
+    size_t ConvertFrames(const Sample* input, size_t frameCount, int channels, uint32_t inputRate, int16_t* output);
+
+    // Float stereo at the output rate: SIMD downmix, rounded once like the other paths
+    static size_t ConvertStereoFloatDirect(const float* input, size_t frameCount, int16_t* output);
 };
 
 class SpeechRecognition {
@@ -38,6 +61,14 @@ public:
         Windows
     };
 
+    // One Azure OpenAI deployment uploads can be routed to
+    struct DeploymentConfig {
+        std::string name;       // For logs and stats; taken from the endpoint if empty
+        std::string endpoint;   // Full transcription URL
+        std::string apiKey;     // The top-level apiKey if empty
+        uint32_t weight;        // Share of the traffic relative to the others
+    };
+
     struct SpeechConfig {
         Provider provider;
         std::string apiKey;
@@ -45,11 +76,65 @@ public:
         std::string language;
         std::string endpoint;  // Custom endpoint URL for Azure OpenAI
         std::string deployment; // Deployment name for Azure OpenAI
+        std::vector<DeploymentConfig> deployments;  // Spread uploads over these instead of endpoint
+        std::string deploymentRouting;  // "latency" (outstanding x latency EWMA) or "least-outstanding"
         bool enablePunctuation;
         bool enableSpeakerDiarization;
+        bool enableVoiceActivityDetection; // Skip uploading audio with no speech
+        uint32_t minUtteranceMs;    // Upload segments: hold short utterances back until this long
+        uint32_t maxUtteranceMs;    // Cut at the next gap in the speech after this long
+        uint32_t maxLatencyMs;      // Never hold audio longer than this before uploading
+        uint32_t maxUploadAttempts; // Tries per chunk when the service throttles or fails
+        uint32_t uploadDeadlineMs;  // Give up on a chunk this long after its first audio arrived
+        uint32_t connectTimeoutMs;  // Per request phase; the deadline still applies
+        uint32_t sendTimeoutMs;
+        uint32_t receiveTimeoutMs;
+        uint32_t maxInFlightRequests;   // Chunk uploads running at once; results still arrive in order
+        uint32_t headOfLineMaxWaitMs;   // Give up on a chunk that holds later results back this long (0: wait)
+        std::string outputFormat;       // Audio sent for transcription: "wav" or "flac"
+        bool adaptiveUploadFormat;      // Step down to FLAC, then 8 kHz, while uploads fall behind; off where
+                                        // the HTTP client cannot time uploads (WinHTTP)
+        std::string spoolPath;          // Chunks that could not be uploaded wait here for the network; empty disables
+        uint32_t spoolMaxMB;            // Size of the spool file; the oldest chunks are dropped when it is full
+    };
+
+    // Voice activity gate counters, readable from any thread
+    struct VadStats {
+        bool enabled;
+        bool speechActive;
+        uint64_t speechFrames;
+        uint64_t silenceFrames;
+        uint64_t speechSegments;
+        uint64_t packetsForwarded;
+        uint64_t packetsSkipped;
+        uint64_t chunksSkipped;     // Skipped audio in 1 s units
+    };
+
+    // One transcribed utterance, placed on the timeline of the audio fed in
+    struct TranscriptSegment {
+        uint64_t sequence;
+        double startSeconds;
+        double endSeconds;
+        std::string text;
+        double confidence;
+        bool late = false;          // Uploaded from the spool after its turn, still in this session
     };
 
+    // Audio an earlier run captured but could not upload, transcribed from the
+    // spool. It has no place on this session's timeline or sequence.
+    struct RecoveredTranscript {
+        int64_t capturedAtMs;       // Wall clock, ms since the epoch
+        double durationSeconds;
+        std::string text;
+        double confidence;
+    };
+
+    // Traffic and errors per Azure OpenAI deployment
+    using DeploymentStats = DeploymentRouter::Stats;
+
     using TranscriptionCallback = std::function<void(const std::string& text, double confidence)>;
+    using SegmentCallback = std::function<void(const TranscriptSegment& segment)>;
+    using RecoveredCallback = std::function<void(const RecoveredTranscript& transcript)>;
     
     // Forward declaration
     class ISpeechProvider;
@@ -58,15 +143,66 @@ public:
     ~SpeechRecognition();
 
     bool Initialize(const SpeechConfig& config);
-    void ProcessAudioData(const std::vector<BYTE>& audioData, const AudioCapture::AudioFormat& format);
+    void ProcessAudioData(const std::vector<uint8_t>& audioData, const AudioFormat& format);
     void SetTranscriptionCallback(TranscriptionCallback callback);
+
+    // Timed results, in order. Only providers that upload segments report them.
+    void SetSegmentCallback(SegmentCallback callback);
+
+    // Results of chunks left in the upload spool by an earlier run. They go
+    // only here, never to the transcription or segment callbacks.
+    void SetRecoveredCallback(RecoveredCallback callback);
     bool IsInitialized() const { return initialized; }
 
+    // Send any buffered audio now, e.g. when recording stops. Call from the
+    // thread that feeds ProcessAudioData, or after capture has stopped.
+    void Flush();
+
+    // Block until no more than maxOutstanding segments are waiting for a
+    // result. Lets offline callers feed audio faster than real time without
+    // the upload queue shedding segments; Flush first to wait for everything.
+    void WaitForUploads(size_t maxOutstanding);
+
+    // Abandon the segments waiting for or in the middle of an upload, e.g.
+    // some time after recording stopped. Returns without waiting; audio fed
+    // in later is uploaded as usual.
+    void CancelUploads();
+
+    // Record per-stage latency of every transcribed chunk into tracker.
+    // Call before audio flows; the tracker is shared with whoever reports it.
+    void SetLatencyTracker(std::shared_ptr<PipelineLatency> tracker);
+
+    VadStats GetVadStats() const;
+
+    // Empty until the provider is initialized, and for providers that do not upload
+    std::vector<DeploymentStats> GetDeploymentStats() const;
+
 private:
     bool initialized;
     SpeechConfig currentConfig;
     TranscriptionCallback transcriptionCallback;
+    SegmentCallback segmentCallback;
+    RecoveredCallback recoveredCallback;
+    std::shared_ptr<PipelineLatency> latency;
     std::unique_ptr<ISpeechProvider> speechProvider;
 
+    // Voice activity gate in front of the provider (audio thread only)
+    std::unique_ptr<VoiceActivityDetector> voiceDetector;
+    std::vector<uint8_t> preRoll;          // Ring of the most recent skipped audio
+    size_t preRollStart;
+    size_t preRollSize;
+    AudioFormat preRollFormat;          // Format of the audio in the ring
+    uint64_t skippedFramesInChunk;
+
+    mutable std::mutex vadStatsMutex;
+    VadStats vadStats;
+
+    static constexpr uint32_t PRE_ROLL_MS = 200;
+    static constexpr uint32_t SKIPPED_CHUNK_SECONDS = 1;   // Unit for chunksSkipped
+
     bool InitializeProvider();
+    void RecordVadDecision(bool forwarded, size_t bytes, const AudioFormat& format);
+    void StorePreRoll(const std::vector<uint8_t>& audioData, const AudioFormat& format);
+    void ForwardPreRoll(const AudioFormat& format);
+    void SkipAudio(size_t bytes, const AudioFormat& format);
 };
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Lock-free single-producer/single-consumer ring buffer of trivially copyable
+// elements. Storage is allocated once in the constructor; reads and writes
+// never allocate, lock or block. Exactly one thread may write and exactly one
+// (other) thread may read.
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRingBuffer requires trivially copyable elements");
+
+public:
+    // Capacity is rounded up to the next power of two
+    explicit SpscRingBuffer(size_t minimumCapacity)
+        : capacity(RoundUpToPowerOfTwo(minimumCapacity))
+        , mask(capacity - 1)
+        , storage(new T[capacity])
+        , writeIndex(0)
+        , cachedReadIndex(0)
+        , readIndex(0)
+        , cachedWriteIndex(0)
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t Capacity() const { return capacity; }
+
+    // Number of elements currently stored (a snapshot when called concurrently)
+    size_t Size() const {
+        size_t write = writeIndex.load(std::memory_order_acquire);
+        size_t read = readIndex.load(std::memory_order_acquire);
+        return write - read;
+    }
+
+    bool IsEmpty() const { return Size() == 0; }
+
+    // Producer side: write both spans as one unit, or nothing if there is not
+    // room for all of them. The consumer never observes a partial write.
+    bool TryWrite(const T* first, size_t firstCount, const T* second = nullptr, size_t secondCount = 0) {
+        size_t total = firstCount + secondCount;
+        size_t write = writeIndex.load(std::memory_order_relaxed);
+
+        if (capacity - (write - cachedReadIndex) < total) {
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            if (capacity - (write - cachedReadIndex) < total) {
+                return false;
+            }
+        }
+
+        CopyIn(write, first, firstCount);
+        CopyIn(write + firstCount, second, secondCount);
+        writeIndex.store(write + total, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: copy count elements without consuming them
+    bool Peek(T* out, size_t count) {
+        size_t read = readIndex.load(std::memory_order_relaxed);
+        if (!Available(read, count)) {
+            return false;
+        }
+        CopyOut(read, out, count);
+        return true;
+    }
+
+    // Consumer side: read exactly count elements, or nothing
+    bool TryRead(T* out, size_t count) {
+        size_t read = readIndex.load(std::memory_order_relaxed);
+        if (!Available(read, count)) {
+            return false;
+        }
+        CopyOut(read, out, count);
+        readIndex.store(read + count, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: drop count elements without copying them
+    bool Skip(size_t count) {
+        size_t read = readIndex.load(std::memory_order_relaxed);
+        if (!Available(read, count)) {
+            return false;
+        }
+        readIndex.store(read + count, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    const size_t capacity;
+    const size_t mask;
+    std::unique_ptr<T[]> storage;
+
+    // Producer-owned state, kept on its own cache line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> writeIndex;
+    size_t cachedReadIndex;
+
+    // Consumer-owned state
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> readIndex;
+    size_t cachedWriteIndex;
+
+    static size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    bool Available(size_t read, size_t count) {
+        if (cachedWriteIndex - read < count) {
+            cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+            if (cachedWriteIndex - read < count) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void CopyIn(size_t position, const T* data, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        size_t offset = position & mask;
+        size_t firstPart = capacity - offset < count ? capacity - offset : count;
+        std::memcpy(storage.get() + offset, data, firstPart * sizeof(T));
+        std::memcpy(storage.get(), data + firstPart, (count - firstPart) * sizeof(T));
+    }
+
+    void CopyOut(size_t position, T* out, size_t count) const {
+        if (count == 0) {
+            return;
+        }
+        size_t offset = position & mask;
+        size_t firstPart = capacity - offset < count ? capacity - offset : count;
+        std::memcpy(out, storage.get() + offset, firstPart * sizeof(T));
+        std::memcpy(out + firstPart, storage.get(), (count - firstPart) * sizeof(T));
+    }
+};
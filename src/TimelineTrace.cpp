@@ -0,0 +1,250 @@
+#include "TimelineTrace.h"
+#include "SimpleLogger.h"
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t FLUSH_INTERVAL_MS = 500;
+const size_t MAX_PENDING_SPANS = 1 << 20;   // Per thread between flushes; more are dropped
+
+struct Span {
+    const char* name;
+    int64_t startMicros;
+    int64_t durationMicros;
+};
+
+// Owned jointly by the thread and the registry, so spans of a thread that
+// has exited are still written
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<Span> spans;
+    uint32_t threadId = 0;
+    std::string name;
+    bool nameWritten = false;
+    uint64_t dropped = 0;
+};
+
+struct TraceState {
+    std::mutex lifecycleMutex;
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    uint32_t nextThreadId = 1;
+
+    std::chrono::steady_clock::time_point origin;
+    std::ofstream file;
+    std::string path;
+    uint64_t spansWritten = 0;
+    bool exitRegistered = false;
+
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool stopRequested = false;
+};
+
+TraceState& State() {
+    static TraceState state;
+    return state;
+}
+
+thread_local std::shared_ptr<ThreadBuffer> currentThread;
+
+ThreadBuffer& CurrentThread() {
+    if (!currentThread) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        TraceState& state = State();
+        std::lock_guard<std::mutex> lock(state.registryMutex);
+        buffer->threadId = state.nextThreadId++;
+        state.threads.push_back(buffer);
+        currentThread = buffer;
+    }
+    return *currentThread;
+}
+
+void AppendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+}
+
+// Writer thread (or Stop once it has joined): moves every thread's spans to the file
+void Drain(TraceState& state) {
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    {
+        std::lock_guard<std::mutex> lock(state.registryMutex);
+        threads = state.threads;
+    }
+
+    std::string text;
+    std::vector<Span> spans;
+    for (const auto& thread : threads) {
+        std::string name;
+        uint64_t dropped;
+        {
+            std::lock_guard<std::mutex> lock(thread->mutex);
+            spans.swap(thread->spans);
+            if (!thread->nameWritten && !thread->name.empty()) {
+                name = thread->name;
+                thread->nameWritten = true;
+            }
+            dropped = thread->dropped;
+            thread->dropped = 0;
+        }
+
+        std::string tid = std::to_string(thread->threadId);
+        if (!name.empty()) {
+            text += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":\"";
+            AppendEscaped(text, name);
+            text += "\"}},\n";
+        }
+        for (const Span& span : spans) {
+            text += "{\"name\":\"";
+            text += span.name;
+            text += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + std::to_string(span.startMicros) +
+                    ",\"dur\":" + std::to_string(span.durationMicros) + "},\n";
+        }
+        state.spansWritten += spans.size();
+        spans.clear();
+
+        if (dropped > 0) {
+            LOG_RATE_LIMITED(Warn, 1, 10000, "TimelineTrace: dropped " + std::to_string(dropped) +
+                                             " spans on thread " + tid + " (flush fell behind)");
+        }
+    }
+
+    if (!text.empty()) {
+        state.file << text;
+        state.file.flush();
+    }
+}
+
+void WriterThreadProc(TraceState& state) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(state.wakeMutex);
+            state.wakeCondition.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS),
+                                         [&state] { return state.stopRequested; });
+            if (state.stopRequested) {
+                return;
+            }
+        }
+        Drain(state);
+    }
+}
+
+void StopAtExit() {
+    TimelineTrace::Stop();
+}
+
+} // namespace
+
+std::atomic<bool> TimelineTrace::enabled{false};
+
+bool TimelineTrace::Start(const std::string& path) {
+    TraceState& state = State();
+    std::lock_guard<std::mutex> lock(state.lifecycleMutex);
+    if (enabled.load()) {
+        return true;
+    }
+
+    state.file.open(path, std::ios::binary | std::ios::trunc);
+    if (!state.file) {
+        ERROR_LOG("TimelineTrace: cannot create " + path);
+        return false;
+    }
+
+    // Spans left from an earlier trace belong to its timeline
+    {
+        std::lock_guard<std::mutex> registryLock(state.registryMutex);
+        for (const auto& thread : state.threads) {
+            std::lock_guard<std::mutex> threadLock(thread->mutex);
+            thread->spans.clear();
+            thread->nameWritten = false;
+            thread->dropped = 0;
+        }
+    }
+
+    // The array is left open while writing; viewers accept a trace cut off mid-way
+    state.file << "[\n";
+    state.path = path;
+    state.spansWritten = 0;
+    state.origin = std::chrono::steady_clock::now();
+    state.stopRequested = false;
+    enabled.store(true);
+    state.writer = std::thread(WriterThreadProc, std::ref(state));
+
+    if (!state.exitRegistered) {
+        std::atexit(StopAtExit);
+        state.exitRegistered = true;
+    }
+    INFO_LOG("TimelineTrace: writing trace events to " + path);
+    return true;
+}
+
+void TimelineTrace::Stop() {
+    TraceState& state = State();
+    std::lock_guard<std::mutex> lock(state.lifecycleMutex);
+    if (!enabled.load()) {
+        return;
+    }
+
+    enabled.store(false);
+    {
+        std::lock_guard<std::mutex> wakeLock(state.wakeMutex);
+        state.stopRequested = true;
+    }
+    state.wakeCondition.notify_all();
+    if (state.writer.joinable()) {
+        state.writer.join();
+    }
+
+    Drain(state);
+    state.file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Teams Transcription\"}}\n]\n";
+    state.file.close();
+    INFO_LOG("TimelineTrace: wrote " + std::to_string(state.spansWritten) + " spans to " + state.path);
+}
+
+void TimelineTrace::SetThreadName(const std::string& name) {
+    ThreadBuffer& thread = CurrentThread();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    thread.name = name;
+    thread.nameWritten = false;
+}
+
+void TimelineTrace::RecordSpan(const char* name, std::chrono::steady_clock::time_point start,
+                               std::chrono::steady_clock::time_point end) {
+    // Acquire pairs with Start, which sets the origin before enabling
+    if (!enabled.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    const auto origin = State().origin;
+    Span span;
+    span.name = name;
+    span.startMicros = std::chrono::duration_cast<std::chrono::microseconds>(start - origin).count();
+    span.durationMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    ThreadBuffer& thread = CurrentThread();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    if (thread.spans.size() >= MAX_PENDING_SPANS) {
+        thread.dropped++;
+        return;
+    }
+    thread.spans.push_back(span);
+}
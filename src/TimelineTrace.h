@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// Optional timeline of what each thread was doing, written as Chrome
+// trace_event JSON (open in chrome://tracing or ui.perfetto.dev). Spans are
+// kept in per-thread buffers and appended to the file by a background thread
+// every half second, so a trace taken during a hang is still readable.
+// While tracing is off a span costs one relaxed atomic load.
+class TimelineTrace {
+public:
+    // Start writing to path; does nothing if a trace is already running
+    static bool Start(const std::string& path);
+
+    // Write what is buffered, close the JSON array and the file
+    static void Stop();
+
+    static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Track name for the calling thread; may be called before Start
+    static void SetThreadName(const std::string& name);
+
+    // name must outlive the trace, e.g. a string literal
+    static void RecordSpan(const char* name, std::chrono::steady_clock::time_point start,
+                           std::chrono::steady_clock::time_point end);
+
+    // Records the time from construction to End or destruction as one span
+    class Scope {
+    public:
+        explicit Scope(const char* spanName) : name(TimelineTrace::IsEnabled() ? spanName : nullptr) {
+            if (name) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+        ~Scope() { End(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void End() {
+            if (name) {
+                TimelineTrace::RecordSpan(name, start, std::chrono::steady_clock::now());
+                name = nullptr;
+            }
+        }
+
+    private:
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+#define TRACE_SCOPE_CONCAT_INNER(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_INNER(a, b)
+
+// Span covering the rest of the enclosing block, e.g. TRACE_SCOPE("ConvertAudio")
+#define TRACE_SCOPE(name) TimelineTrace::Scope TRACE_SCOPE_CONCAT(traceScope, __LINE__)(name)
@@ -0,0 +1,62 @@
+#include "TranscriptSink.h"
+#include <nlohmann/json.hpp>
+#include <cmath>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Millisecond precision is plenty and keeps the lines short
+double RoundToMilliseconds(double seconds) {
+    return std::round(seconds * 1000.0) / 1000.0;
+}
+
+// Replace invalid UTF-8 from the service rather than throwing
+std::string Dump(const json& line) {
+    return line.dump(-1, ' ', false, json::error_handler_t::replace);
+}
+
+} // namespace
+
+TranscriptSink::TranscriptSink(std::ostream& output) : output(output), segmentCount(0), recoveredCount(0) {
+}
+
+void TranscriptSink::Write(const SpeechRecognition::TranscriptSegment& segment) {
+    json line;
+    line["sequence"] = segment.sequence;
+    line["start"] = RoundToMilliseconds(segment.startSeconds);
+    line["end"] = RoundToMilliseconds(segment.endSeconds);
+    line["text"] = segment.text;
+    line["confidence"] = segment.confidence;
+    if (segment.late) {
+        line["late"] = true;
+    }
+    WriteLine(Dump(line), segmentCount);
+}
+
+void TranscriptSink::WriteRecovered(const SpeechRecognition::RecoveredTranscript& transcript) {
+    json line;
+    line["recovered"] = true;
+    line["capturedAtMs"] = transcript.capturedAtMs;
+    line["duration"] = RoundToMilliseconds(transcript.durationSeconds);
+    line["text"] = transcript.text;
+    line["confidence"] = transcript.confidence;
+    WriteLine(Dump(line), recoveredCount);
+}
+
+uint64_t TranscriptSink::GetSegmentCount() const {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return segmentCount;
+}
+
+uint64_t TranscriptSink::GetRecoveredCount() const {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return recoveredCount;
+}
+
+void TranscriptSink::WriteLine(const std::string& text, uint64_t& counter) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    output << text << '\n';
+    output.flush();
+    counter++;
+}
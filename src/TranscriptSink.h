@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SpeechRecognition.h"
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+// Writes transcript segments as JSON lines, one object per segment:
+// {"sequence":0,"start":1.25,"end":4.8,"text":"...","confidence":0.95}
+// Segments uploaded late from the spool add "late":true. Audio an earlier run
+// left in the spool has no sequence or times on this input, and is written as
+// {"recovered":true,"capturedAtMs":1760601600000,"duration":4.2,"text":"...","confidence":0.95}
+// Safe to call from the upload threads that deliver results.
+class TranscriptSink {
+public:
+    explicit TranscriptSink(std::ostream& output);
+
+    void Write(const SpeechRecognition::TranscriptSegment& segment);
+    void WriteRecovered(const SpeechRecognition::RecoveredTranscript& transcript);
+
+    uint64_t GetSegmentCount() const;
+    uint64_t GetRecoveredCount() const;
+
+private:
+    std::ostream& output;
+    mutable std::mutex writeMutex;
+    uint64_t segmentCount;
+    uint64_t recoveredCount;
+
+    void WriteLine(const std::string& text, uint64_t& counter);
+};
@@ -0,0 +1,364 @@
+#include "UploadQueue.h"
+#include "SimpleLogger.h"
+#include "TimelineTrace.h"
+
+UploadQueue::UploadQueue(size_t capacity, size_t workerCount, std::chrono::milliseconds headOfLineMaxWait)
+    : capacity(capacity > 0 ? capacity : 1)
+    , workerCount(workerCount > 0 ? workerCount : 1)
+    , headOfLineMaxWait(headOfLineMaxWait)
+    , running(false)
+    , nextSequence(0)
+    , cancellation(std::make_shared<CancellationToken>())
+    , headOfLineReleaseAt(std::chrono::steady_clock::time_point::max())
+    , nextToDeliver(0)
+    , enqueuedCount(0)
+    , droppedCount(0)
+    , completedCount(0)
+    , failedCount(0)
+    , cancelledCount(0)
+    , skippedCount(0)
+{
+}
+
+UploadQueue::~UploadQueue() {
+    Stop();
+}
+
+void UploadQueue::Start(UploadFunction upload, ResultCallback onResult, DropCallback onDrop) {
+    if (running.load()) {
+        return;
+    }
+
+    uploadFunction = upload;
+    resultCallback = onResult;
+    dropCallback = onDrop;
+
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        completedResults.clear();
+        nextToDeliver = nextSequence;
+        headBlockedSince = std::chrono::steady_clock::time_point();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        headOfLineReleaseAt = std::chrono::steady_clock::time_point::max();
+    }
+
+    running.store(true);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&UploadQueue::WorkerThreadProc, this, i);
+    }
+
+    INFO_LOG("UploadQueue started with " + std::to_string(workerCount) + " workers, capacity " + std::to_string(capacity) +
+             ", head-of-line wait " + (headOfLineMaxWait.count() > 0 ? std::to_string(headOfLineMaxWait.count()) + " ms" : "unlimited"));
+}
+
+void UploadQueue::Stop() {
+    if (!running.load()) {
+        return;
+    }
+
+    std::shared_ptr<CancellationToken> inFlight;
+    std::vector<Chunk> unsent;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running.store(false);
+        if (!pendingChunks.empty()) {
+            WARN_LOG("UploadQueue stopping with " + std::to_string(pendingChunks.size()) + " chunks not uploaded");
+            cancelledCount += pendingChunks.size();
+        }
+        unsent.swap(shedChunks);
+        for (Chunk& chunk : pendingChunks) {
+            unsent.push_back(std::move(chunk));
+        }
+        pendingChunks.clear();
+        droppedSequences.clear();
+        inFlight = cancellation;
+        cancellation = std::make_shared<CancellationToken>();
+    }
+    // Uploads in flight give up instead of holding the join
+    inFlight->Cancel();
+    queueCondition.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+    }
+    deliveredCondition.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+
+    if (dropCallback) {
+        for (Chunk& chunk : unsent) {
+            dropCallback(chunk);
+        }
+    }
+
+    INFO_LOG("UploadQueue stopped");
+}
+
+void UploadQueue::Cancel() {
+    std::shared_ptr<CancellationToken> inFlight;
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queued = pendingChunks.size();
+        for (const Chunk& chunk : pendingChunks) {
+            droppedSequences.emplace_back(chunk.sequence, "cancelled");
+        }
+        pendingChunks.clear();
+        cancelledCount += queued;
+        inFlight = cancellation;
+        cancellation = std::make_shared<CancellationToken>();
+    }
+    inFlight->Cancel();
+    queueCondition.notify_all();
+
+    INFO_LOG("UploadQueue cancelled " + std::to_string(queued) + " queued chunks and the uploads in flight");
+}
+
+uint64_t UploadQueue::Enqueue(std::vector<uint8_t>&& audio, uint32_t sampleRate, uint16_t channels, uint16_t bitsPerSample,
+                              const ChunkTrace& trace) {
+    uint64_t sequence;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        sequence = nextSequence++;
+
+        // Never wait for the workers: shed the oldest chunk instead
+        if (pendingChunks.size() >= capacity) {
+            droppedSequences.emplace_back(pendingChunks.front().sequence, "queue full");
+            if (dropCallback) {
+                shedChunks.push_back(std::move(pendingChunks.front()));
+            }
+            pendingChunks.pop_front();
+            droppedCount++;
+        }
+
+        Chunk chunk;
+        chunk.sequence = sequence;
+        chunk.audio = std::move(audio);
+        chunk.sampleRate = sampleRate;
+        chunk.channels = channels;
+        chunk.bitsPerSample = bitsPerSample;
+        chunk.trace = trace;
+        chunk.trace.enqueued = std::chrono::steady_clock::now();
+        chunk.cancel = cancellation;
+        pendingChunks.push_back(std::move(chunk));
+    }
+    enqueuedCount++;
+    queueCondition.notify_one();
+
+    return sequence;
+}
+
+void UploadQueue::WaitForOutstanding(size_t maxOutstanding) {
+    std::unique_lock<std::mutex> lock(deliveryMutex);
+    deliveredCondition.wait(lock, [this, maxOutstanding] {
+        uint64_t issued;
+        {
+            std::lock_guard<std::mutex> queueLock(queueMutex);
+            issued = nextSequence;
+        }
+        return !running.load() || issued - nextToDeliver <= maxOutstanding;
+    });
+}
+
+UploadQueue::Stats UploadQueue::GetStats() const {
+    Stats stats;
+    stats.enqueued = enqueuedCount.load();
+    stats.dropped = droppedCount.load();
+    stats.completed = completedCount.load();
+    stats.failed = failedCount.load();
+    stats.cancelled = cancelledCount.load();
+    stats.skipped = skippedCount.load();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stats.pending = pendingChunks.size();
+    }
+    return stats;
+}
+
+void UploadQueue::WorkerThreadProc(size_t index) {
+    TimelineTrace::SetThreadName("Upload worker " + std::to_string(index + 1));
+    while (true) {
+        std::vector<std::pair<uint64_t, const char*>> dropped;
+        std::vector<Chunk> shed;
+        Chunk chunk;
+        bool hasChunk = false;
+        bool releaseHead = false;
+
+        {
+            // Idle workers also keep the head-of-line timer
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (running.load() && pendingChunks.empty() && droppedSequences.empty() &&
+                   std::chrono::steady_clock::now() < headOfLineReleaseAt) {
+                if (headOfLineReleaseAt == std::chrono::steady_clock::time_point::max()) {
+                    queueCondition.wait(lock);
+                } else {
+                    queueCondition.wait_until(lock, headOfLineReleaseAt);
+                }
+            }
+
+            if (!running.load()) {
+                break;
+            }
+
+            // A head past its wait is released before more work is taken,
+            // since a backlog is when it holds the most results back
+            if (std::chrono::steady_clock::now() >= headOfLineReleaseAt) {
+                releaseHead = true;
+            } else {
+                dropped.swap(droppedSequences);
+                shed.swap(shedChunks);
+                if (!pendingChunks.empty()) {
+                    chunk = std::move(pendingChunks.front());
+                    pendingChunks.pop_front();
+                    hasChunk = true;
+                }
+            }
+        }
+
+        if (releaseHead) {
+            ReleaseLaggingHead();
+            continue;
+        }
+
+        // The drop callback sees a shed chunk before its slot is delivered
+        for (Chunk& shedChunk : shed) {
+            dropCallback(shedChunk);
+        }
+
+        // Dropped chunks still occupy their slot in the delivery order
+        for (const auto& drop : dropped) {
+            WARN_LOG("UploadQueue dropped chunk #" + std::to_string(drop.first) + " (" + drop.second + ")");
+            CompleteChunk(drop.first, std::string(), ChunkTrace());
+        }
+
+        if (!hasChunk) {
+            continue;
+        }
+        chunk.trace.dequeued = std::chrono::steady_clock::now();
+
+        std::string text;
+        try {
+            TRACE_SCOPE("UploadChunk");
+            text = uploadFunction(chunk);
+        }
+        catch (const std::exception& e) {
+            ERROR_LOG("UploadQueue upload of chunk #" + std::to_string(chunk.sequence) + " failed: " + std::string(e.what()));
+        }
+
+        if (text.empty()) {
+            failedCount++;
+        } else {
+            completedCount++;
+        }
+
+        chunk.trace.completed = std::chrono::steady_clock::now();
+        CompleteChunk(chunk.sequence, std::move(text), chunk.trace);
+    }
+}
+
+void UploadQueue::CompleteChunk(uint64_t sequence, std::string text, ChunkTrace trace) {
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        if (sequence < nextToDeliver) {
+            // Its slot was already delivered as a failure; the order matters more
+            WARN_LOG("UploadQueue discarded the late result of chunk #" + std::to_string(sequence));
+        } else {
+            completedResults[sequence] = std::make_pair(std::move(text), trace);
+            if (DeliverReady()) {
+                headBlockedSince = std::chrono::steady_clock::time_point();
+            }
+            UpdateHeadOfLineTimer();
+            deliveredCondition.notify_all();
+        }
+    }
+
+    // Busy workers only pass through here, so they keep the timer too
+    bool overdue;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        overdue = std::chrono::steady_clock::now() >= headOfLineReleaseAt;
+    }
+    if (overdue) {
+        ReleaseLaggingHead();
+    }
+}
+
+bool UploadQueue::DeliverReady() {
+    // Release every result that is now contiguous with what was delivered
+    bool delivered = false;
+    auto it = completedResults.begin();
+    while (it != completedResults.end() && it->first == nextToDeliver) {
+        if (resultCallback) {
+            TRACE_SCOPE("DeliverResult");
+            it->second.second.delivered = std::chrono::steady_clock::now();
+            resultCallback(it->first, it->second.first, it->second.second);
+        }
+        it = completedResults.erase(it);
+        nextToDeliver++;
+        delivered = true;
+    }
+    return delivered;
+}
+
+void UploadQueue::UpdateHeadOfLineTimer() {
+    if (headOfLineMaxWait.count() <= 0) {
+        return;
+    }
+
+    // Anything left in the buffer is waiting on an earlier chunk
+    auto releaseAt = std::chrono::steady_clock::time_point::max();
+    if (completedResults.empty()) {
+        headBlockedSince = std::chrono::steady_clock::time_point();
+    } else {
+        if (headBlockedSince == std::chrono::steady_clock::time_point()) {
+            headBlockedSince = std::chrono::steady_clock::now();
+        }
+        releaseAt = headBlockedSince + headOfLineMaxWait;
+    }
+
+    bool sooner;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        sooner = releaseAt < headOfLineReleaseAt;
+        headOfLineReleaseAt = releaseAt;
+    }
+    if (sooner) {
+        queueCondition.notify_one();
+    }
+}
+
+void UploadQueue::ReleaseLaggingHead() {
+    std::lock_guard<std::mutex> lock(deliveryMutex);
+    auto now = std::chrono::steady_clock::now();
+    if (completedResults.empty() || headBlockedSince == std::chrono::steady_clock::time_point() ||
+        now < headBlockedSince + headOfLineMaxWait) {
+        UpdateHeadOfLineTimer();    // Another worker got here first
+        return;
+    }
+
+    uint64_t firstReady = completedResults.begin()->first;
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - headBlockedSince).count();
+    while (nextToDeliver < firstReady) {
+        WARN_LOG("UploadQueue gave up waiting for chunk #" + std::to_string(nextToDeliver) + " after " +
+                 std::to_string(waited) + " ms, " + std::to_string(completedResults.size()) + " later results were held back");
+        skippedCount++;
+        if (resultCallback) {
+            TRACE_SCOPE("DeliverResult");
+            ChunkTrace trace;
+            trace.delivered = now;
+            resultCallback(nextToDeliver, std::string(), trace);
+        }
+        nextToDeliver++;
+    }
+
+    DeliverReady();
+    headBlockedSince = std::chrono::steady_clock::time_point();
+    UpdateHeadOfLineTimer();
+    deliveredCondition.notify_all();
+}
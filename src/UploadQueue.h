@@ -0,0 +1,134 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "PipelineLatency.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bounded queue of audio chunks that are uploaded by a pool of worker threads.
+// Enqueue never blocks on the network: when the queue is full the oldest pending
+// chunk is dropped. Results are handed back strictly in sequence (capture) order,
+// regardless of the order in which the uploads complete; a chunk that holds
+// finished later results back longer than headOfLineMaxWait is given up on
+// (delivered as a failure) and its result is discarded if it still arrives.
+// Cancel abandons the queued chunks and signals the uploads in flight to give up.
+// Chunks shed when the queue is full or still queued at Stop go to the drop
+// callback, if any, so the caller can keep them for later.
+class UploadQueue {
+public:
+    struct Chunk {
+        uint64_t sequence;
+        std::vector<uint8_t> audio;     // Complete audio file (WAV or FLAC) to upload
+        uint32_t sampleRate;
+        uint16_t channels;
+        uint16_t bitsPerSample;
+        ChunkTrace trace;               // The queue stamps enqueued, dequeued, completed and delivered
+        std::shared_ptr<CancellationToken> cancel;  // Cancelled by Cancel or Stop; uploads should watch it
+    };
+
+    // Uploads one chunk and returns the transcription (empty on failure).
+    // May add its own points to chunk.trace.
+    using UploadFunction = std::function<std::string(Chunk& chunk)>;
+    // Receives results in sequence order; empty text for failed or dropped chunks
+    using ResultCallback = std::function<void(uint64_t sequence, const std::string& text, const ChunkTrace& trace)>;
+    // Receives chunks dropped without an upload, on a worker thread, or on the
+    // thread calling Stop; their slots are still delivered as failures
+    using DropCallback = std::function<void(Chunk& chunk)>;
+
+    struct Stats {
+        uint64_t enqueued;
+        uint64_t dropped;
+        uint64_t completed;
+        uint64_t failed;
+        uint64_t cancelled;             // Queued chunks abandoned by Cancel or Stop
+        uint64_t skipped;               // Given up on after holding later results back
+        size_t pending;
+    };
+
+    // workerCount is the number of uploads in flight at once; a zero
+    // headOfLineMaxWait waits for every result
+    UploadQueue(size_t capacity, size_t workerCount,
+                std::chrono::milliseconds headOfLineMaxWait = std::chrono::milliseconds(0));
+    ~UploadQueue();
+
+    UploadQueue(const UploadQueue&) = delete;
+    UploadQueue& operator=(const UploadQueue&) = delete;
+
+    void Start(UploadFunction upload, ResultCallback onResult, DropCallback onDrop = DropCallback());
+
+    // Cancels the uploads in flight, hands the queued chunks to the drop
+    // callback and joins the workers
+    void Stop();
+
+    // Abandon everything queued or uploading now; chunks queued afterwards
+    // upload normally. Cancelled chunks are delivered as failures, in order.
+    void Cancel();
+
+    bool IsRunning() const { return running.load(); }
+
+    // Queue a chunk for upload and return its sequence number; trace carries
+    // any points stamped before the chunk was queued
+    uint64_t Enqueue(std::vector<uint8_t>&& audio, uint32_t sampleRate, uint16_t channels, uint16_t bitsPerSample,
+                     const ChunkTrace& trace = ChunkTrace());
+
+    // Block until at most maxOutstanding chunks are queued, uploading or
+    // waiting for an earlier result; returns early if the queue stops
+    void WaitForOutstanding(size_t maxOutstanding);
+
+    Stats GetStats() const;
+
+private:
+    size_t capacity;
+    size_t workerCount;
+    std::chrono::milliseconds headOfLineMaxWait;
+
+    UploadFunction uploadFunction;
+    ResultCallback resultCallback;
+    DropCallback dropCallback;
+
+    std::atomic<bool> running;
+    std::vector<std::thread> workers;
+
+    mutable std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<Chunk> pendingChunks;
+    std::vector<std::pair<uint64_t, const char*>> droppedSequences;    // With the reason
+    std::vector<Chunk> shedChunks;      // Dropped when full, for the drop callback before their slot is delivered
+    uint64_t nextSequence;
+    std::shared_ptr<CancellationToken> cancellation;    // Handed to chunks as they are queued
+    std::chrono::steady_clock::time_point headOfLineReleaseAt;     // An idle worker gives up on the head then
+
+    // Reorder buffer: finished results waiting for earlier sequences
+    std::mutex deliveryMutex;
+    std::map<uint64_t, std::pair<std::string, ChunkTrace>> completedResults;
+    uint64_t nextToDeliver;
+    std::chrono::steady_clock::time_point headBlockedSince;     // When results started waiting on the head
+    std::condition_variable deliveredCondition;
+
+    std::atomic<uint64_t> enqueuedCount;
+    std::atomic<uint64_t> droppedCount;
+    std::atomic<uint64_t> completedCount;
+    std::atomic<uint64_t> failedCount;
+    std::atomic<uint64_t> cancelledCount;
+    std::atomic<uint64_t> skippedCount;
+
+    void WorkerThreadProc(size_t index);
+    void CompleteChunk(uint64_t sequence, std::string text, ChunkTrace trace);
+
+    // Delivery helpers; the caller holds deliveryMutex
+    bool DeliverReady();    // True if anything was delivered
+    void UpdateHeadOfLineTimer();
+
+    // Deliver past a head that has held results back too long
+    void ReleaseLaggingHead();
+};
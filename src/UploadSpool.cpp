@@ -0,0 +1,521 @@
+#include "UploadSpool.h"
+#include "SimpleLogger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// The file starts with this header; records follow, 8-byte aligned. Fields
+// are in the byte order of the machine that wrote them.
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t capacity;          // File size
+    uint64_t head;              // Oldest record; equal to tail when empty
+    uint64_t tail;              // Where the next record goes
+    uint64_t nextId;
+    uint64_t session;           // Incremented by each Open
+    uint64_t reserved[1];
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t state;
+    uint64_t id;
+    uint64_t session;
+    uint64_t sequence;
+    int64_t capturedAtMs;
+    double startSeconds;
+    double endSeconds;
+    uint32_t sampleRate;
+    uint32_t size;              // Audio bytes after the header
+    uint32_t checksum;          // Of the audio
+    uint32_t attempts;
+};
+
+static_assert(sizeof(FileHeader) == 64, "spool file header layout");
+static_assert(sizeof(RecordHeader) == 72, "spool record header layout");
+
+const char FILE_MAGIC[8] = {'T', 'T', 'S', 'P', 'O', 'O', 'L', '1'};
+const uint32_t FILE_VERSION = 2;       // 2: records carry their session
+const uint32_t RECORD_MAGIC = 0x43525053;       // "SPRC"
+const uint64_t DATA_START = sizeof(FileHeader);
+const uint64_t MIN_CAPACITY = 1 << 20;
+
+// A record that has been uploaded waits for the head to pass it; a wrap
+// marker sends the reader back to DATA_START
+enum RecordState : uint32_t { Pending = 1, Done = 2, Wrap = 3 };
+
+uint64_t RecordSpan(uint64_t size) {
+    return (sizeof(RecordHeader) + size + 7) & ~uint64_t(7);
+}
+
+// FNV-1a: catches a record the crash left half written
+uint32_t Checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// Read-write shared mapping of the whole file, held under an exclusive lock
+class UploadSpool::MappedFile {
+public:
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::filesystem::path& path) {
+#ifdef _WIN32
+        // No sharing: a second instance fails here instead of corrupting the ring
+        handle = CreateFileW(path.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        descriptor = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        if (descriptor < 0) {
+            return false;
+        }
+        if (flock(descriptor, LOCK_EX | LOCK_NB) != 0) {
+            Close();
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    uint64_t FileSize() const {
+#ifdef _WIN32
+        LARGE_INTEGER size;
+        return GetFileSizeEx(handle, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+#else
+        struct stat status;
+        return fstat(descriptor, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+#endif
+    }
+
+    // Map size bytes, growing or shrinking the file to match
+    bool Map(uint64_t size) {
+        Unmap();
+#ifdef _WIN32
+        FILE_END_OF_FILE_INFO endOfFile{};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        if (FileSize() != size &&
+            !SetFileInformationByHandle(handle, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile))) {
+            return false;
+        }
+        mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                     static_cast<DWORD>(size), nullptr);
+        if (!mapping) {
+            return false;
+        }
+        void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, static_cast<SIZE_T>(size));
+        if (!view) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+#else
+        if (FileSize() != size && ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+#endif
+        data = static_cast<uint8_t*>(view);
+        mappedSize = size;
+        return true;
+    }
+
+    // Start writing a range back; the page cache already survives a process crash
+    void Flush(uint64_t offset, uint64_t size) {
+        if (!data) {
+            return;
+        }
+        const uint64_t page = 4096;
+        uint64_t start = offset & ~(page - 1);
+        size = std::min(mappedSize, offset + size) - start;
+#ifdef _WIN32
+        FlushViewOfFile(data + start, static_cast<SIZE_T>(size));
+#else
+        msync(data + start, static_cast<size_t>(size), MS_ASYNC);
+#endif
+    }
+
+    void Unmap() {
+        if (!data) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(data, static_cast<size_t>(mappedSize));
+#endif
+        data = nullptr;
+        mappedSize = 0;
+    }
+
+    void Close() {
+        Unmap();
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(handle);
+            handle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (descriptor >= 0) {
+            close(descriptor);      // Releases the lock
+            descriptor = -1;
+        }
+#endif
+    }
+
+    uint8_t* Data() const { return data; }
+    uint64_t Size() const { return mappedSize; }
+    FileHeader* Header() const { return reinterpret_cast<FileHeader*>(data); }
+    RecordHeader* At(uint64_t offset) const { return reinterpret_cast<RecordHeader*>(data + offset); }
+
+private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+    uint8_t* data = nullptr;
+    uint64_t mappedSize = 0;
+};
+
+UploadSpool::UploadSpool() : pendingCount(0), appendedCount(0), droppedCount(0), recoveredCount(0) {
+}
+
+UploadSpool::~UploadSpool() {
+    Close();
+}
+
+bool UploadSpool::Open(const std::string& path, uint64_t capacityBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    file.reset();
+    pendingCount = 0;
+    recoveredCount = 0;
+
+    std::filesystem::path filePath(path);
+    std::error_code error;
+    if (filePath.has_parent_path()) {
+        std::filesystem::create_directories(filePath.parent_path(), error);
+    }
+
+    auto opened = std::make_unique<MappedFile>();
+    if (!opened->Open(filePath)) {
+        ERROR_LOG("UploadSpool: cannot open " + path + " (missing, or in use by another instance)");
+        return false;
+    }
+    file = std::move(opened);
+
+    // Keep what a previous session left, at the size it was written with
+    uint64_t existing = file->FileSize();
+    if (existing >= MIN_CAPACITY && file->Map(existing)) {
+        if (!Recover()) {
+            WARN_LOG("UploadSpool: " + path + " is damaged, not a spool or from another version, starting it over");
+        } else if (pendingCount > 0) {
+            recoveredCount = pendingCount;
+            StartSession();
+            INFO_LOG("UploadSpool: recovered " + std::to_string(pendingCount) + " chunks from " + path +
+                     ", session " + std::to_string(file->Header()->session));
+            return true;
+        }
+    }
+
+    if (!file->Map(std::max(capacityBytes, MIN_CAPACITY) & ~uint64_t(7))) {
+        ERROR_LOG("UploadSpool: cannot map " + path);
+        file.reset();
+        return false;
+    }
+    Reset();
+    StartSession();
+    return true;
+}
+
+void UploadSpool::Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) {
+        file->Flush(0, file->Size());
+        file.reset();
+    }
+    pendingCount = 0;
+}
+
+bool UploadSpool::IsOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file != nullptr;
+}
+
+uint64_t UploadSpool::GetSession() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file ? file->Header()->session : 0;
+}
+
+bool UploadSpool::Append(const Record& record, const uint8_t* audio, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    uint64_t span = RecordSpan(size);
+    if (span + sizeof(RecordHeader) > file->Size() - DATA_START) {
+        WARN_LOG("UploadSpool: a " + std::to_string(size) + " byte chunk does not fit in the spool");
+        return false;
+    }
+
+    uint64_t offset;
+    while (!FindRoom(span, offset)) {
+        DropOldest();
+    }
+
+    // The record is complete before the tail moves past it
+    FileHeader* header = file->Header();
+    RecordHeader* stored = file->At(offset);
+    std::memcpy(file->Data() + offset + sizeof(RecordHeader), audio, size);
+    stored->magic = RECORD_MAGIC;
+    stored->state = Pending;
+    stored->id = header->nextId++;
+    stored->session = header->session;
+    stored->sequence = record.sequence;
+    stored->capturedAtMs = record.capturedAtMs != 0 ? record.capturedAtMs : NowMs();
+    stored->startSeconds = record.startSeconds;
+    stored->endSeconds = record.endSeconds;
+    stored->sampleRate = record.sampleRate;
+    stored->size = static_cast<uint32_t>(size);
+    stored->checksum = Checksum(audio, size);
+    stored->attempts = 0;
+    header->tail = offset + span;
+
+    pendingCount++;
+    appendedCount++;
+    file->Flush(offset, span);
+    file->Flush(0, sizeof(FileHeader));
+    return true;
+}
+
+bool UploadSpool::PeekOldest(Record& record, std::vector<uint8_t>& audio) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file || pendingCount == 0) {
+        return false;
+    }
+    // AdvanceHead leaves the head on a pending record
+    const FileHeader* header = file->Header();
+    const RecordHeader* stored = file->At(header->head);
+    record.id = stored->id;
+    record.session = stored->session;
+    record.sequence = stored->sequence;
+    record.capturedAtMs = stored->capturedAtMs;
+    record.startSeconds = stored->startSeconds;
+    record.endSeconds = stored->endSeconds;
+    record.sampleRate = stored->sampleRate;
+    record.attempts = stored->attempts;
+    audio.assign(file->Data() + header->head + sizeof(RecordHeader),
+                 file->Data() + header->head + sizeof(RecordHeader) + stored->size);
+    return true;
+}
+
+uint32_t UploadSpool::RecordAttempt(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t offset = FindRecord(id);
+    if (offset == 0) {
+        return 0;
+    }
+    RecordHeader* stored = file->At(offset);
+    stored->attempts++;
+    file->Flush(offset, sizeof(RecordHeader));
+    return stored->attempts;
+}
+
+void UploadSpool::Remove(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t offset = FindRecord(id);
+    if (offset == 0) {
+        return;     // Dropped while it was being uploaded
+    }
+    file->At(offset)->state = Done;
+    pendingCount--;
+    AdvanceHead();
+    file->Flush(offset, sizeof(RecordHeader));
+    file->Flush(0, sizeof(FileHeader));
+}
+
+UploadSpool::Stats UploadSpool::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats{};
+    stats.pending = pendingCount;
+    stats.appended = appendedCount;
+    stats.dropped = droppedCount;
+    stats.recovered = recoveredCount;
+    if (file) {
+        const FileHeader* header = file->Header();
+        stats.capacityBytes = file->Size();
+        stats.usedBytes = header->tail >= header->head ? header->tail - header->head
+                                                       : file->Size() - header->head + header->tail - DATA_START;
+    }
+    return stats;
+}
+
+// Validate the ring a previous session left: the header must describe this
+// file, and the walk from head to tail must stay on intact records. A record
+// whose audio fails its checksum is skipped; a broken chain ends the ring there.
+bool UploadSpool::Recover() {
+    FileHeader* header = file->Header();
+    uint64_t capacity = file->Size();
+    if (std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header->version != FILE_VERSION ||
+        header->headerSize != sizeof(FileHeader) || header->capacity != capacity) {
+        return false;
+    }
+    auto valid = [capacity](uint64_t offset) {
+        return offset >= DATA_START && offset + sizeof(RecordHeader) <= capacity && offset % 8 == 0;
+    };
+    if (!valid(header->head) || !valid(header->tail)) {
+        return false;
+    }
+
+    pendingCount = 0;
+    uint64_t offset = header->head;
+    uint64_t maxRecords = capacity / sizeof(RecordHeader);
+    for (uint64_t walked = 0; offset != header->tail; ++walked) {
+        RecordHeader* stored = file->At(offset);
+        bool intact = walked < maxRecords && valid(offset) && stored->magic == RECORD_MAGIC &&
+                      (stored->state == Pending || stored->state == Done || stored->state == Wrap) &&
+                      (stored->state == Wrap || offset + RecordSpan(stored->size) <= capacity);
+        if (!intact) {
+            WARN_LOG("UploadSpool: spool damaged at offset " + std::to_string(offset) + ", later records are lost");
+            header->tail = offset;
+            break;
+        }
+        if (stored->state == Pending) {
+            if (Checksum(file->Data() + offset + sizeof(RecordHeader), stored->size) != stored->checksum) {
+                WARN_LOG("UploadSpool: discarding damaged chunk #" + std::to_string(stored->sequence));
+                stored->state = Done;
+            } else {
+                pendingCount++;
+            }
+        }
+        if (stored->state != Wrap) {
+            header->nextId = std::max(header->nextId, stored->id + 1);
+        }
+        offset = Next(offset);
+    }
+    AdvanceHead();
+    return true;
+}
+
+void UploadSpool::Reset() {
+    FileHeader* header = file->Header();
+    std::memset(header, 0, sizeof(FileHeader));
+    std::memcpy(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header->version = FILE_VERSION;
+    header->headerSize = sizeof(FileHeader);
+    header->capacity = file->Size();
+    header->head = DATA_START;
+    header->tail = DATA_START;
+    header->nextId = 1;
+    pendingCount = 0;
+    file->Flush(0, sizeof(FileHeader));
+}
+
+// Session numbers only grow while the file keeps its records
+void UploadSpool::StartSession() {
+    file->Header()->session++;
+    file->Flush(0, sizeof(FileHeader));
+}
+
+// Space for span bytes at the tail. There is always room left at the end
+// of the file for a wrap marker, so the tail can wrap to the start.
+bool UploadSpool::FindRoom(uint64_t span, uint64_t& offset) {
+    FileHeader* header = file->Header();
+    uint64_t capacity = file->Size();
+    if (header->head == header->tail) {
+        header->head = DATA_START;
+        header->tail = DATA_START;
+    }
+
+    // The tail never catches up with the head: equal means empty
+    if (header->tail >= header->head) {
+        if (header->tail + span + sizeof(RecordHeader) <= capacity) {
+            offset = header->tail;
+            return true;
+        }
+        if (DATA_START + span >= header->head) {
+            return false;
+        }
+        RecordHeader* marker = file->At(header->tail);
+        marker->magic = RECORD_MAGIC;
+        marker->state = Wrap;
+        header->tail = DATA_START;
+        offset = DATA_START;
+        return true;
+    }
+    if (header->tail + span < header->head) {
+        offset = header->tail;
+        return true;
+    }
+    return false;
+}
+
+void UploadSpool::DropOldest() {
+    RecordHeader* oldest = file->At(file->Header()->head);
+    if (oldest->state == Pending) {
+        oldest->state = Done;
+        pendingCount--;
+        droppedCount++;
+        LOG_RATE_LIMITED(Warn, 5, 10000, "UploadSpool: full, dropping chunk #" + std::to_string(oldest->sequence) +
+                                         " (" + std::to_string(droppedCount) + " dropped)");
+    }
+    AdvanceHead();
+}
+
+// Move the head past records that are done with, and wrap markers
+void UploadSpool::AdvanceHead() {
+    FileHeader* header = file->Header();
+    while (header->head != header->tail && file->At(header->head)->state != Pending) {
+        header->head = Next(header->head);
+    }
+}
+
+uint64_t UploadSpool::Next(uint64_t offset) const {
+    const RecordHeader* record = file->At(offset);
+    return record->state == Wrap ? DATA_START : offset + RecordSpan(record->size);
+}
+
+uint64_t UploadSpool::FindRecord(uint64_t id) const {
+    if (!file) {
+        return 0;
+    }
+    const FileHeader* header = file->Header();
+    for (uint64_t offset = header->head; offset != header->tail; offset = Next(offset)) {
+        const RecordHeader* record = file->At(offset);
+        if (record->state == Pending && record->id == id) {
+            return offset;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Fixed-size, memory-mapped file of audio chunks waiting to be uploaded,
+// e.g. while the network is down or the service throttles. Records are
+// appended at the tail of a ring and removed from the head once uploaded;
+// when the file is full the oldest records are dropped, so disk use is
+// capped and nothing is held in memory. The head and tail live in the file
+// header and every record carries a checksum, so the records of a process
+// that crashed are picked up by the next Open. Each Open starts a new session
+// and records carry the session that stored them, so a reader can tell audio
+// from an earlier run. Thread safe; one process per file (the file is locked
+// while open).
+class UploadSpool {
+public:
+    struct Record {
+        uint64_t id;                // Assigned by Append; increases across sessions
+        uint64_t session;           // Assigned by Append: the session that stored it
+        uint64_t sequence;          // Upload sequence in the session that captured it
+        int64_t capturedAtMs;       // Wall clock, ms since the epoch
+        double startSeconds;        // Place on that session's input timeline
+        double endSeconds;
+        uint32_t sampleRate;
+        uint32_t attempts;          // Counted by RecordAttempt
+    };
+
+    struct Stats {
+        size_t pending;
+        uint64_t usedBytes;
+        uint64_t capacityBytes;
+        uint64_t appended;          // This session
+        uint64_t dropped;           // Overwritten before they were uploaded
+        uint64_t recovered;         // Found by Open
+    };
+
+    UploadSpool();
+    ~UploadSpool();
+
+    UploadSpool(const UploadSpool&) = delete;
+    UploadSpool& operator=(const UploadSpool&) = delete;
+
+    // Open or create the file. An existing file keeps its records and size;
+    // one that is empty or damaged is recreated at capacityBytes.
+    bool Open(const std::string& path, uint64_t capacityBytes);
+    void Close();
+    bool IsOpen() const;
+
+    // Session started by the last Open; 0 while closed
+    uint64_t GetSession() const;
+
+    // Store a complete audio file; record.id, session and attempts are assigned.
+    // False if the spool is closed or the file too small for the chunk.
+    bool Append(const Record& record, const uint8_t* audio, size_t size);
+
+    // The oldest record, with its audio copied into audio
+    bool PeekOldest(Record& record, std::vector<uint8_t>& audio) const;
+
+    // Count a failed upload of a record; returns its attempts so far
+    uint32_t RecordAttempt(uint64_t id);
+
+    // Forget a record once it is uploaded or given up on
+    void Remove(uint64_t id);
+
+    Stats GetStats() const;
+
+private:
+    class MappedFile;
+
+    mutable std::mutex mutex;
+    std::unique_ptr<MappedFile> file;
+    size_t pendingCount;
+    uint64_t appendedCount;
+    uint64_t droppedCount;
+    uint64_t recoveredCount;
+
+    // Helpers; the caller holds mutex
+    bool Recover();
+    void Reset();
+    void StartSession();
+    bool FindRoom(uint64_t span, uint64_t& offset);
+    void DropOldest();
+    void AdvanceHead();
+    uint64_t Next(uint64_t offset) const;
+    uint64_t FindRecord(uint64_t id) const;     // Offset, 0 if absent
+};
@@ -0,0 +1,245 @@
+#include "UtteranceSegmenter.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+const uint32_t FRAME_MS = 20;
+
+// Per-frame classification for cut decisions: no onset delay or hangover,
+// the segmenter applies its own pause length
+VoiceActivityDetector::Settings FrameDetectorSettings() {
+    VoiceActivityDetector::Settings detectorSettings;
+    detectorSettings.frameMs = FRAME_MS;
+    detectorSettings.onsetFrames = 1;
+    detectorSettings.hangoverMs = 0;
+    return detectorSettings;
+}
+
+} // namespace
+
+UtteranceSegmenter::UtteranceSegmenter(uint32_t sampleRate, size_t headerBytes)
+    : UtteranceSegmenter(sampleRate, headerBytes, Settings())
+{
+}
+
+UtteranceSegmenter::UtteranceSegmenter(uint32_t sampleRate, size_t headerBytes, const Settings& settings)
+    : settings(settings)
+    , sampleRate(sampleRate)
+    , headerBytes(headerBytes)
+    , frameSamples(static_cast<size_t>(sampleRate) * FRAME_MS / 1000)
+    , bufferedSamples(0)
+    , reservedSamples(0)
+    , bufferStartSample(0)
+    , detector(FrameDetectorSettings())
+    , stats()
+{
+    // A hard deadline shorter than the soft limit would make the soft limit unreachable
+    if (this->settings.maxLatencyMs < this->settings.maxUtteranceMs) {
+        this->settings.maxLatencyMs = this->settings.maxUtteranceMs;
+    }
+    buffer.resize(headerBytes);
+}
+
+const char* UtteranceSegmenter::CutReasonName(CutReason reason) {
+    switch (reason) {
+        case CutReason::Pause: return "pause";
+        case CutReason::MaxUtterance: return "max utterance";
+        case CutReason::MaxLatency: return "max latency";
+        default: return "flush";
+    }
+}
+
+const int16_t* UtteranceSegmenter::Samples() const {
+    return reinterpret_cast<const int16_t*>(buffer.data() + headerBytes);
+}
+
+size_t UtteranceSegmenter::MsToFrames(uint32_t ms) const {
+    return ms / FRAME_MS;
+}
+
+int16_t* UtteranceSegmenter::Reserve(size_t maxSamples) {
+    buffer.resize(headerBytes + (bufferedSamples + maxSamples) * sizeof(int16_t));
+    reservedSamples = maxSamples;
+    return reinterpret_cast<int16_t*>(buffer.data() + headerBytes) + bufferedSamples;
+}
+
+void UtteranceSegmenter::Commit(size_t samples) {
+    if (samples > reservedSamples) {
+        samples = reservedSamples;
+    }
+    reservedSamples = 0;
+    bufferedSamples += samples;
+    buffer.resize(headerBytes + bufferedSamples * sizeof(int16_t));
+    stats.samplesIn += samples;
+
+    AnalyzeNewFrames();
+}
+
+bool UtteranceSegmenter::PopSegment(Segment& segment) {
+    if (ready.empty()) {
+        return false;
+    }
+    segment = std::move(ready.front());
+    ready.erase(ready.begin());
+    return true;
+}
+
+void UtteranceSegmenter::AnalyzeNewFrames() {
+    while ((frames.size() + 1) * frameSamples <= bufferedSamples) {
+        const int16_t* frame = Samples() + frames.size() * frameSamples;
+
+        double energy = 0.0;
+        for (size_t i = 0; i < frameSamples; ++i) {
+            energy += static_cast<double>(frame[i]) * frame[i];
+        }
+
+        detector.Process(reinterpret_cast<const uint8_t*>(frame), frameSamples * sizeof(int16_t), sampleRate, 1, 16);
+        frames.push_back({detector.IsSpeechActive(), static_cast<float>(energy / frameSamples)});
+
+        // Decide after every frame so cuts land on the frame where the rule is met
+        Evaluate();
+    }
+}
+
+void UtteranceSegmenter::Evaluate() {
+    size_t padding = MsToFrames(settings.paddingMs);
+
+    size_t first = frames.size();
+    size_t last = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (frames[i].speech) {
+            if (first == frames.size()) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+
+    // No speech yet: keep only the padding that may precede it
+    if (first == frames.size()) {
+        if (frames.size() > padding) {
+            DropFrames(frames.size() - padding);
+        }
+        return;
+    }
+
+    // Trim leading silence so the segment starts at most padding before speech
+    if (first > padding) {
+        size_t drop = first - padding;
+        DropFrames(drop);
+        first -= drop;
+        last -= drop;
+    }
+
+    size_t count = frames.size();
+    size_t trailingSilence = count - 1 - last;
+    size_t speechFrames = last + 1 - first;
+    size_t minFrames = MsToFrames(settings.minUtteranceMs);
+
+    // Natural end of an utterance. A short one is held back in case more
+    // speech follows, unless the silence after it is itself that long.
+    if (trailingSilence >= MsToFrames(settings.pauseMs) &&
+        (speechFrames >= minFrames || trailingSilence >= minFrames)) {
+        Cut(std::min(count, last + 1 + padding), CutReason::Pause);
+        return;
+    }
+
+    // Past the soft limit: cut at the longest gap after the minimum length.
+    // Trailing silence is left to grow into a pause.
+    if (count - first >= MsToFrames(settings.maxUtteranceMs)) {
+        size_t bestStart = 0;
+        size_t bestLength = 0;
+        size_t runStart = 0;
+        bool inRun = false;
+        for (size_t i = first + minFrames; i <= last; ++i) {
+            if (frames[i].speech) {
+                inRun = false;
+                continue;
+            }
+            if (!inRun) {
+                runStart = i;
+                inRun = true;
+            }
+            if (i + 1 - runStart > bestLength) {
+                bestStart = runStart;
+                bestLength = i + 1 - runStart;
+            }
+        }
+        if (bestLength > 0) {
+            Cut(bestStart + std::min(padding, bestLength / 2), CutReason::MaxUtterance);
+            return;
+        }
+    }
+
+    // Hard deadline: no gap at all, cut after the quietest frame (the latest on ties)
+    if (count >= MsToFrames(settings.maxLatencyMs)) {
+        size_t quietest = count - 1;
+        for (size_t i = first + minFrames; i < count; ++i) {
+            if (frames[i].energy <= frames[quietest].energy) {
+                quietest = i;
+            }
+        }
+        Cut(quietest + 1, CutReason::MaxLatency);
+    }
+}
+
+void UtteranceSegmenter::Cut(size_t endFrame, CutReason reason) {
+    size_t endSamples = endFrame * frameSamples;
+
+    Segment segment;
+    segment.startSample = bufferStartSample;
+    segment.endSample = bufferStartSample + endSamples;
+    segment.reason = reason;
+
+    // The segment takes over the buffer; only the remainder after the cut is copied
+    size_t remainder = bufferedSamples - endSamples;
+    std::vector<uint8_t> next;
+    next.reserve(buffer.capacity());
+    next.resize(headerBytes + remainder * sizeof(int16_t));
+    memcpy(next.data() + headerBytes, Samples() + endSamples, remainder * sizeof(int16_t));
+
+    segment.data = std::move(buffer);
+    segment.data.resize(headerBytes + endSamples * sizeof(int16_t));
+    buffer = std::move(next);
+
+    bufferedSamples = remainder;
+    bufferStartSample += endSamples;
+    frames.erase(frames.begin(), frames.begin() + endFrame);
+
+    stats.segments++;
+    stats.samplesOut += endSamples;
+    ready.push_back(std::move(segment));
+}
+
+void UtteranceSegmenter::DropFrames(size_t count) {
+    size_t dropSamples = count * frameSamples;
+    uint8_t* samples = buffer.data() + headerBytes;
+    memmove(samples, samples + dropSamples * sizeof(int16_t), (bufferedSamples - dropSamples) * sizeof(int16_t));
+    bufferedSamples -= dropSamples;
+    buffer.resize(headerBytes + bufferedSamples * sizeof(int16_t));
+
+    bufferStartSample += dropSamples;
+    frames.erase(frames.begin(), frames.begin() + count);
+    stats.samplesTrimmed += dropSamples;
+}
+
+void UtteranceSegmenter::Flush() {
+    size_t last = frames.size();
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (frames[i].speech) {
+            last = i;
+        }
+    }
+    if (last != frames.size()) {
+        Cut(std::min(frames.size(), last + 1 + MsToFrames(settings.paddingMs)), CutReason::Flush);
+    }
+
+    // Everything left is silence or a partial frame
+    stats.samplesTrimmed += bufferedSamples;
+    bufferStartSample += bufferedSamples;
+    bufferedSamples = 0;
+    buffer.resize(headerBytes);
+    frames.clear();
+}
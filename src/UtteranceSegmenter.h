@@ -0,0 +1,94 @@
+#pragma once
+
+#include "VoiceActivityDetector.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Cuts a mono 16-bit stream into utterances for upload. Cuts are made at
+// pauses once an utterance is long enough; past maxUtteranceMs any short gap
+// in the speech will do, and at maxLatencyMs the quietest frame is taken so
+// no audio waits longer than that. Leading and trailing silence beyond a
+// short padding is trimmed and audio with no speech at all is dropped. All
+// positions are counted in samples from the start of the stream.
+class UtteranceSegmenter {
+public:
+    struct Settings {
+        uint32_t minUtteranceMs = 1000;
+        uint32_t maxUtteranceMs = 6000;    // Soft: after this, cut at any gap in the speech
+        uint32_t maxLatencyMs = 10000;     // Hard: cut at the quietest frame, pause or not
+        uint32_t pauseMs = 300;            // Silence that counts as a pause between utterances
+        uint32_t paddingMs = 150;          // Silence kept on each side of the speech
+    };
+
+    enum class CutReason {
+        Pause,
+        MaxUtterance,
+        MaxLatency,
+        Flush
+    };
+
+    struct Segment {
+        uint64_t startSample;              // Stream position of the first sample
+        uint64_t endSample;                // One past the last sample
+        CutReason reason;
+        std::vector<uint8_t> data;         // headerBytes of space, then the PCM samples
+    };
+
+    struct Stats {
+        uint64_t segments;
+        uint64_t samplesIn;
+        uint64_t samplesOut;
+        uint64_t samplesTrimmed;
+    };
+
+    // headerBytes are reserved in front of every segment's samples so the
+    // caller can write a file header in place
+    UtteranceSegmenter(uint32_t sampleRate, size_t headerBytes);
+    UtteranceSegmenter(uint32_t sampleRate, size_t headerBytes, const Settings& settings);
+
+    // Space for up to maxSamples new samples; write them, then Commit the count
+    int16_t* Reserve(size_t maxSamples);
+    void Commit(size_t samples);
+
+    // Next completed segment, if any
+    bool PopSegment(Segment& segment);
+
+    // End of stream: turn whatever speech is buffered into a segment and
+    // discard the rest. Collect it with PopSegment.
+    void Flush();
+
+    static const char* CutReasonName(CutReason reason);
+
+    Stats GetStats() const { return stats; }
+
+private:
+    struct FrameInfo {
+        bool speech;
+        float energy;
+    };
+
+    Settings settings;
+    uint32_t sampleRate;
+    size_t headerBytes;
+    size_t frameSamples;
+
+    std::vector<uint8_t> buffer;           // Header space + buffered samples
+    size_t bufferedSamples;
+    size_t reservedSamples;
+    uint64_t bufferStartSample;            // Stream position of the first buffered sample
+
+    std::vector<FrameInfo> frames;         // One entry per complete frame in the buffer
+    VoiceActivityDetector detector;
+
+    std::vector<Segment> ready;
+    Stats stats;
+
+    const int16_t* Samples() const;
+    size_t MsToFrames(uint32_t ms) const;
+
+    void AnalyzeNewFrames();
+    void Evaluate();
+    void Cut(size_t endFrame, CutReason reason);
+    void DropFrames(size_t count);
+};
@@ -0,0 +1,159 @@
+#include "VoiceActivityDetector.h"
+#include <cmath>
+
+namespace {
+
+const float INITIAL_NOISE_FLOOR_DB = -70.0f;
+const float ENERGY_FLOOR_DB = -100.0f;      // Digital silence is clamped here
+
+// Noise floor tracking per frame: drops quickly, rises slowly, and rises even
+// more slowly during speech so a steady background cannot lock speech on
+const float NOISE_FALL_RATE = 0.2f;
+const float NOISE_RISE_RATE = 0.01f;
+const float NOISE_RISE_RATE_IN_SPEECH = 0.002f;
+
+} // namespace
+
+VoiceActivityDetector::VoiceActivityDetector()
+    : VoiceActivityDetector(Settings())
+{
+}
+
+VoiceActivityDetector::VoiceActivityDetector(const Settings& settings)
+    : settings(settings)
+{
+    Reset();
+}
+
+void VoiceActivityDetector::Reset() {
+    frameSampleRate = 0;
+    frameLength = 0;
+    frameFill = 0;
+    frameEnergy = 0.0;
+    frameCrossings = 0;
+    previousPositive = false;
+
+    noiseFloorDb = INITIAL_NOISE_FLOOR_DB;
+    consecutiveSpeechFrames = 0;
+    hangoverFramesLeft = 0;
+    speechActive = false;
+
+    stats = Stats();
+    stats.noiseFloorDb = noiseFloorDb;
+}
+
+VoiceActivityDetector::Stats VoiceActivityDetector::GetStats() const {
+    Stats result = stats;
+    result.noiseFloorDb = noiseFloorDb;
+    return result;
+}
+
+bool VoiceActivityDetector::Process(const uint8_t* data, size_t bytes, uint32_t sampleRate, uint16_t channels, uint16_t bitsPerSample) {
+    if (channels == 0 || sampleRate == 0 || (bitsPerSample != 32 && bitsPerSample != 16)) {
+        return true;   // Unknown layout: never gate what we cannot analyze
+    }
+
+    // Frame length follows the stream's rate; a rate change starts a new frame
+    if (sampleRate != frameSampleRate) {
+        frameSampleRate = sampleRate;
+        frameLength = static_cast<size_t>(sampleRate) * settings.frameMs / 1000;
+        frameFill = 0;
+        frameEnergy = 0.0;
+        frameCrossings = 0;
+    }
+
+    size_t frameCount = bytes / (static_cast<size_t>(channels) * (bitsPerSample / 8));
+    if (bitsPerSample == 32) {
+        return ProcessSamples(reinterpret_cast<const float*>(data), frameCount, channels, 1.0f);
+    }
+    return ProcessSamples(reinterpret_cast<const int16_t*>(data), frameCount, channels, 1.0f / 32768.0f);
+}
+
+template <typename Sample>
+bool VoiceActivityDetector::ProcessSamples(const Sample* samples, size_t frameCount, uint16_t channels, float scale) {
+    const float gain = scale / channels;
+    bool anyActive = speechActive;
+
+    for (size_t i = 0; i < frameCount; ++i) {
+        const Sample* frame = samples + i * channels;
+        float sum = 0.0f;
+        for (uint16_t c = 0; c < channels; ++c) {
+            sum += static_cast<float>(frame[c]);
+        }
+        AddSample(sum * gain);
+
+        if (frameFill == frameLength) {
+            ClassifyFrame();
+            anyActive = anyActive || speechActive;
+        }
+    }
+
+    return anyActive;
+}
+
+void VoiceActivityDetector::AddSample(float sample) {
+    frameEnergy += static_cast<double>(sample) * sample;
+    bool positive = sample >= 0.0f;
+    if (frameFill > 0 && positive != previousPositive) {
+        frameCrossings++;
+    }
+    previousPositive = positive;
+    frameFill++;
+}
+
+void VoiceActivityDetector::ClassifyFrame() {
+    double meanSquare = frameEnergy / frameLength;
+    float energyDb = meanSquare > 0.0 ? static_cast<float>(10.0 * std::log10(meanSquare)) : ENERGY_FLOOR_DB;
+    if (energyDb < ENERGY_FLOOR_DB) {
+        energyDb = ENERGY_FLOOR_DB;
+    }
+    float zcr = static_cast<float>(frameCrossings) / frameLength;
+
+    frameFill = 0;
+    frameEnergy = 0.0;
+    frameCrossings = 0;
+
+    // Loud frames are speech unless they look like broadband noise; quieter
+    // frames with a fricative-like ZCR only extend a segment already open
+    float threshold = noiseFloorDb + settings.energyMarginDb;
+    if (threshold < settings.minimumEnergyDb) {
+        threshold = settings.minimumEnergyDb;
+    }
+    bool voiced = energyDb > threshold && zcr < settings.noiseZcr;
+    bool unvoiced = speechActive && energyDb > threshold - settings.unvoicedMarginDb &&
+                    zcr >= settings.unvoicedMinimumZcr && zcr < settings.noiseZcr;
+    bool speechFrame = voiced || unvoiced;
+
+    if (energyDb < noiseFloorDb) {
+        noiseFloorDb += NOISE_FALL_RATE * (energyDb - noiseFloorDb);
+    } else {
+        noiseFloorDb += (speechFrame ? NOISE_RISE_RATE_IN_SPEECH : NOISE_RISE_RATE) * (energyDb - noiseFloorDb);
+    }
+
+    // Onset and hangover smoothing
+    uint32_t hangoverFrames = settings.hangoverMs / settings.frameMs;
+    if (speechFrame) {
+        consecutiveSpeechFrames++;
+        if (speechActive || consecutiveSpeechFrames >= settings.onsetFrames) {
+            if (!speechActive) {
+                stats.speechSegments++;
+            }
+            speechActive = true;
+            hangoverFramesLeft = hangoverFrames;
+        }
+    } else {
+        consecutiveSpeechFrames = 0;
+        if (hangoverFramesLeft > 0) {
+            hangoverFramesLeft--;
+        } else {
+            speechActive = false;
+        }
+    }
+
+    stats.framesAnalyzed++;
+    if (speechActive) {
+        stats.speechFrames++;
+    } else {
+        stats.silenceFrames++;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming voice activity detector for capture packets. Audio is cut into
+// short frames; each frame is classified from its energy relative to a
+// tracked noise floor and its zero-crossing rate, and the decision is
+// smoothed with an onset count and a hangover so short pauses inside speech
+// do not end the segment. Cheap enough to run on every packet.
+class VoiceActivityDetector {
+public:
+    struct Settings {
+        uint32_t frameMs = 20;
+        float energyMarginDb = 9.0f;         // Speech must be this far above the noise floor
+        float minimumEnergyDb = -55.0f;      // dBFS; quieter frames are never speech
+        float unvoicedMarginDb = 6.0f;       // Quieter frames still count if their ZCR looks unvoiced
+        float unvoicedMinimumZcr = 0.15f;    // Fricatives cross zero often...
+        float noiseZcr = 0.45f;              // ...but broadband noise crosses even more
+        uint32_t onsetFrames = 2;            // Consecutive speech frames needed to start a segment
+        uint32_t hangoverMs = 400;           // Keep the segment open this long after the last speech frame
+    };
+
+    struct Stats {
+        uint64_t framesAnalyzed;
+        uint64_t speechFrames;
+        uint64_t silenceFrames;
+        uint64_t speechSegments;
+        float noiseFloorDb;
+    };
+
+    VoiceActivityDetector();
+    explicit VoiceActivityDetector(const Settings& settings);
+
+    // Analyze one interleaved packet (32-bit float or 16-bit PCM). Returns
+    // true if speech was active at any point in the packet.
+    bool Process(const uint8_t* data, size_t bytes, uint32_t sampleRate, uint16_t channels, uint16_t bitsPerSample);
+
+    bool IsSpeechActive() const { return speechActive; }
+
+    // Forget the noise floor and any open segment
+    void Reset();
+
+    Stats GetStats() const;
+
+private:
+    Settings settings;
+
+    // Partial frame carried between packets
+    uint32_t frameSampleRate;
+    size_t frameLength;
+    size_t frameFill;
+    double frameEnergy;
+    uint32_t frameCrossings;
+    bool previousPositive;
+
+    // Decision state
+    float noiseFloorDb;
+    uint32_t consecutiveSpeechFrames;
+    uint32_t hangoverFramesLeft;
+    bool speechActive;
+
+    Stats stats;
+
+    template <typename Sample>
+    bool ProcessSamples(const Sample* samples, size_t frameCount, uint16_t channels, float scale);
+
+    void AddSample(float sample);
+    void ClassifyFrame();
+};
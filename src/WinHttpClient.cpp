@@ -0,0 +1,237 @@
+#include "WinHttpClient.h"
+#include "CancellationToken.h"
+#include "SimpleLogger.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <vector>
+
+#pragma comment(lib, "winhttp.lib")
+
+namespace {
+
+// WinHTTP timeout for one phase: the configured limit, but no later than the
+// deadline. 0 waits forever, as it does for WinHttpSetTimeouts.
+int PhaseTimeout(std::chrono::milliseconds timeout, std::chrono::steady_clock::time_point deadline) {
+    int64_t milliseconds = timeout.count();
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        remaining = std::max<int64_t>(remaining, 1);
+        milliseconds = milliseconds > 0 ? std::min(milliseconds, remaining) : remaining;
+    }
+    return static_cast<int>(std::min<int64_t>(milliseconds, INT_MAX));
+}
+
+} // namespace
+
+WinHttpClient::WinHttpClient(size_t maxConnectionsPerHost)
+    : hSession(nullptr)
+    , requestsSent(0)
+    , connectionsOpened(0)
+    , connectionsReused(0)
+{
+    hSession = WinHttpOpen(L"TeamsTranscriptionApp/1.0",
+                           WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                           WINHTTP_NO_PROXY_NAME,
+                           WINHTTP_NO_PROXY_BYPASS,
+                           0);
+    if (!hSession) {
+        throw std::runtime_error("Failed to initialize WinHTTP session");
+    }
+
+    // Enough connections for every concurrent upload to the same host
+    DWORD maxConnections = static_cast<DWORD>(maxConnectionsPerHost);
+    WinHttpSetOption(hSession, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &maxConnections, sizeof(maxConnections));
+}
+
+WinHttpClient::~WinHttpClient() {
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    for (auto& connection : connections) {
+        WinHttpCloseHandle(connection.second);
+    }
+    connections.clear();
+
+    if (hSession) {
+        WinHttpCloseHandle(hSession);
+        hSession = nullptr;
+    }
+}
+
+HttpClient::Stats WinHttpClient::GetStats() const {
+    Stats stats;
+    stats.requestsSent = requestsSent.load();
+    stats.connectionsOpened = connectionsOpened.load();
+    stats.connectionsReused = connectionsReused.load();
+    return stats;
+}
+
+// WinHttpWriteData returns once the body is in the send buffer, and nothing
+// reports when the server has it
+bool WinHttpClient::CanTimeUploads() const {
+    return false;
+}
+
+HINTERNET WinHttpClient::GetConnection(const HttpUrl& url) {
+    std::lock_guard<std::mutex> lock(connectionMutex);
+
+    auto it = connections.find(url.HostKey());
+    if (it != connections.end()) {
+        connectionsReused++;
+        return it->second;
+    }
+
+    std::wstring host(url.host.begin(), url.host.end());
+    HINTERNET hConnect = WinHttpConnect(hSession, host.c_str(), url.port, 0);
+    if (!hConnect) {
+        throw std::runtime_error("Failed to connect to " + url.HostKey());
+    }
+
+    connections[url.HostKey()] = hConnect;
+    connectionsOpened++;
+    DEBUG_LOG("WinHttpClient - opened connection to " + url.HostKey());
+    return hConnect;
+}
+
+HttpResponse WinHttpClient::Send(const HttpRequest& request) {
+    HttpUrl url;
+    if (!HttpUrl::Parse(request.url, url)) {
+        throw std::runtime_error("Invalid URL: " + request.url);
+    }
+
+    HINTERNET hConnect = GetConnection(url);
+
+    // Only the request handle is per call; session and connection stay open
+    std::wstring method(request.method.begin(), request.method.end());
+    std::wstring path(url.path.begin(), url.path.end());
+    DWORD flags = url.IsSecure() ? WINHTTP_FLAG_SECURE : 0;
+    HINTERNET hRequest = WinHttpOpenRequest(hConnect, method.c_str(), path.c_str(),
+                                            NULL, WINHTTP_NO_REFERER,
+                                            WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
+    if (!hRequest) {
+        throw std::runtime_error("Failed to create HTTP request");
+    }
+
+    // Whoever takes the handle first closes it: this thread when done, or the canceller
+    std::atomic<HINTERNET> requestHandle(hRequest);
+    auto closeRequest = [&requestHandle]() {
+        HINTERNET handle = requestHandle.exchange(nullptr);
+        if (handle) {
+            WinHttpCloseHandle(handle);
+        }
+    };
+    auto fail = [&](const std::string& message) {
+        bool cancelled = request.cancel && request.cancel->IsCancelled();
+        DWORD error = GetLastError();
+        closeRequest();
+        if (cancelled) {
+            throw std::runtime_error("HTTP request to " + url.HostKey() + " cancelled");
+        }
+        if (error == ERROR_WINHTTP_TIMEOUT) {
+            throw std::runtime_error(message + ": timed out");
+        }
+        throw std::runtime_error(message);
+    };
+
+    // Resolution shares the connect limit
+    int connectTimeout = PhaseTimeout(request.connectTimeout, request.deadline);
+    WinHttpSetTimeouts(hRequest, connectTimeout, connectTimeout,
+                       PhaseTimeout(request.sendTimeout, request.deadline),
+                       PhaseTimeout(request.receiveTimeout, request.deadline));
+
+    for (const auto& header : request.headers) {
+        std::string line = header.first + ": " + header.second;
+        std::wstring lineW(line.begin(), line.end());
+        if (!WinHttpAddRequestHeaders(hRequest, lineW.c_str(), (DWORD)-1, WINHTTP_ADDREQ_FLAG_ADD | WINHTTP_ADDREQ_FLAG_REPLACE)) {
+            fail("Failed to set HTTP headers");
+        }
+    }
+
+    CancellationToken::Registration cancelRegistration(request.cancel, closeRequest);
+
+    // Headers go out with the total length, then each body span as it is
+    requestsSent++;
+    auto sendStartedAt = std::chrono::steady_clock::now();
+    if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0, WINHTTP_NO_REQUEST_DATA, 0,
+                            static_cast<DWORD>(request.BodySize()), 0)) {
+        fail("Failed to send HTTP request");
+    }
+    for (const HttpBodySpan& span : request.body) {
+        DWORD written = 0;
+        if (span.size > 0 &&
+            !WinHttpWriteData(hRequest, span.data, static_cast<DWORD>(span.size), &written)) {
+            fail("Failed to send HTTP request body");
+        }
+    }
+
+    if (!WinHttpReceiveResponse(hRequest, NULL)) {
+        fail("Failed to receive HTTP response");
+    }
+
+    HttpResponse response;
+    response.sendStartedAt = sendStartedAt;
+    response.firstByteAt = std::chrono::steady_clock::now();
+    DWORD statusCode = 0;
+    DWORD statusCodeSize = sizeof(statusCode);
+    WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                        NULL, &statusCode, &statusCodeSize, NULL);
+    response.statusCode = static_cast<int>(statusCode);
+    ReadResponseHeaders(hRequest, response);
+
+    // Read response body
+    DWORD bytesAvailable = 0;
+    std::vector<char> buffer;
+    while (true) {
+        if (!WinHttpQueryDataAvailable(hRequest, &bytesAvailable)) {
+            fail("Failed to read HTTP response");
+        }
+        if (bytesAvailable == 0) {
+            break;
+        }
+        buffer.resize(bytesAvailable);
+        DWORD bytesRead = 0;
+        if (!WinHttpReadData(hRequest, buffer.data(), bytesAvailable, &bytesRead)) {
+            fail("Failed to read HTTP response");
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        response.body.append(buffer.data(), bytesRead);
+    }
+
+    // The body is complete even if a cancel lands now
+    closeRequest();
+    return response;
+}
+
+void WinHttpClient::ReadResponseHeaders(HINTERNET hRequest, HttpResponse& response) {
+    DWORD size = 0;
+    WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                        WINHTTP_NO_OUTPUT_BUFFER, &size, WINHTTP_NO_HEADER_INDEX);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || size == 0) {
+        return;
+    }
+
+    std::wstring raw(size / sizeof(wchar_t), L'\0');
+    if (!WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                             &raw[0], &size, WINHTTP_NO_HEADER_INDEX)) {
+        return;
+    }
+    raw.resize(size / sizeof(wchar_t));
+
+    // First line is the status line; the rest are "Name: value" pairs
+    size_t lineStart = raw.find(L"\r\n");
+    while (lineStart != std::wstring::npos) {
+        lineStart += 2;
+        size_t lineEnd = raw.find(L"\r\n", lineStart);
+        std::wstring line = raw.substr(lineStart, lineEnd == std::wstring::npos ? std::wstring::npos : lineEnd - lineStart);
+        size_t colon = line.find(L':');
+        if (colon != std::wstring::npos) {
+            std::wstring name = line.substr(0, colon);
+            size_t valueStart = line.find_first_not_of(L' ', colon + 1);
+            std::wstring value = valueStart == std::wstring::npos ? L"" : line.substr(valueStart);
+            response.headers.emplace_back(std::string(name.begin(), name.end()), std::string(value.begin(), value.end()));
+        }
+        lineStart = lineEnd;
+    }
+}
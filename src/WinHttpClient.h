@@ -0,0 +1,36 @@
+#pragma once
+
+#include "HttpClient.h"
+#include <windows.h>
+#include <winhttp.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+// WinHTTP backend. One session handle lives for the lifetime of the client and
+// one connect handle is kept per host:port, so WinHTTP can keep the underlying
+// TCP/TLS connections alive and reuse them across requests. Request timeouts
+// are set per request handle, capped by the time left before the deadline;
+// cancelling closes the handle, which aborts the blocked WinHTTP call.
+class WinHttpClient : public HttpClient {
+public:
+    explicit WinHttpClient(size_t maxConnectionsPerHost = 4);
+    ~WinHttpClient() override;
+
+    HttpResponse Send(const HttpRequest& request) override;
+    Stats GetStats() const override;
+    bool CanTimeUploads() const override;
+
+private:
+    HINTERNET hSession;
+    std::mutex connectionMutex;
+    std::map<std::string, HINTERNET> connections;
+
+    std::atomic<uint64_t> requestsSent;
+    std::atomic<uint64_t> connectionsOpened;
+    std::atomic<uint64_t> connectionsReused;
+
+    HINTERNET GetConnection(const HttpUrl& url);
+    static void ReadResponseHeaders(HINTERNET hRequest, HttpResponse& response);
+};